@@ -0,0 +1,316 @@
+#include "menu_dirlist.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DIRLIST_KEY		2			//Name characters in record
+#define DIRLIST_SHARE	(MENU_DIRLIST_NAMES/MENU_DIRLIST_ENTRIES)	//Arena bytes for one name, longer names are cut
+#define DIRLIST_SKIP	32		//Entries which are read to get to next wanted one instead of f_seekdir
+
+#if MENU_DIRLIST_RECORDS > 0xFFFF || DIRLIST_SHARE < 2 || MENU_DIRLIST_NAMES > 0xFFFF
+#error Wrong MENU_DIRLIST_RECORDS, MENU_DIRLIST_NAMES or MENU_DIRLIST_ENTRIES
+#endif
+
+typedef struct dirlist_record{
+	uint16_t index;						//Directory entry index, f_seekdir to it and f_readdir reads the entry
+	uint8_t key[DIRLIST_KEY];	//Name characters (upper case) at key offset of its tie group, 0 after end of name
+}dirlist_record;
+
+//Member of tie group while group is sorted by names
+typedef struct dirlist_member{
+	dirlist_record record;
+	uint16_t name;						//Offset in name arena
+}dirlist_member;
+
+static DIR dirlist_dir;
+static uint8_t dirlist_opened = 0;
+static uint8_t dirlist_flags;
+static menu_dirlist_filter dirlist_filter;
+static dirlist_record dirlist_records[MENU_DIRLIST_RECORDS];	//In list order, same keys in order of index
+static uint8_t dirlist_starts[(MENU_DIRLIST_RECORDS + 7)/8];	//Bit is set if record starts tie group
+static uint16_t dirlist_total;
+static uint16_t dirlist_dirs;				//Directories are first dirlist_dirs records with MENU_DIRLIST_DIRS_FIRST
+static menu_dirlist_entry dirlist_entries[MENU_DIRLIST_ENTRIES];	//Last page
+static dirlist_member dirlist_members[MENU_DIRLIST_ENTRIES];
+static char dirlist_names[MENU_DIRLIST_NAMES];
+static uint32_t dirlist_page_first;
+static uint16_t dirlist_page_got = 0;
+#if _USE_LFN
+static char dirlist_lfn[_MAX_LFN + 1];
+#endif
+
+static char dirlist_upper(char c){
+	return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+
+//<0 if a is before b in list (same kind of entry)
+static int dirlist_compare(const char* a, const char* b){
+	char ca, cb;
+	while(1){
+		ca = dirlist_upper(*a++);
+		cb = dirlist_upper(*b++);
+		if(ca != cb || ca == 0) return (int)(uint8_t)ca - (int)(uint8_t)cb;
+	}
+}
+
+static int dirlist_key_order(const void* a, const void* b){
+	const dirlist_record* ra = (const dirlist_record*)a;
+	const dirlist_record* rb = (const dirlist_record*)b;
+	int order = memcmp(ra->key, rb->key, DIRLIST_KEY);
+	return order ? order : (int)ra->index - (int)rb->index;
+}
+
+static int dirlist_index_order(const void* a, const void* b){
+	return (int)((const dirlist_record*)a)->index - (int)((const dirlist_record*)b)->index;
+}
+
+static int dirlist_member_index_order(const void* a, const void* b){
+	return (int)((const dirlist_member*)a)->record.index - (int)((const dirlist_member*)b)->record.index;
+}
+
+static int dirlist_name_order(const void* a, const void* b){
+	const dirlist_member* ma = (const dirlist_member*)a;
+	const dirlist_member* mb = (const dirlist_member*)b;
+	int order = dirlist_compare(dirlist_names + ma->name, dirlist_names + mb->name);
+	return order ? order : (int)ma->record.index - (int)mb->record.index;
+}
+
+static uint8_t dirlist_is_start(uint16_t i){
+	return (dirlist_starts[i >> 3] >> (i & 7)) & 1;
+}
+
+static void dirlist_set_start(uint16_t i, uint8_t start){
+	if(start) dirlist_starts[i >> 3] |= 1 << (i & 7);
+	else dirlist_starts[i >> 3] &= ~(1 << (i & 7));
+}
+
+static void dirlist_set_key(dirlist_record* record, const char* name, uint16_t offset){
+	uint8_t i;
+	for(; offset > 0 && *name; offset--) name++;
+	for(i = 0; i < DIRLIST_KEY; i++){
+		record->key[i] = (offset == 0) ? (uint8_t)dirlist_upper(*name) : 0;
+		if(*name) name++;
+		else offset = 1;		//After end of name
+	}
+}
+
+static uint8_t dirlist_accept(FILINFO* info){
+	if(info->fname[0] == '.') return 0;
+	if(!(dirlist_flags & MENU_DIRLIST_HIDDEN) && (info->fattrib & (AM_HID | AM_SYS))) return 0;
+	return dirlist_filter == NULL || dirlist_filter(info);
+}
+
+//Next entry of directory, *name is NULL at end. *index is where reading started, f_seekdir to it reads this entry again
+static FRESULT dirlist_next(FILINFO* info, const char** name, uint16_t* index){
+	FRESULT result;
+#if _USE_LFN
+	info->lfname = dirlist_lfn;
+	info->lfsize = sizeof(dirlist_lfn);
+#endif
+	*name = NULL;
+	*index = dirlist_dir.index;
+	result = f_readdir(&dirlist_dir, info);
+	if(result != FR_OK || info->fname[0] == 0) return result;
+#if _USE_LFN
+	*name = dirlist_lfn[0] ? dirlist_lfn : info->fname;
+#else
+	*name = info->fname;
+#endif
+	return FR_OK;
+}
+
+//Entry of record with index, *name is NULL if it is not there any more (directory was changed).
+//Near entries after last read one are read in sequence, otherwise directory is seeked.
+static FRESULT dirlist_fetch(uint16_t index, FILINFO* info, const char** name){
+	FRESULT result = FR_OK;
+	uint16_t at;
+	*name = NULL;
+	if(dirlist_dir.sect == 0 || index < dirlist_dir.index || index - dirlist_dir.index > DIRLIST_SKIP){
+		result = f_seekdir(&dirlist_dir, index);
+	}
+	while(result == FR_OK){
+		result = dirlist_next(info, name, &at);
+		if(*name == NULL || at >= index) break;
+	}
+	if(result != FR_OK || at != index) *name = NULL;
+	return result;
+}
+
+//Tie groups start where key changes
+static void dirlist_mark(uint16_t first, uint16_t count){
+	uint16_t i;
+	dirlist_set_start(first, 1);
+	for(i = first + 1; i < first + count; i++){
+		dirlist_set_start(i, memcmp(dirlist_records[i].key, dirlist_records[i - 1].key, DIRLIST_KEY) != 0);
+	}
+}
+
+//Keys of records are set to name characters at offset, their entries are read in order of index
+static FRESULT dirlist_rekey(uint16_t first, uint16_t count, uint16_t offset){
+	FRESULT result = FR_OK;
+	FILINFO info;
+	const char* name;
+	uint16_t i;
+	qsort(dirlist_records + first, count, sizeof(dirlist_record), dirlist_index_order);
+	for(i = first; i < first + count && result == FR_OK; i++){
+		result = dirlist_fetch(dirlist_records[i].index, &info, &name);
+		if(name != NULL) dirlist_set_key(&dirlist_records[i], name, offset);
+	}
+	qsort(dirlist_records + first, count, sizeof(dirlist_record), dirlist_key_order);
+	return result;
+}
+
+//Records are sorted by keys, tie groups bigger than page buffer by next characters of names
+static FRESULT dirlist_sort(uint16_t first, uint16_t count, uint16_t offset){
+	FRESULT result;
+	uint16_t i, end = first + count, group;
+	if(count == 0) return FR_OK;
+	if(offset == 0) qsort(dirlist_records + first, count, sizeof(dirlist_record), dirlist_key_order);
+	dirlist_mark(first, count);
+	if(offset + DIRLIST_KEY >= DIRLIST_SHARE - 1) return FR_OK;	//Names are compared only up to here
+	for(i = first; i < end; i = group){
+		for(group = i + 1; group < end && !dirlist_is_start(group); group++);
+		if(group - i > MENU_DIRLIST_ENTRIES){
+			result = dirlist_rekey(i, group - i, offset + DIRLIST_KEY);
+			if(result == FR_OK) result = dirlist_sort(i, group - i, offset + DIRLIST_KEY);
+			if(result != FR_OK) return result;
+		}
+	}
+	return FR_OK;
+}
+
+//Copy name to arena slot, cut to slot size
+static uint16_t dirlist_store(uint16_t slot, const char* name){
+	uint16_t offset = slot*DIRLIST_SHARE;
+	strncpy(dirlist_names + offset, name, DIRLIST_SHARE - 1);
+	dirlist_names[offset + DIRLIST_SHARE - 1] = 0;
+	return offset;
+}
+
+//Tie group is put in order of names, then each record is its own group.
+//Group bigger than page buffer (long names with same start) stays in order of index.
+static FRESULT dirlist_resolve(uint16_t first, uint16_t count){
+	FRESULT result = FR_OK;
+	FILINFO info;
+	const char* name;
+	uint16_t i;
+	if(count < 2 || count > MENU_DIRLIST_ENTRIES) return FR_OK;
+	for(i = 0; i < count && result == FR_OK; i++){	//Group is in order of index
+		dirlist_members[i].record = dirlist_records[first + i];
+		result = dirlist_fetch(dirlist_records[first + i].index, &info, &name);
+		dirlist_members[i].name = dirlist_store(i, name != NULL ? name : "");
+	}
+	if(result != FR_OK) return result;
+	qsort(dirlist_members, count, sizeof(dirlist_member), dirlist_name_order);
+	for(i = 0; i < count; i++){
+		dirlist_records[first + i] = dirlist_members[i].record;
+		dirlist_set_start(first + i, 1);
+	}
+	return FR_OK;
+}
+
+FRESULT menu_dirlist_open(const char* path, uint8_t flags, menu_dirlist_filter filter){
+	FRESULT result;
+	FILINFO info;
+	const char* name;
+	uint16_t index, files = 0;
+	dirlist_record* record;
+
+	if(dirlist_opened) menu_dirlist_close();
+	result = f_opendir(&dirlist_dir, path);
+	if(result != FR_OK) return result;
+	dirlist_flags = flags;
+	dirlist_filter = filter;
+	dirlist_opened = 1;
+	dirlist_dirs = 0;
+	dirlist_page_got = 0;
+
+	//Directories from start of records, files from end
+	while(1){
+		result = dirlist_next(&info, &name, &index);
+		if(result != FR_OK || name == NULL) break;
+		if(!dirlist_accept(&info) || dirlist_dirs + files == MENU_DIRLIST_RECORDS) continue;
+		if((flags & MENU_DIRLIST_DIRS_FIRST) && (info.fattrib & AM_DIR)) record = &dirlist_records[dirlist_dirs++];
+		else record = &dirlist_records[MENU_DIRLIST_RECORDS - 1 - files++];
+		record->index = index;
+		dirlist_set_key(record, name, 0);
+	}
+	memmove(dirlist_records + dirlist_dirs, dirlist_records + MENU_DIRLIST_RECORDS - files, files*sizeof(dirlist_record));
+	dirlist_total = dirlist_dirs + files;
+
+	if(result == FR_OK) result = dirlist_sort(0, dirlist_dirs, 0);
+	if(result == FR_OK) result = dirlist_sort(dirlist_dirs, files, 0);
+	if(result != FR_OK) menu_dirlist_close();
+	return result;
+}
+
+void menu_dirlist_close(){
+	if(!dirlist_opened) return;
+	f_closedir(&dirlist_dir);
+	dirlist_opened = 0;
+	dirlist_total = 0;
+	dirlist_page_got = 0;
+}
+
+uint32_t menu_dirlist_count(){
+	return dirlist_total;
+}
+
+FRESULT menu_dirlist_page(uint32_t first, uint16_t count, menu_dirlist_entry** page, uint16_t* got){
+	FRESULT result = FR_OK;
+	FILINFO info;
+	const char* name;
+	uint16_t i, group, end;
+
+	*page = dirlist_entries;
+	*got = 0;
+	if(!dirlist_opened) return FR_INVALID_OBJECT;
+	if(count > MENU_DIRLIST_ENTRIES) count = MENU_DIRLIST_ENTRIES;
+	if(first >= dirlist_total) return FR_OK;
+	if(count > dirlist_total - first) count = dirlist_total - first;
+	if(first == dirlist_page_first && count == dirlist_page_got){
+		*got = count;
+		return FR_OK;
+	}
+	end = first + count;
+
+	//Tie groups on page are put in order of names
+	for(i = first; !dirlist_is_start(i); i--);
+	while(result == FR_OK && i < end){
+		for(group = i + 1; group < dirlist_total && !dirlist_is_start(group); group++);
+		result = dirlist_resolve(i, group - i);
+		i = group;
+	}
+
+	//Entries are read in order of index, near ones without seek
+	for(i = 0; i < count; i++){
+		dirlist_members[i].record = dirlist_records[first + i];
+		dirlist_members[i].name = i;	//Position on page
+	}
+	qsort(dirlist_members, count, sizeof(dirlist_member), dirlist_member_index_order);
+	dirlist_page_got = 0;
+	*got = count;
+	for(i = 0; i < count && result == FR_OK; i++){
+		result = dirlist_fetch(dirlist_members[i].record.index, &info, &name);
+		group = dirlist_members[i].name;
+		if(name == NULL){	//Directory was changed, page ends before missing entry
+			if(group < *got) *got = group;
+			continue;
+		}
+		dirlist_entries[group].name = dirlist_store(group, name);
+		dirlist_entries[group].size = info.fsize;
+		dirlist_entries[group].attrib = info.fattrib;
+	}
+	if(result != FR_OK){
+		*got = 0;
+		return result;
+	}
+	if(*got == count){
+		dirlist_page_first = first;
+		dirlist_page_got = count;
+	}
+	return FR_OK;
+}
+
+const char* menu_dirlist_name(const menu_dirlist_entry* entry){
+	return dirlist_names + entry->name;
+}
@@ -0,0 +1,47 @@
+#ifndef MENU_DIRLIST_H
+#define MENU_DIRLIST_H
+
+#include <stdint.h>
+#include "ff.h"
+
+//Sorted directory listing for file browsers.
+//Directory is read once when it is opened. Each entry is kept as a compact record: its directory entry
+//index and first characters of its name (sort key), MENU_DIRLIST_RECORDS records take 4 bytes each.
+//Records are sorted by key. Entries with same key (tie group) are put in order of full names only when
+//a page needs them, by reading names of group members. Groups bigger than page buffer are split by next
+//characters of names when directory is opened (one read of their entries per 2 characters).
+//Page reads only its entries (f_seekdir to their index), scrolling does not read whole directory again.
+//
+//Directory with more than MENU_DIRLIST_RECORDS entries lists first MENU_DIRLIST_RECORDS of them.
+//Order: directories first with MENU_DIRLIST_DIRS_FIRST, then name, case is ignored. With LFN names
+//are compared by first MENU_DIRLIST_NAMES/MENU_DIRLIST_ENTRIES - 1 characters when keys are same.
+//"." and ".." are not listed. Volume must stay mounted while list is open.
+//Only one list can be open, it is used by menu task only.
+
+#define MENU_DIRLIST_RECORDS		5120	//Entries in directory, less than 65536
+#define MENU_DIRLIST_ENTRIES		128		//Entries in one page or tie group which is sorted by full names
+#define MENU_DIRLIST_NAMES			(MENU_DIRLIST_ENTRIES*13)	//Name arena, 8.3 name takes up to 13 bytes
+
+#define MENU_DIRLIST_DIRS_FIRST	0x01
+#define MENU_DIRLIST_HIDDEN			0x02	//List hidden and system entries too
+
+typedef struct menu_dirlist_entry{
+	uint32_t size;
+	uint16_t name;		//Offset in name arena, use menu_dirlist_name
+	uint8_t attrib;
+}menu_dirlist_entry;
+
+//Returns 1 if entry is listed
+typedef uint8_t (*menu_dirlist_filter)(const FILINFO* info);
+
+//Reads directory and sorts its records, filter can be NULL
+FRESULT menu_dirlist_open(const char* path, uint8_t flags, menu_dirlist_filter filter);
+void menu_dirlist_close();
+//Listed entries in directory
+uint32_t menu_dirlist_count();
+//Entries first...first+count-1 of sorted list (count up to MENU_DIRLIST_ENTRIES), reads only these entries.
+//*page points to them until next call, *got is less than count at end of list or if directory was changed
+FRESULT menu_dirlist_page(uint32_t first, uint16_t count, menu_dirlist_entry** page, uint16_t* got);
+const char* menu_dirlist_name(const menu_dirlist_entry* entry);
+
+#endif
@@ -1,11 +1,16 @@
 #include "menu_display.h"
 #include "tm_stm32f4_fonts.h"	
 #include "tm_stm32f4_ili9341.h"
+#include "menu_system.h"
+#include "menu_profile.h"
 
-
+static menu_display_clip clip_stack[MENU_DISPLAY_CLIP_DEPTH];
+static uint8_t clip_depth = 0;
+static uint16_t scroll_top = 0, scroll_height = MENU_HEIGHT, scroll_line = 0;
 
 void menu_display_init(){
 	TM_ILI9341_Init();	//provided by programmer
+	clip_depth = 0;
 }
 
 //////////////////////provided by programmer
@@ -34,9 +39,108 @@ void menu_display_draw_line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 }
 
 void menu_display_fill(uint32_t color){
+	uint32_t start = menu_profile_start();
 	TM_ILI9341_Fill(color);
+	menu_profile_stop(MENU_PROFILE_LCD_FILL, start);
 }
 
 void menu_display_puts(uint16_t x, uint16_t y, char* c, TM_FontDef_t *font, uint32_t foreground, uint32_t background){
 	TM_ILI9341_Puts(x, y, c, font, foreground, background);
-}
\ No newline at end of file
+}
+
+void menu_display_putc(uint16_t x, uint16_t y, char c, TM_FontDef_t *font, uint32_t foreground, uint32_t background){
+	TM_ILI9341_Putc(x, y, c, font, foreground, background);
+}
+
+void menu_display_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2){
+	TM_ILI9341_SetWindow(x1, y1, x2, y2);
+}
+
+void menu_display_write(uint8_t* data, uint32_t count){
+	TM_ILI9341_WriteData(data, count);
+}
+
+void menu_display_write_async(uint8_t* data, uint16_t count){
+	TM_ILI9341_WriteDataDMA(data, count);
+}
+
+void menu_display_wait(){
+	TM_ILI9341_WaitDMA();
+}
+
+void menu_display_read(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t* data){
+	TM_ILI9341_ReadArea(x1, y1, x2, y2, data);
+}
+
+void menu_display_scroll_area(uint16_t top, uint16_t height, uint16_t bottom){
+	TM_ILI9341_SetScrollArea(top, height, bottom);
+	scroll_top = top;
+	scroll_height = height;
+}
+
+void menu_display_scroll(uint16_t line){
+	TM_ILI9341_Scroll(line);
+	scroll_line = line;
+}
+
+void menu_display_get_scroll(uint16_t* top, uint16_t* height, uint16_t* line){
+	*top = scroll_top;
+	*height = scroll_height;
+	*line = scroll_line;
+}
+
+void menu_display_on_damage(void (*callback)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)){
+	TM_ILI9341_SetDamageCallback(callback);
+}
+
+static void menu_display_set_clip(){
+	menu_display_clip* clip;
+	if(clip_depth == 0){
+		TM_ILI9341_ResetClip();
+		return;
+	}
+	clip = &clip_stack[clip_depth - 1];
+	TM_ILI9341_SetClip(clip->x1, clip->y1, clip->x2, clip->y2);
+}
+
+uint8_t menu_display_push_clip(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2){
+	menu_display_clip* clip;
+	menu_display_clip parent;
+	if(clip_depth == MENU_DISPLAY_CLIP_DEPTH) return 0;
+	menu_display_get_clip(&parent);
+	clip = &clip_stack[clip_depth++];
+	//Intersection with parent
+	clip->x1 = (x1 > parent.x1) ? x1 : parent.x1;
+	clip->y1 = (y1 > parent.y1) ? y1 : parent.y1;
+	clip->x2 = (x2 < parent.x2) ? x2 : parent.x2;
+	clip->y2 = (y2 < parent.y2) ? y2 : parent.y2;
+	if(clip->x1 > clip->x2 || clip->y1 > clip->y2 || parent.x1 > parent.x2){	//Nothing visible
+		clip->x1 = clip->y1 = 1;
+		clip->x2 = clip->y2 = 0;
+	}
+	menu_display_set_clip();
+	return 1;
+}
+
+void menu_display_pop_clip(){
+	if(clip_depth > 0) clip_depth--;
+	menu_display_set_clip();
+}
+
+void menu_display_reset_clip(){
+	clip_depth = 0;
+	menu_display_set_clip();
+}
+
+void menu_display_get_clip(menu_display_clip* clip){
+	TM_ILI9341_Clip_t current;
+	TM_ILI9341_GetClip(&current);
+	clip->x1 = current.x1;
+	clip->y1 = current.y1;
+	clip->x2 = current.x2;
+	clip->y2 = current.y2;
+}
+
+uint8_t menu_display_visible(int16_t x1, int16_t y1, int16_t x2, int16_t y2){
+	return TM_ILI9341_ClipVisible(x1, y1, x2, y2);
+}
@@ -38,4 +38,38 @@ void menu_display_draw_filled_circle(uint16_t x, uint16_t y, uint16_t r, uint16_
 void menu_display_draw_line(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);
 void menu_display_fill(uint32_t color);
 void menu_display_puts(uint16_t x, uint16_t y, char* c, TM_FontDef_t *font, uint32_t foreground, uint32_t background);
+void menu_display_putc(uint16_t x, uint16_t y, char c, TM_FontDef_t *font, uint32_t foreground, uint32_t background);
+
+//Pixel streams: set window once, then send pixels (2 bytes per pixel, high byte first)
+void menu_display_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+void menu_display_write(uint8_t* data, uint32_t count);
+void menu_display_write_async(uint8_t* data, uint16_t count);	//Returns before data is sent
+void menu_display_wait();
+void menu_display_read(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t* data);	//Same format as write
+
+//Hardware vertical scrolling, line is display memory line shown on top of scrolling area
+void menu_display_scroll_area(uint16_t top, uint16_t height, uint16_t bottom);
+void menu_display_scroll(uint16_t line);
+void menu_display_get_scroll(uint16_t* top, uint16_t* height, uint16_t* line);
+
+//Callback gets every window which is drawn (display memory coordinates), NULL to disable
+void menu_display_on_damage(void (*callback)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2));
+
+//Clip stack: every drawing function draws only inside clip on top of stack.
+//New clip is intersected with previous one, so nested widgets cannot draw outside of parent.
+//Pixel streams (menu_display_window/write) are not clipped, caller has to use menu_display_get_clip.
+#define MENU_DISPLAY_CLIP_DEPTH	8
+
+typedef struct{
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;	//Inclusive, x2 < x1 means empty clip
+	uint16_t y2;
+}menu_display_clip;
+
+uint8_t menu_display_push_clip(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);	//Returns 0 if stack is full
+void menu_display_pop_clip();
+void menu_display_reset_clip();	//Empty stack, whole screen
+void menu_display_get_clip(menu_display_clip* clip);
+uint8_t menu_display_visible(int16_t x1, int16_t y1, int16_t x2, int16_t y2);	//Returns 0 if rectangle is outside clip
 #endif
\ No newline at end of file
@@ -1,8 +1,96 @@
 #include "menu_event.h"
+#include "menu_remote.h"
+#include <stddef.h>
 
 char menu_event_key;
 char menu_key_read = 0;
 
+//Queued keys (remote control), next one is taken when current is read or nobody wants it
+static volatile char key_queue[MENU_EVENT_QUEUE];
+static volatile uint8_t key_head = 0;
+static volatile uint8_t key_tail = 0;
+static uint8_t key_polls;
+static uint8_t key_local = 0;	//Current key is local
+//Local keys (USART1 bytes from interrupt), new ones are dropped when queue is full (auto-repeat)
+static volatile char local_queue[MENU_EVENT_LOCAL_QUEUE];
+static volatile uint8_t local_head = 0;
+static volatile uint8_t local_tail = 0;
+static menu* volatile open_request = NULL;
+static menu* open_parents[MENU_PATH_DEPTH];
+static uint8_t open_depth;
+static volatile menu_event_function call_request = NULL;
+
+uint8_t menu_event_push(char key){
+	uint8_t next = (key_head + 1) % MENU_EVENT_QUEUE;
+	if(next == key_tail) return 0;
+	key_queue[key_head] = key;
+	key_head = next;
+	return 1;
+}
+
+uint8_t menu_event_local(char key){
+	uint8_t next = (local_head + 1) % MENU_EVENT_LOCAL_QUEUE;
+	if(next == local_tail) return 0;
+	local_queue[local_head] = key;
+	local_head = next;
+	return 1;
+}
+
+void menu_event_local_drop(){
+	local_tail = local_head;
+	if(key_local) menu_key_read = 1;
+}
+
+uint8_t menu_event_open(menu* item, menu* const* parents, uint8_t depth){
+	uint8_t i;
+	if(open_request != NULL) return 0;
+	for(i = 0; i < depth && i < MENU_PATH_DEPTH; i++) open_parents[i] = parents[i];
+	open_depth = depth;
+	open_request = item;
+	return 1;
+}
+
+menu* menu_event_take_open(menu** parents, uint8_t* depth){
+	menu* item = open_request;
+	uint8_t i;
+	if(item == NULL) return NULL;
+	for(i = 0; i < open_depth && i < MENU_PATH_DEPTH; i++) parents[i] = open_parents[i];
+	*depth = open_depth;
+	open_request = NULL;
+	return item;
+}
+
+uint8_t menu_event_call(menu_event_function function){
+	if(call_request != NULL) return 0;
+	call_request = function;
+	return 1;
+}
+
+menu_event_function menu_event_take_call(){
+	menu_event_function function = call_request;
+	call_request = NULL;
+	return function;
+}
+
+static void next_key(){
+	menu_remote_service();
+	//Unread key waits until menu reads it or polls it MENU_EVENT_KEY_POLLS times
+	if(menu_key_read == 0 && ++key_polls < MENU_EVENT_KEY_POLLS) return;
+	if(key_head != key_tail){
+		menu_event_key = key_queue[key_tail];
+		key_tail = (key_tail + 1) % MENU_EVENT_QUEUE;
+		key_local = 0;
+	}
+	else if(local_head != local_tail){
+		menu_event_key = local_queue[local_tail];
+		local_tail = (local_tail + 1) % MENU_EVENT_LOCAL_QUEUE;
+		key_local = 1;
+	}
+	else return;
+	key_polls = 0;
+	menu_key_read = 0;
+}
+
 
 ////Not used
 char get_event(char* event){
@@ -14,6 +102,7 @@ char get_event(char* event){
 }
 
 char get_key(char a){
+	next_key();
 	if(menu_key_read == 0){
 		if( menu_event_key == a){
 			menu_key_read = 1;
@@ -25,8 +114,9 @@ char get_key(char a){
 }
 
 char read_key(){
+	next_key();
 	if(menu_key_read == 0){
 		menu_key_read = 1;
 		return menu_event_key;
 	}
-}
\ No newline at end of file
+}
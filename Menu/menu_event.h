@@ -1,6 +1,13 @@
 #ifndef MENU_EVENT_H
 #define	 MENU_EVENT_H
 
+#include <stdint.h>
+#include "menu_system.h"
+
+#define MENU_EVENT_QUEUE				64		//Queued keys, more than one remote KEY command (32 keys)
+#define MENU_EVENT_LOCAL_QUEUE	16		//Local keys (USART1 bytes)
+#define MENU_EVENT_KEY_POLLS		32		//Queued key which menu polls this many times without reading is dropped
+
 //These event can be set from anywhere in the program
 //You can create your own events here
 
@@ -13,4 +20,26 @@ char get_event(char* event);
 char get_key(char a);
 
 char read_key();
+
+//Queue key after previous ones, returns 0 if queue is full
+uint8_t menu_event_push(char key);
+
+//Queue local key (USART1 byte, from interrupt) after previous local ones, queued remote keys go first.
+//Returns 0 if local queue is full, key is dropped then (auto-repeat faster than menu reads keys)
+uint8_t menu_event_local(char key);
+//Drop local keys which were not read yet
+void menu_event_local_drop();
+
+//Ask menu to open item as if it was selected (from other task), returns 0 if previous request is still waiting.
+//parents are depth menus from main menu to parent of item (first MENU_PATH_DEPTH are kept), they are menu_path while item is open.
+//Request is taken by cycle_menu when it waits for input, so it waits while a command function runs.
+uint8_t menu_event_open(menu* item, menu* const* parents, uint8_t depth);
+//Parents are copied to parents (MENU_PATH_DEPTH menus) and their count to depth
+menu* menu_event_take_open(menu** parents, uint8_t* depth);
+
+//Ask menu task to call function (from other task), taken like open request.
+//Menu functions are not running then, so function can use the disk (FatFs is used by menu task only).
+typedef void (*menu_event_function)(void);
+uint8_t menu_event_call(menu_event_function function);
+menu_event_function menu_event_take_call();
 #endif
\ No newline at end of file
@@ -11,21 +11,41 @@
 #include "menu_button.h"
 #include "menu_display.h"
 #include "menu_touch.h"
+#include "menu_image.h"
+#include "menu_text.h"
+#include "menu_overlay.h"
+#include "menu_terminal.h"
+#include "menu_remote.h"
+#include "menu_log.h"
+#include "menu_profile.h"
+#include "menu_dirlist.h"
+#include "ff.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
 
-#define TERMINAL_WIDTH 240
-#define TERMINAL_HEIGHT 320
 #define TERMINAL_FONT TM_Font_7x10
-#define TERMINAL_FONT_WIDTH 7
-#define TERMINAL_FONT_HEIGHT 11
+#define TERMINAL_FLUSH_TIME 20		//ms, output is drawn in batches
+#define TERMINAL_EXIT_TIME 300	//ms, Esc without escape sequence exits terminal
 
 #define PAINT_FONT	TM_Font_11x18
 
+#define STATS_FONT TM_Font_7x10
+#define STATS_LINE 12		//Line height in pixels
+
+#define FILES_FONT TM_Font_7x10
+#define FILES_LINE 12		//Line height in pixels
+#define FILES_LINES ((MENU_HEIGHT - 5)/FILES_LINE - 3)	//Entries on one page, path is above, count and help below them
+#define FILES_PATH 64
+
 
 char LED_initialized = 0;
+FATFS image_fatfs;
 
 
 void LED(){
-	USART_puts(USART1, "LED function\n\r");
+	menu_overlay* overlay;
+	LOG0("LED function");
 	if(LED_initialized == 0){
 	STM_EVAL_LEDInit(LED3);
 	STM_EVAL_LEDInit(LED4);
@@ -33,8 +53,11 @@ void LED(){
 	STM_EVAL_LEDInit(LED6);
 	LED_initialized = 1;	
 	}
-	TM_ILI9341_Fill(ILI9341_COLOR_WHITE);
-	TM_ILI9341_Puts(0, 10, "Control your LEDs using numbers 1, 2, 3 and 4", &TM_Font_11x18, ILI9341_COLOR_BLACK, ILI9341_TRANSPARENT);
+	//Instructions are shown in overlay, menu is restored on exit without repaint
+	overlay = menu_overlay_open(MENU_DIALOG_X1, MENU_DIALOG_Y1, MENU_DIALOG_X2, MENU_DIALOG_Y2);
+	menu_display_fill(WHITE);
+	if(overlay != NULL) menu_display_draw_rectangle(MENU_DIALOG_X1, MENU_DIALOG_Y1, MENU_DIALOG_X2, MENU_DIALOG_Y2, BLACK);
+	menu_text_draw_wrapped(MENU_DIALOG_X1 + 5, MENU_DIALOG_Y1 + 10, MENU_DIALOG_X2 - 5, MENU_DIALOG_Y2 - 5, "Control your LEDs using numbers 1, 2, 3 and 4. Esc to exit.", &TM_Font_11x18, MENU_TEXT_LEFT, BLACK, TRANSPARENT);
 	while(1){
 	if(get_key('1')) STM_EVAL_LEDToggle(LED3);
 	if(get_key('2')) STM_EVAL_LEDToggle(LED4);
@@ -42,17 +65,20 @@ void LED(){
 	if(get_key('4')) STM_EVAL_LEDToggle(LED6);
 	
 	if(get_key(27)){
-		TM_ILI9341_Fill(ILI9341_COLOR_WHITE);
+		if(overlay != NULL){
+			menu_overlay_close(overlay);
+			menu_keep_screen();
+		}
 		return;}
 	}
 }
 
 void apocalypse(){
 	int x=62, i;
-	TM_ILI9341_Fill(ILI9341_COLOR_BLACK);
-	TM_ILI9341_Puts(10, 50, "Are you sure you want to start apocalypse?", &TM_Font_7x10, ILI9341_COLOR_WHITE, ILI9341_TRANSPARENT);
-	while(!get_key('d')){
-		if(get_key('a'))return;
+	if(!menu_dialog_confirm("Apocalypse", "Are you sure you want to start apocalypse?")){
+		menu_keep_screen();
+		menu_toast_show("Apocalypse cancelled", MENU_TOAST_TIME);
+		return;
 	}
 	TM_ILI9341_Fill(ILI9341_COLOR_BLACK);
 	TM_ILI9341_DrawRectangle(60, 100, 260, 115, ILI9341_COLOR_WHITE);
@@ -72,93 +98,72 @@ void apocalypse(){
 }
 
 void terminal(){
-	uint16_t x_max = TERMINAL_WIDTH/TERMINAL_FONT_WIDTH, y_max = TERMINAL_HEIGHT/TERMINAL_FONT_HEIGHT, x_pointer = 0, y_pointer = 0;
-	uint16_t x = 0, y = 0, i, j; //positions in terminal_array
-	uint8_t charachter;
-	uint8_t terminal_array[TERMINAL_WIDTH/TERMINAL_FONT_WIDTH][TERMINAL_HEIGHT/TERMINAL_FONT_HEIGHT];
-	
+	uint8_t previous = 0, changed = 0;
+	uint8_t* chunk;
+	uint16_t x, y, length, i;
+	touch_gesture move;
+	TickType_t last_input, last_flush;
 	
 	TM_ILI9341_Fill(ILI9341_COLOR_BLACK);
-	TM_ILI9341_Puts(25, 15, "This is serial terminal.\n    Press Esc to exit.\n  Press Enter to continue.", &TERMINAL_FONT, ILI9341_COLOR_GREEN, ILI9341_TRANSPARENT);
+	TM_ILI9341_Puts(25, 15, "This is serial terminal.\n    Press Esc to exit.\n  Press Enter to continue.\n Swipe down to see history.", &TERMINAL_FONT, ILI9341_COLOR_GREEN, ILI9341_TRANSPARENT);
 	
 	while(!get_key(13)){
 		if(get_key(27))return;
 	}
 	
-	
-	TM_ILI9341_Fill(ILI9341_COLOR_BLACK);
+	menu_terminal_init(GREEN, BLACK);
+	menu_terminal_flush();
+	last_input = last_flush = xTaskGetTickCount();
+	menu_remote_enable(0);	//Terminal reads USART1 directly
+	USART1_RxFlush();
 	
 	while(1){
-		if(menu_key_read == 0){
-		charachter = read_key();
-		if(charachter == 13){
-			for(i = x; i < x_max; i++){
-				x_pointer = i * TERMINAL_FONT_WIDTH;
-				terminal_putc(x_pointer, y_pointer, ' ', &TERMINAL_FONT, ILI9341_COLOR_GREEN, ILI9341_COLOR_BLACK);	
-				terminal_array[i][y] = ' ';
+		//Whole received chunk is parsed at once, directly from RX buffer
+		length = USART1_GetChunk(&chunk);
+		if(length > 0){
+			for(i = 0; i < length; i++){
+				if(chunk[i] == 13){	//Enter, new line
+					menu_terminal_puts("\r\n");
+				}
+				else if(chunk[i] != 10 || previous != 13){	//LF after CR is already done
+					menu_terminal_putc(chunk[i]);
+				}
+				previous = chunk[i];
 			}
-
-			
-			x = 0;
-			y = y + 1;
-			x_pointer = 0;	//novi red
-			y_pointer = y_pointer + TERMINAL_FONT_HEIGHT;
+			USART1_ReleaseChunk(length);
+			changed = 1;
+			last_input = xTaskGetTickCount();
 		}
-		
-		else if(charachter == 27){
-			return;
-		}
-		else{
-			terminal_putc(x_pointer, y_pointer, charachter, &TERMINAL_FONT, ILI9341_COLOR_GREEN, ILI9341_COLOR_BLACK);	//write to screen
-			terminal_array[x][y] = charachter;
-			x_pointer = x_pointer + TERMINAL_FONT_WIDTH;
-			x = x + 1;
+		else if(menu_terminal_escape() && (xTaskGetTickCount() - last_input) >= TERMINAL_EXIT_TIME/portTICK_PERIOD_MS){
+			break;	//Esc alone, not start of escape sequence
 		}
 		
-		if(x_pointer == (TERMINAL_WIDTH/TERMINAL_FONT_WIDTH)*TERMINAL_FONT_WIDTH){
-//			USART_puts(USART1, "Tu sam\n\r");
-			x_pointer = 0;
-			x = 0;
-			y_pointer = y_pointer + TERMINAL_FONT_HEIGHT; 
-			y = y + 1;
-		}
-		//The terminal is full
-		if(y_pointer == (TERMINAL_HEIGHT/TERMINAL_FONT_HEIGHT)*TERMINAL_FONT_HEIGHT){
-//			USART_puts(USART1, "Full terminal");
-			y_pointer = y_pointer - TERMINAL_FONT_HEIGHT;		
-			y = y - 1;
-			for(j = 0; j < y_max-1; j++){
-				for(i = 0; i < x_max; i++){
-					terminal_array[i][j] = terminal_array[i][j+1];
-					terminal_putc(i*TERMINAL_FONT_WIDTH, (j)*TERMINAL_FONT_HEIGHT, terminal_array[i][j], &TERMINAL_FONT, ILI9341_COLOR_GREEN, ILI9341_COLOR_BLACK);
-				}
-			}
-			TM_ILI9341_DrawFilledRectangle(0, y_pointer, TERMINAL_WIDTH, y_pointer+TERMINAL_FONT_HEIGHT, ILI9341_COLOR_BLACK);
+		move = menu_touch_gesture(&x, &y);
+		if(move == TOUCH_DOWN){
+			menu_terminal_page_up();
+			last_flush = 0;
+			changed = 1;
 		}
-		TM_ILI9341_DrawRectangle(x_pointer, y_pointer, x_pointer+TERMINAL_FONT_WIDTH, y_pointer+TERMINAL_FONT_HEIGHT-2, ILI9341_COLOR_GREEN);
-		//Delay
-		TM_ILI9341_DrawRectangle(x_pointer, y_pointer, x_pointer+TERMINAL_FONT_WIDTH, y_pointer+TERMINAL_FONT_HEIGHT-2, ILI9341_COLOR_BLACK);
+		else if(move == TOUCH_UP){
+			menu_terminal_page_down();
+			last_flush = 0;
+			changed = 1;
 		}
-	}
-}
-
-void terminal_putc(uint16_t x, uint16_t y, char c, TM_FontDef_t *font, uint32_t foreground, uint32_t background) {
-	uint32_t i, b, j;
-	/* Set coordinates */
-	for (i = 0; i < font->FontHeight; i++) {
-		b = font->data[(c - 32) * font->FontHeight + i];
-		for (j = 0; j < font->FontWidth; j++) {
-			if ((b << j) & 0x8000) {
-				TM_ILI9341_DrawPixel(x + j, (y + i), foreground);
-			} else if ((background & ILI9341_TRANSPARENT) == 0) {
-				TM_ILI9341_DrawPixel(x + j, (y + i), background);
-			}
+		
+		//Burst of characters is drawn at once
+		if(changed && (xTaskGetTickCount() - last_flush) >= TERMINAL_FLUSH_TIME/portTICK_PERIOD_MS){
+			menu_terminal_flush();
+			last_flush = xTaskGetTickCount();
+			changed = 0;
 		}
 	}
+	menu_terminal_close();
+	menu_remote_enable(1);
+	menu_event_local_drop();	//Bytes were already used by terminal
 }
 
 void verzija(){
-	USART_puts(USART1, "Verzija \n");
+	LOG0("Version");
 	return;
 }
 
@@ -261,3 +266,205 @@ void uint16tostr(char buf[], uint32_t d, uint8_t base)
     buf[index] = 0;	// end of string
 }
 
+void images(){
+	DIR dir;
+	FILINFO file_info;
+	char path[16] = "0:/";
+	uint8_t i, shown = 0;
+	uint16_t x, y;
+	touch_gesture move;
+
+	menu_display_fill(BLACK);
+	if(f_mount(&image_fatfs, "0:", 1) != FR_OK || f_opendir(&dir, "0:/") != FR_OK){
+		menu_display_puts(10, 50, "No disk", &TM_Font_11x18, WHITE, BLACK);
+		while(!get_key(27));
+		return;
+	}
+	while(1){
+		if(f_readdir(&dir, &file_info) != FR_OK) break;
+		if(file_info.fname[0] == 0){	//End of directory, start again
+			if(!shown) break;
+			shown = 0;
+			f_readdir(&dir, NULL);
+			continue;
+		}
+		if(file_info.fattrib & AM_DIR || !menu_image_supported(file_info.fname)) continue;
+
+		for(i = 0; file_info.fname[i]; i++){
+			path[3+i] = file_info.fname[i];
+		}
+		path[3+i] = 0;
+		menu_display_fill(BLACK);
+		if(menu_image_draw(path, 0, 0) != MENU_IMAGE_OK){
+			menu_display_puts(10, 50, file_info.fname, &TM_Font_11x18, WHITE, BLACK);
+		}
+		shown = 1;
+
+		//Next image on 'd' or swipe, exit on Esc or 'a'
+		while(1){
+			move = menu_touch_gesture(&x, &y);
+			if(get_key('d') || move == TOUCH_LEFT) break;
+			if(get_key(27) || get_key('a')){
+				f_closedir(&dir);
+				f_mount(NULL, "0:", 0);
+				return;
+			}
+		}
+	}
+	f_closedir(&dir);
+	f_mount(NULL, "0:", 0);
+	menu_display_puts(10, 50, "No images", &TM_Font_11x18, WHITE, BLACK);
+	while(!get_key(27));
+}
+
+//One line of file list, padded with spaces so old text is overwritten
+static void files_line(uint8_t line, const char* text, uint16_t color, uint16_t background){
+	char padded[MENU_WIDTH/7 + 1];
+	uint8_t i;
+	for(i = 0; text[i] && i < sizeof(padded) - 1; i++) padded[i] = text[i];
+	for(; i < sizeof(padded) - 1; i++) padded[i] = ' ';
+	padded[i] = 0;
+	menu_display_puts(2, 5 + line*FILES_LINE, padded, &FILES_FONT, color, background);
+}
+
+static void files_entry(uint8_t line, menu_dirlist_entry* entry, uint8_t selected){
+	char text[40];
+	if(entry == NULL) text[0] = 0;
+	else if(entry->attrib & AM_DIR) sprintf(text, "%-22.22s  <DIR>", menu_dirlist_name(entry));
+	else sprintf(text, "%-22.22s %7lu", menu_dirlist_name(entry), (unsigned long)entry->size);
+	files_line(line, text, selected ? BLACK : WHITE, selected ? WHITE : BLACK);
+}
+
+//File browser, sorted list is paged from menu_dirlist so scrolling reads only shown entries
+void files(){
+	char path[FILES_PATH] = "0:/";
+	char file[FILES_PATH];
+	char text[40];
+	menu_dirlist_entry* page = NULL;
+	menu_dirlist_entry* selected;
+	uint16_t got = 0, x, y, i;
+	uint32_t cursor = 0, previous = 0, top = 0, count = 0;
+	uint8_t reload = 1, redraw = 1;
+	char* slash;
+	touch_gesture move;
+
+	menu_display_fill(BLACK);
+	if(f_mount(&image_fatfs, "0:", 1) != FR_OK){
+		menu_display_puts(10, 50, "No disk", &TM_Font_11x18, WHITE, BLACK);
+		while(!get_key(27));
+		return;
+	}
+	while(1){
+		if(reload){
+			if(menu_dirlist_open(path, MENU_DIRLIST_DIRS_FIRST, NULL) != FR_OK){
+				menu_display_fill(BLACK);
+				menu_display_puts(10, 50, "Cannot read directory", &FILES_FONT, WHITE, BLACK);
+				while(!get_key(27));
+				break;
+			}
+			count = menu_dirlist_count();
+			cursor = previous = 0;
+			reload = 0;
+			redraw = 1;
+		}
+		if(redraw || cursor/FILES_LINES*FILES_LINES != top){
+			top = cursor/FILES_LINES*FILES_LINES;
+			if(menu_dirlist_page(top, FILES_LINES, &page, &got) != FR_OK) got = 0;
+			files_line(0, path, YELLOW, BLACK);
+			for(i = 0; i < FILES_LINES; i++) files_entry(i + 1, i < got ? &page[i] : NULL, top + i == cursor);
+			files_line(FILES_LINES + 2, "w/s: move, d: open, a: back", GRAY, BLACK);
+		}
+		else if(cursor != previous){	//Same page, only two lines change
+			if(previous - top < got) files_entry(previous - top + 1, &page[previous - top], 0);
+			if(cursor - top < got) files_entry(cursor - top + 1, &page[cursor - top], 1);
+		}
+		if(redraw || cursor != previous){
+			sprintf(text, "%lu/%lu", (unsigned long)(count ? cursor + 1 : 0), (unsigned long)count);
+			files_line(FILES_LINES + 1, text, GRAY, BLACK);
+			previous = cursor;
+			redraw = 0;
+		}
+
+		move = menu_touch_gesture(&x, &y);
+		if(get_key(27)) break;
+		if((get_key('s') || move == TOUCH_UP) && cursor + 1 < count) cursor++;
+		if((get_key('w') || move == TOUCH_DOWN) && cursor > 0) cursor--;
+		if((get_key('d') || get_key(13) || move == TOUCH_LEFT) && cursor - top < got){
+			selected = &page[cursor - top];
+			snprintf(file, sizeof(file), "%s%s%s", path, path[strlen(path) - 1] == '/' ? "" : "/", menu_dirlist_name(selected));
+			if(selected->attrib & AM_DIR){
+				strcpy(path, file);
+				reload = 1;
+			}
+			else if(menu_image_supported((char*)menu_dirlist_name(selected))){
+				menu_display_fill(BLACK);
+				if(menu_image_draw(file, 0, 0) != MENU_IMAGE_OK){
+					menu_display_puts(10, 50, "Cannot show image", &TM_Font_11x18, WHITE, BLACK);
+				}
+				while(!get_key(27) && !get_key('a'));
+				menu_display_fill(BLACK);
+				redraw = 1;
+			}
+		}
+		if(get_key('a') || move == TOUCH_RIGHT){
+			if(strcmp(path, "0:/") == 0) break;
+			slash = strrchr(path, '/');
+			if(slash - path == 2) path[3] = 0;		//Back to root, "0:/"
+			else *slash = 0;
+			reload = 1;
+		}
+	}
+	menu_dirlist_close();
+	f_mount(NULL, "0:", 0);
+}
+
+//One line of stats page, padded with spaces so old text is overwritten
+static void stats_line(uint8_t line, char* text, uint16_t color){
+	char padded[MENU_WIDTH/7 + 1];
+	uint8_t i;
+	for(i = 0; text[i] && i < sizeof(padded) - 1; i++) padded[i] = text[i];
+	for(; i < sizeof(padded) - 1; i++) padded[i] = ' ';
+	padded[i] = 0;
+	menu_display_puts(2, 5 + line*STATS_LINE, padded, &STATS_FONT, color, BLACK);
+}
+
+void stats(){
+	menu_profile_task tasks[MENU_PROFILE_TASKS];
+	menu_profile_timer* timer;
+	char text[48];
+	uint8_t count, i, line;
+	TickType_t drawn;
+
+	menu_display_fill(BLACK);
+	drawn = xTaskGetTickCount() - MENU_PROFILE_WINDOW/portTICK_PERIOD_MS;
+	while(1){
+		if(get_key(27) || get_key('a')) return;
+		if(get_key('r')) menu_profile_reset_timers();
+		if(xTaskGetTickCount() - drawn < MENU_PROFILE_WINDOW/portTICK_PERIOD_MS) continue;
+		drawn = xTaskGetTickCount();
+
+		line = 0;
+		stats_line(line++, "Task             CPU%  Stack", YELLOW);
+		count = menu_profile_sample(tasks, MENU_PROFILE_TASKS);
+		for(i = 0; i < count; i++){
+			sprintf(text, "%-16s %3u.%u %5u", tasks[i].name, tasks[i].cpu/10, tasks[i].cpu%10, tasks[i].stack);
+			stats_line(line++, text, WHITE);
+		}
+		if(count == 0) stats_line(line++, "Measuring...", WHITE);
+		for(; line < MENU_PROFILE_TASKS + 1; line++) stats_line(line, "", WHITE);
+
+		line++;
+		stats_line(line++, "Timer        Count  Avg us  Max us", YELLOW);
+		for(i = 0; i < MENU_PROFILE_TIMERS; i++){
+			timer = &menu_profile_timers[i];
+			sprintf(text, "%-12s %5u %7u %7u", timer->name, timer->count,
+				timer->count ? MENU_PROFILE_US(timer->total/timer->count) : 0, MENU_PROFILE_US(timer->max));
+			stats_line(line++, text, WHITE);
+		}
+
+		line++;
+		sprintf(text, "Heap free %u, log dropped %u", (unsigned int)xPortGetFreeHeapSize(), menu_log_dropped);
+		stats_line(line++, text, WHITE);
+		stats_line(line++, "r: reset timers, Esc: exit", GRAY);
+	}
+}
@@ -31,8 +31,12 @@ void apocalypse();
 void touch();
 void uint16tostr(char buf[], uint32_t d, uint8_t base);
 
+void images();
+void files();		//Sorted file browser (menu_dirlist.h)
+
 void terminal();
-void terminal_putc(uint16_t x, uint16_t y, char c, TM_FontDef_t *font, uint32_t foreground, uint32_t background);
+
+void stats();		//CPU load, stacks and hot path timers (menu_profile.h)
 
 
 #endif
\ No newline at end of file
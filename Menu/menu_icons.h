@@ -0,0 +1,21 @@
+#ifndef MENU_ICONS_H
+#define MENU_ICONS_H
+
+#include "menu_sprite.h"
+
+//Icon IDs in menu_icons atlas. MENU_ICON_NONE is empty sprite, so drawing it does nothing
+typedef enum {
+	MENU_ICON_NONE,
+	MENU_ICON_LED,
+	MENU_ICON_TERMINAL,
+	MENU_ICON_IMAGE,
+	MENU_ICON_INFO,
+	MENU_ICON_TOUCH,
+	MENU_ICON_COUNT
+}menu_icon;
+
+#define MENU_ICON_SIZE	16
+
+extern const menu_sprite_atlas menu_icons;
+
+#endif
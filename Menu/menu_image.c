@@ -0,0 +1,286 @@
+#include "menu_image.h"
+#include "menu_display.h"
+#include "menu_system.h"
+
+#define BMP_HEADER_SIZE		54
+#define QOI_HEADER_SIZE		14
+
+#define QOI_OP_INDEX	0x00
+#define QOI_OP_DIFF		0x40
+#define QOI_OP_LUMA		0x80
+#define QOI_OP_RUN		0xC0
+#define QOI_OP_RGB		0xFE
+#define QOI_OP_RGBA		0xFF
+#define QOI_MASK			0xC0
+
+#define RGB565(r, g, b)	((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3))
+
+typedef struct{
+	FIL* file;
+	uint16_t pos;
+	uint16_t len;
+	uint8_t error;
+}image_reader;
+
+static uint8_t image_chunk[MENU_IMAGE_CHUNK];
+static DWORD image_clmt[MENU_IMAGE_CLMT];	//Cluster map of opened image, seek does not walk FAT chain
+static uint8_t image_row[2][MENU_WIDTH*2];	//One row is sent while next one is decoded
+
+static uint8_t image_reader_fill(image_reader* reader){
+	UINT read;
+	//Keep file pointer sector aligned, then FatFs reads whole sectors directly into chunk
+	UINT size = MENU_IMAGE_CHUNK - (f_tell(reader->file) % 512);
+	if(f_read(reader->file, image_chunk, size, &read) != FR_OK){
+		reader->error = 1;
+		read = 0;
+	}
+	reader->pos = 0;
+	reader->len = read;
+	if(read == 0) reader->error = 1;
+	return read != 0;
+}
+
+static uint8_t image_reader_byte(image_reader* reader){
+	if(reader->pos == reader->len){
+		if(!image_reader_fill(reader)) return 0;
+	}
+	return image_chunk[reader->pos++];
+}
+
+static void image_reader_read(image_reader* reader, uint8_t* data, uint16_t count){
+	while(count--){
+		*data++ = image_reader_byte(reader);
+	}
+}
+
+static void image_reader_skip(image_reader* reader, uint32_t count){
+	uint16_t left = reader->len - reader->pos;
+	if(count <= left){
+		reader->pos = reader->pos + count;
+		return;
+	}
+	//Far jump, seek instead of reading
+	if(f_lseek(reader->file, f_tell(reader->file) + (count - left)) != FR_OK){
+		reader->error = 1;
+	}
+	reader->pos = reader->len = 0;
+}
+
+static uint32_t get_le32(uint8_t* p){
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t get_be32(uint8_t* p){
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+//Columns of image inside clip: skip_left pixels are not drawn, then visible_width pixels are drawn
+static void image_visible_columns(menu_display_clip* clip, uint16_t x, uint32_t width, uint16_t* skip_left, uint16_t* visible_width){
+	uint32_t x2 = x + width - 1;
+	*skip_left = 0;
+	*visible_width = 0;
+	if(clip->x1 > clip->x2 || x > clip->x2 || x2 < clip->x1) return;
+	if(x < clip->x1) *skip_left = clip->x1 - x;
+	if(x2 > clip->x2) x2 = clip->x2;
+	*visible_width = x2 - (x + *skip_left) + 1;
+}
+
+//Send decoded row, window is set per row so rows can come in any order
+static void image_send_row(uint8_t* row, uint16_t x, uint16_t y, uint16_t width){
+	menu_display_window(x, y, x + width - 1, y);	//Waits for previous row
+	menu_display_write_async(row, width*2);
+}
+
+static menu_image_result image_draw_bmp(image_reader* reader, uint8_t* header, uint16_t x, uint16_t y){
+	uint32_t offset = get_le32(header + 10);
+	int32_t width = (int32_t)get_le32(header + 18);
+	int32_t height = (int32_t)get_le32(header + 22);
+	uint16_t bpp = header[28] | (header[29] << 8);
+	uint32_t compression = get_le32(header + 30);
+	uint32_t consumed = BMP_HEADER_SIZE, stride, row, i, screen_y;
+	uint8_t masks[12], rgb555 = 0, top_down = 0, buffer = 0, px[4];
+	uint16_t visible_width = 0, skip_left = 0, color;
+	uint8_t* out;
+	menu_display_clip clip;
+
+	if(height < 0){
+		top_down = 1;
+		height = -height;
+	}
+	if(width <= 0 || height == 0) return MENU_IMAGE_ERROR_FORMAT;
+	if(bpp != 16 && bpp != 24 && bpp != 32) return MENU_IMAGE_ERROR_FORMAT;
+	if(compression == 3 && bpp != 24){	//BI_BITFIELDS
+		image_reader_read(reader, masks, 12);
+		consumed = consumed + 12;
+		if(bpp == 16 && get_le32(masks) == 0x7C00) rgb555 = 1;
+	}
+	else if(compression == 0){	//BI_RGB
+		if(bpp == 16) rgb555 = 1;
+	}
+	else return MENU_IMAGE_ERROR_FORMAT;
+	if(offset < consumed) return MENU_IMAGE_ERROR_FORMAT;
+	image_reader_skip(reader, offset - consumed);
+
+	menu_display_get_clip(&clip);
+	image_visible_columns(&clip, x, width, &skip_left, &visible_width);
+	stride = ((width*bpp + 31)/32)*4;
+
+	for(row = 0; row < (uint32_t)height && !reader->error; row++){
+		screen_y = top_down ? (y + row) : (y + height - 1 - row);
+		if(visible_width == 0 || screen_y < clip.y1 || screen_y > clip.y2){	//Row is not visible
+			image_reader_skip(reader, stride);
+			continue;
+		}
+		image_reader_skip(reader, skip_left*(bpp/8));
+		out = image_row[buffer];
+		for(i = 0; i < visible_width; i++){
+			image_reader_read(reader, px, bpp/8);
+			if(bpp == 16){
+				color = px[0] | (px[1] << 8);
+				if(rgb555) color = ((color & 0x7FE0) << 1) | (color & 0x001F);
+			}
+			else{
+				color = RGB565(px[2], px[1], px[0]);
+			}
+			*out++ = color >> 8;
+			*out++ = color & 0xFF;
+		}
+		image_reader_skip(reader, stride - (skip_left + visible_width)*(bpp/8));
+		if(reader->error) break;
+		image_send_row(image_row[buffer], x + skip_left, screen_y, visible_width);
+		buffer ^= 1;
+	}
+	menu_display_wait();
+	return reader->error ? MENU_IMAGE_ERROR_READ : MENU_IMAGE_OK;
+}
+
+static menu_image_result image_draw_qoi(image_reader* reader, uint8_t* header, uint16_t x, uint16_t y){
+	uint32_t width = get_be32(header + 4);
+	uint32_t height = get_be32(header + 8);
+	uint32_t row, i;
+	uint8_t index[64][4];
+	uint8_t r = 0, g = 0, b = 0, a = 255, op, next, hash, run = 0, buffer = 0;
+	int8_t dg;
+	uint16_t visible_width = 0, skip_left = 0, color;
+	uint8_t* out;
+	menu_display_clip clip;
+
+	if(width == 0 || height == 0) return MENU_IMAGE_ERROR_FORMAT;
+	for(i = 0; i < 64; i++){
+		index[i][0] = index[i][1] = index[i][2] = index[i][3] = 0;
+	}
+	menu_display_get_clip(&clip);
+	image_visible_columns(&clip, x, width, &skip_left, &visible_width);
+	if(visible_width == 0) return MENU_IMAGE_OK;
+
+	//QOI can not skip rows, every pixel depends on previous ones
+	for(row = 0; row < height && (y + row) <= clip.y2 && !reader->error; row++){
+		out = image_row[buffer];
+		for(i = 0; i < width; i++){
+			if(run > 0){
+				run--;
+			}
+			else{
+				op = image_reader_byte(reader);
+				if(op == QOI_OP_RGB){
+					r = image_reader_byte(reader);
+					g = image_reader_byte(reader);
+					b = image_reader_byte(reader);
+				}
+				else if(op == QOI_OP_RGBA){
+					r = image_reader_byte(reader);
+					g = image_reader_byte(reader);
+					b = image_reader_byte(reader);
+					a = image_reader_byte(reader);
+				}
+				else if((op & QOI_MASK) == QOI_OP_INDEX){
+					r = index[op][0];
+					g = index[op][1];
+					b = index[op][2];
+					a = index[op][3];
+				}
+				else if((op & QOI_MASK) == QOI_OP_DIFF){
+					r = r + ((op >> 4) & 0x03) - 2;
+					g = g + ((op >> 2) & 0x03) - 2;
+					b = b + (op & 0x03) - 2;
+				}
+				else if((op & QOI_MASK) == QOI_OP_LUMA){
+					next = image_reader_byte(reader);
+					dg = (op & 0x3F) - 32;
+					r = r + dg - 8 + ((next >> 4) & 0x0F);
+					g = g + dg;
+					b = b + dg - 8 + (next & 0x0F);
+				}
+				else{	//QOI_OP_RUN
+					run = op & 0x3F;
+				}
+				hash = (r*3 + g*5 + b*7 + a*11) % 64;
+				index[hash][0] = r;
+				index[hash][1] = g;
+				index[hash][2] = b;
+				index[hash][3] = a;
+			}
+			if(i >= skip_left && i < skip_left + visible_width){
+				color = RGB565(r, g, b);
+				*out++ = color >> 8;
+				*out++ = color & 0xFF;
+			}
+		}
+		if(reader->error) break;
+		if((y + row) < clip.y1) continue;	//Decoded, but not visible
+		image_send_row(image_row[buffer], x + skip_left, y + row, visible_width);
+		buffer ^= 1;
+	}
+	menu_display_wait();
+	return reader->error ? MENU_IMAGE_ERROR_READ : MENU_IMAGE_OK;
+}
+
+menu_image_result menu_image_draw_file(FIL* file, uint16_t x, uint16_t y){
+	image_reader reader;
+	uint8_t header[BMP_HEADER_SIZE];
+
+	reader.file = file;
+	reader.pos = reader.len = 0;
+	reader.error = 0;
+
+	image_reader_read(&reader, header, QOI_HEADER_SIZE);
+	if(reader.error) return MENU_IMAGE_ERROR_READ;
+	if(header[0] == 'B' && header[1] == 'M'){
+		image_reader_read(&reader, header + QOI_HEADER_SIZE, BMP_HEADER_SIZE - QOI_HEADER_SIZE);
+		if(reader.error) return MENU_IMAGE_ERROR_READ;
+		return image_draw_bmp(&reader, header, x, y);
+	}
+	if(header[0] == 'q' && header[1] == 'o' && header[2] == 'i' && header[3] == 'f'){
+		return image_draw_qoi(&reader, header, x, y);
+	}
+	return MENU_IMAGE_ERROR_FORMAT;
+}
+
+menu_image_result menu_image_draw(char* path, uint16_t x, uint16_t y){
+	FIL file;
+	menu_image_result result;
+	if(f_open(&file, path, FA_READ | FA_OPEN_EXISTING) != FR_OK){
+		return MENU_IMAGE_ERROR_FILE;
+	}
+	file.cltbl = image_clmt;
+	image_clmt[0] = MENU_IMAGE_CLMT;
+	if(f_lseek(&file, CREATE_LINKMAP) != FR_OK) file.cltbl = 0;	//Too fragmented, normal seek
+	result = menu_image_draw_file(&file, x, y);
+	f_close(&file);
+	return result;
+}
+
+uint8_t menu_image_supported(char* name){
+	uint16_t length = 0;
+	char ext[3];
+	uint8_t i;
+	while(name[length]) length++;
+	if(length < 4 || name[length-4] != '.') return 0;
+	for(i = 0; i < 3; i++){
+		ext[i] = name[length-3+i];
+		if(ext[i] >= 'a' && ext[i] <= 'z') ext[i] = ext[i] - 'a' + 'A';
+	}
+	if(ext[0] == 'B' && ext[1] == 'M' && ext[2] == 'P') return 1;
+	if(ext[0] == 'Q' && ext[1] == 'O' && ext[2] == 'I') return 1;
+	return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef MENU_IMAGE_H
+#define MENU_IMAGE_H
+
+#include <stdint.h>
+#include "ff.h"
+
+//Streaming image decoder, reads file with f_read and sends rows directly to display.
+//Whole image is never in RAM, only one input chunk and two display rows.
+//Supported formats:
+//	- BMP, uncompressed 16 bit (RGB565 bitfields or RGB555), 24 bit (RGB888) and 32 bit
+//	- QOI (Quite OK Image format), RGB and RGBA (alpha is ignored)
+
+#define MENU_IMAGE_CHUNK	1024	//Input buffer, must be multiple of 512 (sector size)
+#define MENU_IMAGE_CLMT		32		//Fast seek table, file with N fragments needs 2*N+2 items
+
+typedef enum {
+	MENU_IMAGE_OK,
+	MENU_IMAGE_ERROR_FILE,		//File could not be opened
+	MENU_IMAGE_ERROR_FORMAT,	//Unknown or unsupported format
+	MENU_IMAGE_ERROR_READ			//Read error or file too short
+}menu_image_result;
+
+//Draw image with top left corner at x, y. Parts outside of display clip are not drawn
+menu_image_result menu_image_draw(char* path, uint16_t x, uint16_t y);
+//Same as above, file has to be opened for reading and pointer must be at beginning
+menu_image_result menu_image_draw_file(FIL* file, uint16_t x, uint16_t y);
+//Returns 1 if file name ends with known image extension
+uint8_t menu_image_supported(char* name);
+
+#endif
@@ -0,0 +1,212 @@
+#include "menu_log.h"
+#include "menu_remote.h"
+#include "USART.h"
+#if MENU_LOG_FILE == 1
+#include "menu_logfile.h"
+#endif
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+#define LOG_TLS_INDEX		0						//Thread local storage pointer with task ring
+#define LOG_MARKER			0xFFFFFF00	//Output word: following records are from ring (low byte)
+#define LOG_BATCH				(MENU_REMOTE_PAYLOAD/4)
+
+typedef struct log_ring{
+	uint32_t* words;
+	uint32_t mask;
+	volatile uint32_t head;		//Written only by owner
+	volatile uint32_t tail;		//Written only by drain task
+	volatile uint32_t dropped;
+	uint32_t reported;
+}log_ring;
+
+volatile uint32_t menu_log_dropped = 0;
+
+static uint32_t log_words[MENU_LOG_RINGS][MENU_LOG_RING_WORDS];
+static uint32_t log_common_words[MENU_LOG_COMMON_WORDS];
+static log_ring log_rings[MENU_LOG_RINGS + 1];		//Last one is common
+static uint8_t log_registered = 0;
+static volatile uint8_t log_running = 0;			//Scheduler is running, task rings can be used
+static uint32_t log_batch[LOG_BATCH];
+
+static void log_put(log_ring* ring, uint32_t header, uint32_t* arguments, uint8_t count){
+	uint32_t head = ring->head, i;
+	if(ring->mask + 1 - (head - ring->tail) < (uint32_t)count + 2){
+		ring->dropped++;
+		return;
+	}
+	ring->words[head & ring->mask] = header;
+	ring->words[(head + 1) & ring->mask] = DWT->CYCCNT;
+	for(i = 0; i < count; i++) ring->words[(head + 2 + i) & ring->mask] = arguments[i];
+	__DMB();	//Record is complete before drain task can see it
+	ring->head = head + count + 2;
+}
+
+static void log_write(uint32_t header, uint32_t* arguments, uint8_t count){
+	log_ring* ring = NULL;
+	uint32_t primask;
+	if(log_running && __get_IPSR() == 0){
+		ring = (log_ring*)pvTaskGetThreadLocalStoragePointer(NULL, LOG_TLS_INDEX);
+	}
+	if(ring != NULL){
+		log_put(ring, header, arguments, count);
+		return;
+	}
+	primask = __get_PRIMASK();
+	__disable_irq();
+	log_put(&log_rings[MENU_LOG_RINGS], header, arguments, count);
+	__set_PRIMASK(primask);
+}
+
+#define LOG_HEADER(format, count)	(((uint32_t)(count) << 28) | ((uint32_t)(format) & 0x0FFFFFFF))
+
+void menu_log_write0(const char* format){
+	log_write(LOG_HEADER(format, 0), NULL, 0);
+}
+
+void menu_log_write1(const char* format, uint32_t a){
+	log_write(LOG_HEADER(format, 1), &a, 1);
+}
+
+void menu_log_write2(const char* format, uint32_t a, uint32_t b){
+	uint32_t arguments[2];
+	arguments[0] = a;
+	arguments[1] = b;
+	log_write(LOG_HEADER(format, 2), arguments, 2);
+}
+
+void menu_log_write3(const char* format, uint32_t a, uint32_t b, uint32_t c){
+	uint32_t arguments[3];
+	arguments[0] = a;
+	arguments[1] = b;
+	arguments[2] = c;
+	log_write(LOG_HEADER(format, 3), arguments, 3);
+}
+
+void menu_log_write4(const char* format, uint32_t a, uint32_t b, uint32_t c, uint32_t d){
+	uint32_t arguments[4];
+	arguments[0] = a;
+	arguments[1] = b;
+	arguments[2] = c;
+	arguments[3] = d;
+	log_write(LOG_HEADER(format, 4), arguments, 4);
+}
+
+uint8_t menu_log_register(){
+	log_ring* ring;
+	uint32_t name[4];
+	taskENTER_CRITICAL();
+	if(log_registered == MENU_LOG_RINGS){
+		taskEXIT_CRITICAL();
+		return 0;
+	}
+	ring = &log_rings[log_registered++];
+	taskEXIT_CRITICAL();
+	vTaskSetThreadLocalStoragePointer(NULL, LOG_TLS_INDEX, ring);
+
+	//Task name for decoder, it is in RAM so it is sent as arguments
+	memset(name, 0, sizeof(name));
+	strncpy((char*)name, pcTaskGetTaskName(NULL), sizeof(name));
+	log_write(LOG_HEADER(MENU_LOG_TASK, 4), name, 4);
+	return 1;
+}
+
+static void log_output(uint32_t* words, uint16_t count, uint8_t ring){
+#if MENU_LOG_FILE == 1
+	menu_logfile_write((uint8_t*)words, count*4);
+#endif
+#if MENU_LOG_OUTPUT == MENU_LOG_SWO
+	uint16_t i;
+	if(!(ITM->TCR & ITM_TCR_ITMENA_Msk) || !(ITM->TER & (1UL << MENU_LOG_SWO_PORT))) return;	//No debugger
+	for(i = 0; i < count; i++){
+		while(ITM->PORT[MENU_LOG_SWO_PORT].u32 == 0);
+		ITM->PORT[MENU_LOG_SWO_PORT].u32 = words[i];
+	}
+#else
+	if(USART1_Interactive != USART1_BINARY) return;
+	menu_remote_send(MENU_REMOTE_LOG, ring, MENU_REMOTE_OK, (uint8_t*)words, count*4);
+#endif
+}
+
+//Copy whole records from ring to batch and send them
+static void log_drain(log_ring* ring, uint8_t index){
+	uint32_t tail = ring->tail, head = ring->head, size, dropped, i;
+	uint16_t count = 0;
+
+	dropped = ring->dropped;
+	if(dropped != ring->reported){
+		log_batch[count++] = LOG_MARKER | index;
+		log_batch[count++] = LOG_HEADER(MENU_LOG_DROPPED, 1);
+		log_batch[count++] = DWT->CYCCNT;
+		log_batch[count++] = dropped - ring->reported;
+		menu_log_dropped += dropped - ring->reported;
+		ring->reported = dropped;
+	}
+	while(tail != head){
+		if(count == 0) log_batch[count++] = LOG_MARKER | index;
+		size = (ring->words[tail & ring->mask] >> 28) + 2;
+		if(count + size > LOG_BATCH){
+			log_output(log_batch, count, index);
+			count = 0;
+			continue;
+		}
+		for(i = 0; i < size; i++) log_batch[count++] = ring->words[(tail + i) & ring->mask];
+		tail = tail + size;
+		ring->tail = tail;	//Space is free as soon as record is copied
+	}
+	if(count > 0) log_output(log_batch, count, index);
+}
+
+//Records are kept in rings while there is no output which would take them
+static uint8_t log_ready(){
+#if MENU_LOG_FILE == 1
+	if(menu_logfile_is_open()) return 1;
+#endif
+#if MENU_LOG_OUTPUT == MENU_LOG_REMOTE
+	return USART1_Interactive == USART1_BINARY;		//Nobody is reading binary frames
+#else
+	return 1;
+#endif
+}
+
+static void log_task(void* parameters){
+	uint8_t i;
+#if MENU_LOG_FILE == 1
+	TickType_t opened = xTaskGetTickCount() - MENU_LOG_FILE_RETRY/portTICK_PERIOD_MS;
+#endif
+	log_running = 1;
+	while(1){
+		vTaskDelay(MENU_LOG_PERIOD/portTICK_PERIOD_MS);
+#if MENU_LOG_FILE == 1
+		if(!menu_logfile_is_open() && xTaskGetTickCount() - opened >= MENU_LOG_FILE_RETRY/portTICK_PERIOD_MS){
+			opened = xTaskGetTickCount();
+			if(menu_logfile_open() == FR_OK) LOG0("Log file opened");
+		}
+		if(menu_logfile_is_open() && menu_logfile_service() != FR_OK){
+			menu_logfile_close();	//Disk removed or full, try again later
+		}
+#endif
+		if(!log_ready()) continue;
+		for(i = 0; i <= MENU_LOG_RINGS; i++) log_drain(&log_rings[i], i);
+	}
+}
+
+void menu_log_init(){
+	uint8_t i;
+	for(i = 0; i < MENU_LOG_RINGS; i++){
+		log_rings[i].words = log_words[i];
+		log_rings[i].mask = MENU_LOG_RING_WORDS - 1;
+	}
+	log_rings[MENU_LOG_RINGS].words = log_common_words;
+	log_rings[MENU_LOG_RINGS].mask = MENU_LOG_COMMON_WORDS - 1;
+
+	//Cycle counter for timestamps
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#if MENU_LOG_OUTPUT == MENU_LOG_SWO
+	DBGMCU->CR |= DBGMCU_CR_TRACE_IOEN;	//SWO pin, rest is set by debugger
+#endif
+	xTaskCreate(log_task, "Log", MENU_LOG_STACK, NULL, MENU_LOG_PRIORITY, NULL);
+}
@@ -0,0 +1,68 @@
+#ifndef MENU_LOG_H
+#define MENU_LOG_H
+
+#include <stdint.h>
+
+//Deferred binary logging.
+//Call site stores only address of format string, cycle counter and raw 32-bit arguments in a ring,
+//text is never formatted on target. Low priority task sends records later (SWO or remote link),
+//Tools/log_decode.py reads format strings from .axf file and prints them.
+//
+//Each registered task has its own ring with single writer, so writing needs no lock.
+//Interrupts and unregistered tasks share one ring, written with interrupts disabled.
+//When ring is full, new records are dropped and counted.
+//
+//Format must be string literal (it is read from flash by decoder), arguments are integers,
+//%s only for string literals. Up to 4 arguments.
+//
+//Record in ring and output (32-bit words, little endian):
+//	[argument count << 28 | format address][DWT cycle counter][arguments...]
+//Log file contains the same words as output, including ring markers.
+//Special formats: address MENU_LOG_DROPPED [dropped records], MENU_LOG_TASK [task name, 16 chars]
+
+#define MENU_LOG_ENABLED		1
+#define MENU_LOG_RINGS			4				//Rings for registered tasks
+#define MENU_LOG_RING_WORDS	256			//Power of 2
+#define MENU_LOG_COMMON_WORDS	256		//Ring for interrupts and unregistered tasks, power of 2
+#define MENU_LOG_PERIOD			20			//ms between drains
+#define MENU_LOG_PRIORITY		1				//Same as menu, it never blocks
+#define MENU_LOG_STACK			256
+
+#define MENU_LOG_SWO				0
+#define MENU_LOG_REMOTE			1				//MENU_REMOTE_LOG frames, only while remote link is in binary mode
+#define MENU_LOG_OUTPUT			MENU_LOG_REMOTE
+#define MENU_LOG_SWO_PORT		1				//ITM stimulus port, 0 is used for text
+#define MENU_LOG_FILE				0				//1 to store output also in log file on disk (menu_logfile.h)
+#define MENU_LOG_FILE_RETRY	5000		//ms between attempts to open log file (disk can be connected later)
+
+#define MENU_LOG_DROPPED		1
+#define MENU_LOG_TASK				2
+
+extern volatile uint32_t menu_log_dropped;
+
+//Start cycle counter and drain task, call before scheduler is started
+void menu_log_init();
+//Give calling task its own ring, returns 0 if there is no free ring (task then uses common ring)
+uint8_t menu_log_register();
+
+void menu_log_write0(const char* format);
+void menu_log_write1(const char* format, uint32_t a);
+void menu_log_write2(const char* format, uint32_t a, uint32_t b);
+void menu_log_write3(const char* format, uint32_t a, uint32_t b, uint32_t c);
+void menu_log_write4(const char* format, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+
+#if MENU_LOG_ENABLED == 1
+#define LOG0(format)						menu_log_write0(format)
+#define LOG1(format, a)					menu_log_write1(format, (uint32_t)(a))
+#define LOG2(format, a, b)			menu_log_write2(format, (uint32_t)(a), (uint32_t)(b))
+#define LOG3(format, a, b, c)		menu_log_write3(format, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#define LOG4(format, a, b, c, d)	menu_log_write4(format, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+#else
+#define LOG0(format)
+#define LOG1(format, a)
+#define LOG2(format, a, b)
+#define LOG3(format, a, b, c)
+#define LOG4(format, a, b, c, d)
+#endif
+
+#endif
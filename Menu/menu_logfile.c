@@ -0,0 +1,226 @@
+#include "menu_logfile.h"
+#include "tm_stm32f4_fatfs.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOGFILE_SECTOR		512
+
+static FATFS logfile_fatfs;
+static uint8_t logfile_open = 0;
+static uint8_t logfile_buffer[MENU_LOGFILE_BUFFER];
+static uint32_t logfile_count = 0;		//Bytes in buffer
+static uint32_t logfile_position;			//Where buffer will be written (file size or ring head)
+static uint32_t logfile_unsynced = 0;	//Bytes written since last sync
+static TickType_t logfile_synced;
+static FRESULT logfile_error = FR_OK;
+
+#if MENU_LOGFILE_RING == 1
+static TM_FATFS_Ring_t logfile_ring;
+#else
+static FIL logfile;
+static uint32_t logfile_index;
+#endif
+
+#if MENU_LOGFILE_RING == 1
+
+//Existing ring is continued if header is valid, otherwise file is created and allocated
+static FRESULT logfile_start(){
+	FRESULT result = TM_FATFS_RingOpen(&logfile_ring, MENU_LOGFILE_RING_NAME, MENU_LOGFILE_RING_SIZE);
+	logfile_position = logfile_ring.Header.Head;
+	return result;
+}
+
+//Write at head, oldest whole sectors are dropped when ring is full
+static FRESULT logfile_store(const uint8_t* data, uint32_t length){
+	FRESULT result = TM_FATFS_RingWrite(&logfile_ring, data, length);
+	logfile_position = logfile_ring.Header.Head;
+	return result;
+}
+
+//Header is written after data
+static FRESULT logfile_commit(){
+	return TM_FATFS_RingSync(&logfile_ring);
+}
+
+static void logfile_end(){
+	f_close(&logfile_ring.File);
+}
+
+#else
+
+static void logfile_name(char* name, uint32_t index){
+	sprintf(name, "%s/L%07lu.BIN", MENU_LOGFILE_DIR, (unsigned long)index);
+}
+
+//Number of last log file, 0 if there is none
+static uint32_t logfile_last(){
+	DIR dir;
+	FILINFO info;
+	uint32_t index, last = 0;
+	uint8_t i;
+	if(f_opendir(&dir, MENU_LOGFILE_DIR) != FR_OK) return 0;
+	while(f_readdir(&dir, &info) == FR_OK && info.fname[0]){
+		if(info.fname[0] != 'L') continue;
+		index = 0;
+		for(i = 1; info.fname[i] >= '0' && info.fname[i] <= '9'; i++) index = index*10 + info.fname[i] - '0';
+		if(i == 8 && index > last) last = index;
+	}
+	f_closedir(&dir);
+	return last;
+}
+
+//Last file is continued if it is not full
+static FRESULT logfile_start(){
+	char name[32];
+	FRESULT result;
+	logfile_index = logfile_last();
+	logfile_name(name, logfile_index);
+	result = f_open(&logfile, name, FA_WRITE | FA_OPEN_ALWAYS);
+	if(result != FR_OK) return result;
+	if(f_size(&logfile) >= MENU_LOGFILE_SIZE){
+		f_close(&logfile);
+		logfile_index++;
+		logfile_name(name, logfile_index);
+		result = f_open(&logfile, name, FA_WRITE | FA_CREATE_ALWAYS);
+		if(result != FR_OK) return result;
+	}
+	logfile_position = f_size(&logfile);
+	return f_lseek(&logfile, logfile_position);
+}
+
+static FRESULT logfile_rotate(){
+	char name[32];
+	FRESULT result = f_close(&logfile);
+	if(result != FR_OK) return result;
+	logfile_index++;
+	if(logfile_index >= MENU_LOGFILE_FILES){
+		logfile_name(name, logfile_index - MENU_LOGFILE_FILES);
+		f_unlink(name);	//Can be already deleted
+	}
+	logfile_name(name, logfile_index);
+	result = f_open(&logfile, name, FA_WRITE | FA_CREATE_ALWAYS);
+	logfile_position = 0;
+	return result;
+}
+
+//Append, new file is started when size is reached
+static FRESULT logfile_store(const uint8_t* data, uint32_t length){
+	uint32_t chunk;
+	UINT written;
+	FRESULT result;
+	while(length > 0){
+		if(logfile_position >= MENU_LOGFILE_SIZE){
+			result = logfile_rotate();
+			if(result != FR_OK) return result;
+		}
+		chunk = MENU_LOGFILE_SIZE - logfile_position;
+		if(chunk > length) chunk = length;
+		result = f_write(&logfile, data, chunk, &written);
+		if(result != FR_OK) return result;
+		if(written != chunk) return FR_DENIED;	//Disk full
+		logfile_position += chunk;
+		data = data + chunk;
+		length = length - chunk;
+	}
+	return FR_OK;
+}
+
+static FRESULT logfile_commit(){
+	return f_sync(&logfile);
+}
+
+static void logfile_end(){
+	f_close(&logfile);
+}
+
+#endif
+
+//Write whole sectors from buffer (first block may be shorter, to get back to sector boundary)
+static FRESULT logfile_flush(uint8_t partial){
+	uint32_t length = logfile_count, first;
+	FRESULT result;
+	if(!partial){
+		first = (LOGFILE_SECTOR - (logfile_position & (LOGFILE_SECTOR - 1))) & (LOGFILE_SECTOR - 1);
+		if(length < first + LOGFILE_SECTOR) return FR_OK;
+		length = first + ((length - first) & ~(LOGFILE_SECTOR - 1));
+	}
+	if(length == 0) return FR_OK;
+	result = logfile_store(logfile_buffer, length);
+	logfile_count -= length;
+	memmove(logfile_buffer, logfile_buffer + length, logfile_count);
+	logfile_unsynced += length;
+	return result;
+}
+
+FRESULT menu_logfile_open(){
+	FRESULT result;
+	if(logfile_open) return FR_OK;
+	result = f_mount(&logfile_fatfs, MENU_LOGFILE_VOLUME, 1);
+	if(result != FR_OK) return result;
+	result = f_mkdir(MENU_LOGFILE_DIR);
+	if(result != FR_OK && result != FR_EXIST) return result;
+	result = logfile_start();
+	if(result != FR_OK) return result;
+	logfile_count = 0;
+	logfile_unsynced = 0;
+	logfile_synced = xTaskGetTickCount();
+	logfile_error = FR_OK;
+	logfile_open = 1;
+	return FR_OK;
+}
+
+FRESULT menu_logfile_close(){
+	FRESULT result;
+	if(!logfile_open) return FR_OK;
+	result = menu_logfile_sync();
+	logfile_end();
+	logfile_open = 0;
+	return result;
+}
+
+FRESULT menu_logfile_write(const uint8_t* data, uint32_t length){
+	uint32_t part;
+	if(!logfile_open) return FR_NOT_READY;
+	if(logfile_error != FR_OK) return logfile_error;
+	while(length > 0){
+		part = MENU_LOGFILE_BUFFER - logfile_count;
+		if(part > length) part = length;
+		memcpy(logfile_buffer + logfile_count, data, part);
+		logfile_count += part;
+		data = data + part;
+		length = length - part;
+		//Disk is written only when buffer is almost full
+		if(logfile_count > MENU_LOGFILE_BUFFER - LOGFILE_SECTOR){
+			logfile_error = logfile_flush(0);
+			if(logfile_error != FR_OK) return logfile_error;
+		}
+	}
+	return FR_OK;
+}
+
+FRESULT menu_logfile_sync(){
+	if(!logfile_open) return FR_NOT_READY;
+	if(logfile_error == FR_OK) logfile_error = logfile_flush(1);
+	if(logfile_error == FR_OK) logfile_error = logfile_commit();
+	logfile_unsynced = 0;
+	logfile_synced = xTaskGetTickCount();
+	return logfile_error;
+}
+
+FRESULT menu_logfile_service(){
+	if(!logfile_open) return FR_NOT_READY;
+	if(logfile_unsynced + logfile_count == 0){
+		logfile_synced = xTaskGetTickCount();
+		return logfile_error;
+	}
+	if(logfile_unsynced >= MENU_LOGFILE_SYNC_BYTES || (xTaskGetTickCount() - logfile_synced) >= MENU_LOGFILE_SYNC_TIME/portTICK_PERIOD_MS){
+		return menu_logfile_sync();
+	}
+	return logfile_error;
+}
+
+uint8_t menu_logfile_is_open(){
+	return logfile_open;
+}
@@ -0,0 +1,42 @@
+#ifndef MENU_LOGFILE_H
+#define MENU_LOGFILE_H
+
+#include <stdint.h>
+#include "ff.h"
+
+//Log stream (or any other byte stream) written to disk.
+//Bytes are collected in RAM and written in big blocks which end on sector boundary,
+//so a line costs a memcpy, not a sector write. Partial sector is written only by menu_logfile_sync.
+//
+//Sync policy: data is synced (f_sync) after MENU_LOGFILE_SYNC_BYTES or MENU_LOGFILE_SYNC_TIME ms,
+//after power loss only data after last sync is lost.
+//
+//Two modes:
+//	rotation:	files L0000000.BIN, L0000001.BIN... in MENU_LOGFILE_DIR, new file after MENU_LOGFILE_SIZE bytes,
+//						only last MENU_LOGFILE_FILES files are kept
+//	ring:			one preallocated file MENU_LOGFILE_RING_NAME (TM_FATFS_Ring_t), first sector is header with
+//						head/tail offsets, data wraps around and oldest sectors are dropped by moving tail (nothing is copied).
+//						Header is written only after data is synced, so it never points to data which is not on disk.
+//
+//Volume is mounted by menu_logfile_open and must stay mounted while log is open.
+//Only one task may use log file (FatFs is not reentrant in this configuration).
+
+#define MENU_LOGFILE_VOLUME			"0:"
+#define MENU_LOGFILE_DIR				"0:/LOG"
+#define MENU_LOGFILE_RING				0							//1 for ring file, 0 for rotation
+#define MENU_LOGFILE_BUFFER			4096					//Multiple of 512
+#define MENU_LOGFILE_SIZE				(1024*1024)		//Rotation: max size of one file
+#define MENU_LOGFILE_FILES			8							//Rotation: files which are kept
+#define MENU_LOGFILE_RING_NAME	"0:/LOG/RING.BIN"
+#define MENU_LOGFILE_RING_SIZE	(256*1024)		//Ring: data size without header, multiple of 512
+#define MENU_LOGFILE_SYNC_BYTES	(16*1024)
+#define MENU_LOGFILE_SYNC_TIME	2000					//ms
+
+FRESULT menu_logfile_open();
+FRESULT menu_logfile_close();
+FRESULT menu_logfile_write(const uint8_t* data, uint32_t length);
+FRESULT menu_logfile_sync();		//Write partial sector and sync now
+FRESULT menu_logfile_service();	//Call periodically, syncs by policy
+uint8_t menu_logfile_is_open();
+
+#endif
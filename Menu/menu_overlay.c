@@ -0,0 +1,208 @@
+#include "menu_overlay.h"
+#include "menu_display.h"
+#include "menu_system.h"
+#include "menu_text.h"
+#include "menu_button.h"
+#include "menu_touch.h"
+#include "menu_event.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stddef.h>
+
+#define OVERLAY_RUN_MAX		255
+
+static menu_overlay overlay_stack[MENU_OVERLAY_DEPTH];
+static uint8_t overlay_count = 0;
+static uint8_t overlay_pool[MENU_OVERLAY_POOL];
+static uint32_t overlay_pool_used = 0;
+static uint8_t overlay_row[MENU_WIDTH*2];
+static uint8_t overlay_damage = 0;
+
+static menu_overlay* toast = NULL;
+static TickType_t toast_end;
+
+//Read rectangle row by row and compress it in pool as runs: [count][high byte][low byte]
+static uint8_t* overlay_save(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2){
+	uint8_t* start = overlay_pool + overlay_pool_used;
+	uint8_t* out = start;
+	uint8_t* end = overlay_pool + MENU_OVERLAY_POOL;
+	uint16_t width = x2 - x1 + 1, row, i, run;
+
+	for(row = y1; row <= y2; row++){
+		menu_display_read(x1, row, x2, row, overlay_row);
+		for(i = 0; i < width; i = i + run){
+			run = 1;
+			while(i + run < width && run < OVERLAY_RUN_MAX &&
+				overlay_row[(i+run)*2] == overlay_row[i*2] && overlay_row[(i+run)*2+1] == overlay_row[i*2+1]){
+				run++;
+			}
+			if(out + 3 > end) return NULL;	//Pool is full
+			*out++ = run;
+			*out++ = overlay_row[i*2];
+			*out++ = overlay_row[i*2+1];
+		}
+	}
+	overlay_pool_used = out - overlay_pool;
+	return start;
+}
+
+//Decompress saved pixels back to display, one window for whole rectangle
+static void overlay_restore(menu_overlay* overlay){
+	uint8_t* in = overlay->saved;
+	uint16_t width = overlay->x2 - overlay->x1 + 1, row, i, run;
+
+	menu_display_window(overlay->x1, overlay->y1, overlay->x2, overlay->y2);
+	for(row = overlay->y1; row <= overlay->y2; row++){
+		for(i = 0; i < width; in = in + 3){
+			for(run = in[0]; run > 0; run--, i++){
+				overlay_row[i*2] = in[1];
+				overlay_row[i*2+1] = in[2];
+			}
+		}
+		menu_display_write(overlay_row, width*2);
+	}
+	overlay_pool_used = overlay->saved - overlay_pool;
+}
+
+menu_overlay* menu_overlay_open(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2){
+	menu_overlay* overlay;
+	if(overlay_count == MENU_OVERLAY_DEPTH) return NULL;
+	if(x2 > MENU_WIDTH - 1) x2 = MENU_WIDTH - 1;
+	if(y2 > MENU_HEIGHT - 1) y2 = MENU_HEIGHT - 1;
+	if(x1 > x2 || y1 > y2) return NULL;
+	if(!menu_display_push_clip(x1, y1, x2, y2)) return NULL;
+
+	overlay = &overlay_stack[overlay_count++];
+	overlay->x1 = x1;
+	overlay->y1 = y1;
+	overlay->x2 = x2;
+	overlay->y2 = y2;
+	overlay->saved = overlay_save(x1, y1, x2, y2);
+	return overlay;
+}
+
+void menu_overlay_close(menu_overlay* overlay){
+	menu_overlay* top;
+	while(overlay_count > 0){
+		top = &overlay_stack[--overlay_count];
+		menu_display_pop_clip();
+		if(top->saved != NULL){
+			overlay_restore(top);
+		}
+		else{
+			overlay_damage = 1;
+		}
+		if(top == toast) toast = NULL;
+		if(top == overlay) break;
+	}
+}
+
+void menu_overlay_close_all(){
+	if(overlay_count > 0) menu_overlay_close(&overlay_stack[0]);
+}
+
+void menu_overlay_discard(){
+	while(overlay_count > 0){
+		overlay_count--;
+		menu_display_pop_clip();
+	}
+	overlay_pool_used = 0;
+	toast = NULL;
+}
+
+uint8_t menu_overlay_damaged(){
+	return overlay_damage;
+}
+
+void menu_overlay_clear_damage(){
+	overlay_damage = 0;
+}
+
+//Button with centered label
+static void dialog_button(menu_button* button, char* label){
+	button->line_color = BLACK;
+	button->fill_color = WHITE;
+	menu_draw_button(button);
+	menu_text_draw(button->X1 + 1, button->Y1 + (button->Y2 - button->Y1 - TM_Font_7x10.FontHeight)/2, button->X2 - 1, label, &TM_Font_7x10, MENU_TEXT_CENTER, BLACK, TRANSPARENT);
+}
+
+uint8_t menu_dialog(char* title, char* text, char* yes, char* no){
+	menu_overlay* overlay;
+	menu_button yes_button, no_button;
+	touch_gesture move;
+	uint16_t x, y;
+	uint8_t result = 2;
+
+	overlay = menu_overlay_open(MENU_DIALOG_X1, MENU_DIALOG_Y1, MENU_DIALOG_X2, MENU_DIALOG_Y2);
+	if(overlay == NULL) return 0;
+
+	//Frame, title bar and text
+	menu_display_fill(WHITE);
+	menu_display_draw_filled_rectangle(MENU_DIALOG_X1, MENU_DIALOG_Y1, MENU_DIALOG_X2, MENU_DIALOG_Y1 + 24, BLUE2);
+	menu_display_draw_rectangle(MENU_DIALOG_X1, MENU_DIALOG_Y1, MENU_DIALOG_X2, MENU_DIALOG_Y2, BLACK);
+	menu_text_draw(MENU_DIALOG_X1 + 5, MENU_DIALOG_Y1 + 3, MENU_DIALOG_X2 - 5, title, &TM_Font_11x18, MENU_TEXT_LEFT, WHITE, TRANSPARENT);
+	menu_text_draw_wrapped(MENU_DIALOG_X1 + 5, MENU_DIALOG_Y1 + 30, MENU_DIALOG_X2 - 5, MENU_DIALOG_Y2 - 36, text, &TM_Font_7x10, MENU_TEXT_LEFT, BLACK, TRANSPARENT);
+
+	//Buttons
+	yes_button.Y1 = no_button.Y1 = MENU_DIALOG_Y2 - 30;
+	yes_button.Y2 = no_button.Y2 = MENU_DIALOG_Y2 - 6;
+	if(no != NULL){
+		no_button.X1 = MENU_DIALOG_X1 + 10;
+		no_button.X2 = MENU_DIALOG_X1 + 90;
+		yes_button.X1 = MENU_DIALOG_X2 - 90;
+		yes_button.X2 = MENU_DIALOG_X2 - 10;
+		dialog_button(&no_button, no);
+	}
+	else{
+		yes_button.X1 = (MENU_DIALOG_X1 + MENU_DIALOG_X2)/2 - 40;
+		yes_button.X2 = (MENU_DIALOG_X1 + MENU_DIALOG_X2)/2 + 40;
+	}
+	dialog_button(&yes_button, yes);
+
+	while(result == 2){
+		move = menu_touch_gesture(&x, &y);
+		if(get_key('d') || get_key(13)) result = 1;
+		else if(get_key('a') || get_key(27)) result = 0;
+		else if(move == TOUCH_CLICK){
+			if(check_button_pressed(&yes_button, x, y)) result = 1;
+			else if(no != NULL && check_button_pressed(&no_button, x, y)) result = 0;
+		}
+	}
+
+	menu_overlay_close(overlay);
+	return result;
+}
+
+uint8_t menu_dialog_confirm(char* title, char* text){
+	return menu_dialog(title, text, "Yes", "No");
+}
+
+void menu_dialog_message(char* title, char* text){
+	menu_dialog(title, text, "OK", NULL);
+}
+
+void menu_toast_show(char* text, uint16_t time){
+	menu_text_layout* layout = menu_text_measure(text, &TM_Font_7x10);
+	uint16_t width = layout->width + 16;
+	uint16_t x1;
+
+	if(toast != NULL) menu_overlay_close(toast);
+	if(width > MENU_WIDTH - 20) width = MENU_WIDTH - 20;
+	x1 = (MENU_WIDTH - width)/2;
+
+	toast = menu_overlay_open(x1, MENU_HEIGHT - 34, x1 + width - 1, MENU_HEIGHT - 15);
+	if(toast == NULL) return;
+	menu_display_fill(GRAY);
+	menu_text_draw(x1 + 4, MENU_HEIGHT - 29, x1 + width - 5, text, &TM_Font_7x10, MENU_TEXT_CENTER, WHITE, TRANSPARENT);
+	toast_end = xTaskGetTickCount() + time/portTICK_PERIOD_MS;
+}
+
+void menu_toast_update(){
+	if(toast != NULL && (int32_t)(xTaskGetTickCount() - toast_end) >= 0){
+		menu_overlay_close(toast);
+	}
+}
+
+void menu_toast_hide(){
+	if(toast != NULL) menu_overlay_close(toast);
+}
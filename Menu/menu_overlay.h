@@ -0,0 +1,51 @@
+#ifndef MENU_OVERLAY_H
+#define MENU_OVERLAY_H
+
+#include <stdint.h>
+
+//Overlay layer for popups, dialogs and toasts.
+//Pixels under overlay are read from display memory before it is drawn and written back when it is closed,
+//so closing a popup costs only its own rectangle instead of whole screen repaint.
+//Saved pixels are RLE compressed (menu background is mostly flat) in one pool, used as a stack.
+//If pool is full, overlay still works, but closing it marks screen as damaged and menu is repainted.
+
+#define MENU_OVERLAY_POOL		16384	//Bytes for saved pixels of all open overlays
+#define MENU_OVERLAY_DEPTH	4				//Max open overlays
+
+#define MENU_DIALOG_X1			20
+#define MENU_DIALOG_Y1			100
+#define MENU_DIALOG_X2			219
+#define MENU_DIALOG_Y2			209
+#define MENU_TOAST_TIME			1500		//Default toast time in ms
+
+typedef struct overlay{
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;
+	uint16_t y2;
+	uint8_t* saved;		//RLE pixels in pool, NULL if they could not be saved
+}menu_overlay;
+
+//Save pixels under rectangle and set clip to it. Returns NULL if too many overlays are open
+menu_overlay* menu_overlay_open(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+//Restore pixels, overlays opened after this one are closed first
+void menu_overlay_close(menu_overlay* overlay);
+void menu_overlay_close_all();
+//Forget all overlays without restoring, used when whole screen is repainted anyway
+void menu_overlay_discard();
+//Returns 1 if overlay was closed without saved pixels, screen has to be repainted
+uint8_t menu_overlay_damaged();
+void menu_overlay_clear_damage();
+
+//Modal dialog, returns 1 for yes button ('d', Enter), 0 for no button ('a', Esc).
+//If no is NULL only one button is drawn.
+uint8_t menu_dialog(char* title, char* text, char* yes, char* no);
+uint8_t menu_dialog_confirm(char* title, char* text);
+void menu_dialog_message(char* title, char* text);
+
+//Toast is not modal, it is closed by menu_toast_update after time (ms) or by menu_toast_hide
+void menu_toast_show(char* text, uint16_t time);
+void menu_toast_update();
+void menu_toast_hide();
+
+#endif
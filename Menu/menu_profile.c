@@ -0,0 +1,112 @@
+#include "menu_profile.h"
+#include "task.h"
+#include <string.h>
+
+typedef struct profile_previous{
+	TaskHandle_t handle;
+	uint32_t counter;
+}profile_previous;
+
+menu_profile_timer menu_profile_timers[MENU_PROFILE_TIMERS] = {
+	{"display_menu", 0, 0, 0},
+	{"LCD fill", 0, 0, 0},
+	{"disk_read", 0, 0, 0}
+};
+
+static TaskStatus_t profile_status[MENU_PROFILE_TASKS];
+static profile_previous profile_previous_tasks[MENU_PROFILE_TASKS];
+static uint8_t profile_previous_count = 0;
+static uint32_t profile_previous_total;
+static TickType_t profile_sampled;
+static uint8_t profile_started = 0;
+static menu_profile_task profile_result[MENU_PROFILE_TASKS];
+static uint8_t profile_result_count = 0;
+
+void menu_profile_clock_init(void){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;		//Counter is not reset, log timestamps use it too
+}
+
+static uint32_t profile_previous_counter(TaskHandle_t handle, uint8_t* found){
+	uint8_t i;
+	for(i = 0; i < profile_previous_count; i++){
+		if(profile_previous_tasks[i].handle == handle){
+			*found = 1;
+			return profile_previous_tasks[i].counter;
+		}
+	}
+	*found = 0;
+	return 0;
+}
+
+//Difference from previous sample, result is 0 tasks if previous is missing or too old
+static void profile_update(){
+	static const char states[] = "RRBSD";
+	UBaseType_t count, i;
+	uint32_t total, elapsed, counter;
+	uint8_t found;
+	TickType_t now = xTaskGetTickCount();
+	menu_profile_task* task;
+
+	count = uxTaskGetSystemState(profile_status, MENU_PROFILE_TASKS, &total);
+	elapsed = total - profile_previous_total;
+	profile_result_count = 0;
+	if(profile_started && (now - profile_sampled) <= MENU_PROFILE_MAX_WINDOW/portTICK_PERIOD_MS && elapsed > 0){
+		for(i = 0; i < count; i++){
+			counter = profile_previous_counter(profile_status[i].xHandle, &found);
+			if(!found) counter = profile_status[i].ulRunTimeCounter;	//New task, it is counted from next window
+			task = &profile_result[profile_result_count++];
+			strncpy(task->name, profile_status[i].pcTaskName, configMAX_TASK_NAME_LEN);
+			task->name[configMAX_TASK_NAME_LEN - 1] = 0;
+			task->cpu = (uint16_t)((uint64_t)(profile_status[i].ulRunTimeCounter - counter) * 1000 / elapsed);
+			task->stack = profile_status[i].usStackHighWaterMark * sizeof(StackType_t);
+			task->priority = profile_status[i].uxCurrentPriority;
+			task->state = states[profile_status[i].eCurrentState];
+		}
+	}
+	for(i = 0; i < count; i++){
+		profile_previous_tasks[i].handle = profile_status[i].xHandle;
+		profile_previous_tasks[i].counter = profile_status[i].ulRunTimeCounter;
+	}
+	profile_previous_count = count;
+	profile_previous_total = total;
+	profile_sampled = now;
+	profile_started = 1;
+}
+
+uint8_t menu_profile_sample(menu_profile_task* tasks, uint8_t size){
+	uint8_t count;
+	vTaskSuspendAll();	//Menu and shell can sample at the same time
+	if(!profile_started || (xTaskGetTickCount() - profile_sampled) >= MENU_PROFILE_WINDOW/portTICK_PERIOD_MS){
+		profile_update();
+	}
+	count = profile_result_count < size ? profile_result_count : size;
+	memcpy(tasks, profile_result, count * sizeof(menu_profile_task));
+	xTaskResumeAll();
+	return count;
+}
+
+void menu_profile_reset_timers(){
+	uint8_t i;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	for(i = 0; i < MENU_PROFILE_TIMERS; i++){
+		menu_profile_timers[i].count = 0;
+		menu_profile_timers[i].total = 0;
+		menu_profile_timers[i].max = 0;
+	}
+	__set_PRIMASK(primask);
+}
+
+#if MENU_PROFILE_ENABLED == 1
+void menu_profile_stop(uint8_t timer, uint32_t start){
+	uint32_t cycles = DWT->CYCCNT - start;
+	uint32_t primask = __get_PRIMASK();
+	menu_profile_timer* profile = &menu_profile_timers[timer];
+	__disable_irq();
+	profile->count++;
+	profile->total += cycles;
+	if(cycles > profile->max) profile->max = cycles;
+	__set_PRIMASK(primask);
+}
+#endif
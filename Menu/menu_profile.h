@@ -0,0 +1,70 @@
+#ifndef MENU_PROFILE_H
+#define MENU_PROFILE_H
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "FreeRTOS.h"
+
+//CPU profiler.
+//FreeRTOS run time counters use DWT cycle counter (configGENERATE_RUN_TIME_STATS), so task time is
+//counted in CPU cycles. 32-bit counters wrap after 25 s, so CPU load is computed from difference of two
+//samples at least MENU_PROFILE_WINDOW apart (menu_profile_sample), not from totals since start.
+//
+//Hot path timers measure cycles of one code block:
+//	uint32_t start = menu_profile_start();
+//	...
+//	menu_profile_stop(MENU_PROFILE_DISPLAY_MENU, start);
+//Start time is on caller's stack, so the same timer can be used from more tasks.
+//
+//Results: "Stats" menu page (menu_functions.c), "tasks" and "timers" shell commands.
+
+#define MENU_PROFILE_ENABLED		1
+#define MENU_PROFILE_TASKS			8			//Max tasks in sample
+#define MENU_PROFILE_WINDOW			1000	//ms, shortest time between samples
+#define MENU_PROFILE_MAX_WINDOW	20000	//ms, longer window can hide cycle counter wrap, it is only restarted
+
+//Timers
+#define MENU_PROFILE_DISPLAY_MENU	0
+#define MENU_PROFILE_LCD_FILL			1
+#define MENU_PROFILE_DISK_READ		2
+#define MENU_PROFILE_TIMERS				3
+
+typedef struct profile_task{
+	char name[configMAX_TASK_NAME_LEN];
+	uint16_t cpu;						//0.1 %
+	uint16_t stack;					//Least free stack since start, bytes
+	uint8_t priority;
+	char state;							//R running/ready, B blocked, S suspended, D deleted
+}menu_profile_task;
+
+typedef struct profile_timer{
+	const char* name;
+	uint32_t count;
+	uint32_t total;					//Cycles
+	uint32_t max;						//Cycles
+}menu_profile_timer;
+
+extern menu_profile_timer menu_profile_timers[MENU_PROFILE_TIMERS];
+
+//Start cycle counter, called by FreeRTOS before scheduler starts (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS)
+void menu_profile_clock_init(void);
+
+//Tasks with CPU load in last window, returns number of tasks (0 until there are two samples).
+//Result is kept until window passes, so more callers see the same numbers.
+uint8_t menu_profile_sample(menu_profile_task* tasks, uint8_t size);
+
+void menu_profile_reset_timers();
+
+#if MENU_PROFILE_ENABLED == 1
+static __INLINE uint32_t menu_profile_start(){
+	return DWT->CYCCNT;
+}
+void menu_profile_stop(uint8_t timer, uint32_t start);
+#else
+#define menu_profile_start()				0
+#define menu_profile_stop(timer, start)
+#endif
+
+#define MENU_PROFILE_US(cycles)		((cycles)/(SystemCoreClock/1000000))
+
+#endif
@@ -0,0 +1,305 @@
+#include "menu_remote.h"
+#include "menu_system.h"
+#include "menu_display.h"
+#include "menu_event.h"
+#include "menu_touch.h"
+#include "menu_stream.h"
+#include "menu_shell.h"
+#include "USART.h"
+#include "tm_stm32f4_crc.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include <string.h>
+
+#define REMOTE_PAYLOAD_MAX	(3 + MENU_REMOTE_PAYLOAD + 4)		//Reply header, data, CRC
+#define REMOTE_TX_MAX				(REMOTE_PAYLOAD_MAX + REMOTE_PAYLOAD_MAX/254 + 3)
+
+volatile uint32_t menu_remote_frames = 0;
+volatile uint32_t menu_remote_errors = 0;
+
+static uint8_t remote_rx[MENU_REMOTE_FRAME];
+static uint16_t remote_rx_length = 0;
+static uint8_t remote_rx_overflow = 0;
+static volatile uint8_t remote_enabled = 1;
+
+//Reply is built and sent by remote and menu task, buffers and CRC unit are shared
+static uint8_t remote_payload[REMOTE_PAYLOAD_MAX];
+static uint8_t remote_tx[REMOTE_TX_MAX];
+static SemaphoreHandle_t remote_tx_lock;
+static SemaphoreHandle_t remote_rx_signal;
+
+//Dump request for menu task
+static volatile uint8_t dump_pending = 0;
+static uint8_t dump_sequence;
+static uint16_t dump_x1, dump_y1, dump_x2, dump_y2;
+
+static uint16_t get_u16(uint8_t* data){
+	return data[0] | (data[1] << 8);
+}
+
+static void put_u16(uint8_t* data, uint16_t value){
+	data[0] = value & 0xFF;
+	data[1] = value >> 8;
+}
+
+//Zero bytes are replaced with distance to next zero, output has no zeros
+static uint16_t cobs_encode(uint8_t* in, uint16_t length, uint8_t* out){
+	uint16_t code_index = 0, o = 1, i;
+	uint8_t code = 1;
+	for(i = 0; i < length; i++){
+		if(in[i] == 0){
+			out[code_index] = code;
+			code_index = o++;
+			code = 1;
+		}
+		else{
+			out[o++] = in[i];
+			code++;
+			if(code == 0xFF){
+				out[code_index] = code;
+				code_index = o++;
+				code = 1;
+			}
+		}
+	}
+	out[code_index] = code;
+	return o;
+}
+
+//Decode in place, returns 0 for broken frame
+static uint16_t cobs_decode(uint8_t* data, uint16_t length){
+	uint16_t i = 0, o = 0, j;
+	uint8_t code;
+	while(i < length){
+		code = data[i++];
+		if(code == 0 || i + code - 1 > length) return 0;
+		for(j = 1; j < code; j++) data[o++] = data[i++];
+		if(code != 0xFF && i < length) data[o++] = 0;
+	}
+	return o;
+}
+
+//Payload is in remote_payload, lock must be taken
+static void remote_send(uint16_t length){
+	uint32_t crc = TM_CRC_Calculate8(remote_payload, length, 1);
+	uint16_t encoded;
+	remote_payload[length++] = crc & 0xFF;
+	remote_payload[length++] = (crc >> 8) & 0xFF;
+	remote_payload[length++] = (crc >> 16) & 0xFF;
+	remote_payload[length++] = crc >> 24;
+
+	//Leading zero ends any garbage sent by other code, so it can not spoil this frame
+	remote_tx[0] = 0;
+	encoded = cobs_encode(remote_payload, length, remote_tx + 1);
+	remote_tx[encoded + 1] = 0;
+	USART1_Write(remote_tx, encoded + 2);
+}
+
+void menu_remote_send(uint8_t command, uint8_t sequence, uint8_t status, uint8_t* data, uint16_t length){
+	xSemaphoreTake(remote_tx_lock, portMAX_DELAY);
+	remote_payload[0] = command | MENU_REMOTE_REPLY;
+	remote_payload[1] = sequence;
+	remote_payload[2] = status;
+	if(length > 0) memcpy(remote_payload + 3, data, length);
+	remote_send(length + 3);
+	xSemaphoreGive(remote_tx_lock);
+}
+
+//Titles from main menu to current one
+static void remote_path(uint8_t sequence){
+	uint8_t data[2 + MENU_PATH_DEPTH*TITLE_MAX];
+	uint16_t length = 2, title;
+	uint8_t depth = menu_path_depth, i;
+	if(depth > MENU_PATH_DEPTH) depth = MENU_PATH_DEPTH;
+	data[0] = depth;
+	data[1] = depth > 0 ? menu_path[depth-1]->token : 0;
+	for(i = 0; i < depth; i++){
+		if(i > 0) data[length++] = '/';
+		title = strlen(menu_path[i]->title);
+		memcpy(data + length, menu_path[i]->title, title);
+		length = length + title;
+	}
+	menu_remote_send(MENU_REMOTE_PATH, sequence, MENU_REMOTE_OK, data, length);
+}
+
+static void remote_command(uint8_t* frame, uint16_t length){
+	uint8_t command = frame[0], sequence = frame[1];
+	uint8_t* arguments = frame + 2;
+	uint8_t data[5];
+	uint16_t count = length - 2, i;
+
+	switch(command){
+		case MENU_REMOTE_PING:
+			data[0] = MENU_REMOTE_VERSION;
+			put_u16(data + 1, MENU_WIDTH);
+			put_u16(data + 3, MENU_HEIGHT);
+			menu_remote_send(command, sequence, MENU_REMOTE_OK, data, 5);
+			break;
+
+		case MENU_REMOTE_KEY:
+			for(i = 0; i < count && menu_event_push(arguments[i]); i++);
+			data[0] = i;
+			menu_remote_send(command, sequence, i == count ? MENU_REMOTE_OK : MENU_REMOTE_BUSY, data, 1);
+			break;
+
+		case MENU_REMOTE_TOUCH:
+			if(count < 5 || arguments[0] > TOUCH_CLICK){
+				menu_remote_send(command, sequence, MENU_REMOTE_BAD_ARGUMENT, NULL, 0);
+			}
+			else if(!menu_touch_inject((touch_gesture)arguments[0], get_u16(arguments + 1), get_u16(arguments + 3))){
+				menu_remote_send(command, sequence, MENU_REMOTE_BUSY, NULL, 0);
+			}
+			else{
+				menu_remote_send(command, sequence, MENU_REMOTE_OK, NULL, 0);
+			}
+			break;
+
+		case MENU_REMOTE_PATH:
+			remote_path(sequence);
+			break;
+
+		case MENU_REMOTE_DUMP:
+			if(count < 8){
+				menu_remote_send(command, sequence, MENU_REMOTE_BAD_ARGUMENT, NULL, 0);
+				break;
+			}
+			if(dump_pending){
+				menu_remote_send(command, sequence, MENU_REMOTE_BUSY, NULL, 0);
+				break;
+			}
+			dump_x1 = get_u16(arguments);
+			dump_y1 = get_u16(arguments + 2);
+			dump_x2 = get_u16(arguments + 4);
+			dump_y2 = get_u16(arguments + 6);
+			if(dump_x1 > dump_x2 || dump_y1 > dump_y2 || dump_x2 >= MENU_WIDTH || dump_y2 >= MENU_HEIGHT){
+				menu_remote_send(command, sequence, MENU_REMOTE_BAD_ARGUMENT, NULL, 0);
+				break;
+			}
+			dump_sequence = sequence;
+			dump_pending = 1;	//Reply is sent by menu task
+			break;
+
+		case MENU_REMOTE_STREAM:
+			if(count < 3){
+				menu_remote_send(command, sequence, MENU_REMOTE_BAD_ARGUMENT, NULL, 0);
+				break;
+			}
+			if(arguments[0]) menu_stream_start(get_u16(arguments + 1));
+			else menu_stream_stop();
+			menu_remote_send(command, sequence, MENU_REMOTE_OK, NULL, 0);
+			break;
+
+		case MENU_REMOTE_MODE:
+			if(count > 0 && arguments[0] > USART1_SHELL){
+				menu_remote_send(command, sequence, MENU_REMOTE_BAD_ARGUMENT, NULL, 0);
+				break;
+			}
+			USART1_Interactive = count > 0 ? arguments[0] : USART1_BINARY;
+			menu_remote_send(command, sequence, MENU_REMOTE_OK, NULL, 0);
+			break;
+
+		default:
+			menu_remote_send(command, sequence, MENU_REMOTE_UNKNOWN, NULL, 0);
+			break;
+	}
+}
+
+static void remote_frame(){
+	uint16_t length = cobs_decode(remote_rx, remote_rx_length);
+	uint32_t crc;
+	if(length < 6){	//Command, sequence and CRC
+		menu_remote_errors++;
+		return;
+	}
+	length = length - 4;
+	crc = remote_rx[length] | (remote_rx[length+1] << 8) | (remote_rx[length+2] << 16) | ((uint32_t)remote_rx[length+3] << 24);
+	xSemaphoreTake(remote_tx_lock, portMAX_DELAY);
+	if(TM_CRC_Calculate8(remote_rx, length, 1) != crc){
+		xSemaphoreGive(remote_tx_lock);
+		menu_remote_errors++;
+		return;
+	}
+	xSemaphoreGive(remote_tx_lock);
+
+	menu_remote_frames++;
+	USART1_Interactive = USART1_BINARY;	//Bytes are frames now, not keys
+	remote_command(remote_rx, length);
+}
+
+static void remote_byte(uint8_t byte){
+	if(byte == 0){
+		if(remote_rx_overflow) menu_remote_errors++;
+		else if(remote_rx_length > 0) remote_frame();
+		remote_rx_length = 0;
+		remote_rx_overflow = 0;
+	}
+	else if(remote_rx_length < MENU_REMOTE_FRAME){
+		remote_rx[remote_rx_length++] = byte;
+	}
+	else{
+		remote_rx_overflow = 1;	//Skip until end of frame
+	}
+}
+
+static void remote_notify(){
+	BaseType_t woken = pdFALSE;
+	xSemaphoreGiveFromISR(remote_rx_signal, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+static void remote_task(void* parameters){
+	uint8_t* chunk;
+	uint16_t length, i;
+	while(1){
+		xSemaphoreTake(remote_rx_signal, portMAX_DELAY);
+		if(!remote_enabled) continue;
+		//Whole chunk is parsed directly from RX buffer
+		while(remote_enabled && (length = USART1_GetChunk(&chunk)) > 0){
+			for(i = 0; i < length; i++){
+				remote_byte(chunk[i]);
+				//Text bytes never contain 0, frame starts with it and switches to binary
+				if(USART1_Interactive == USART1_SHELL && chunk[i] != 0) menu_shell_input(chunk[i]);
+				else if(USART1_Interactive == USART1_KEYS && chunk[i] == MENU_SHELL_START_KEY) menu_shell_start();
+			}
+			USART1_ReleaseChunk(length);
+		}
+	}
+}
+
+void menu_remote_init(){
+	TM_CRC_Init();
+	remote_tx_lock = xSemaphoreCreateMutex();
+	vSemaphoreCreateBinary(remote_rx_signal);
+	xTaskCreate(remote_task, "Remote", MENU_REMOTE_STACK, NULL, MENU_REMOTE_PRIORITY, NULL);
+	USART1_RxNotify = remote_notify;
+}
+
+void menu_remote_enable(uint8_t enable){
+	remote_enabled = enable;
+	remote_rx_length = 0;
+	if(enable){
+		USART1_RxFlush();
+		xSemaphoreGive(remote_rx_signal);
+	}
+}
+
+void menu_remote_service(){
+	uint16_t y, width;
+	menu_stream_service();
+	if(!dump_pending) return;
+	width = dump_x2 - dump_x1 + 1;
+	xSemaphoreTake(remote_tx_lock, portMAX_DELAY);
+	for(y = dump_y1; y <= dump_y2; y++){
+		//Row is read directly in payload
+		remote_payload[0] = MENU_REMOTE_DUMP | MENU_REMOTE_REPLY;
+		remote_payload[1] = dump_sequence;
+		remote_payload[2] = MENU_REMOTE_MORE;
+		put_u16(remote_payload + 3, y);
+		menu_display_read(dump_x1, y, dump_x2, y, remote_payload + 5);
+		remote_send(5 + width*2);
+	}
+	xSemaphoreGive(remote_tx_lock);
+	menu_remote_send(MENU_REMOTE_DUMP, dump_sequence, MENU_REMOTE_OK, NULL, 0);
+	dump_pending = 0;
+}
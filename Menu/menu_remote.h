@@ -0,0 +1,60 @@
+#ifndef MENU_REMOTE_H
+#define MENU_REMOTE_H
+
+#include <stdint.h>
+
+//Binary remote control over USART1, for test rigs which drive menu from PC.
+//
+//Frame on wire:	0x00, COBS(payload, CRC32), 0x00
+//	payload:	request [command][sequence][arguments...]
+//						reply		[command | 0x80][sequence][status][data...]
+//	CRC32:		STM32 hardware CRC (polynomial 0x04C11DB7, init 0xFFFFFFFF, no reflection)
+//						fed with each payload byte as one 32-bit word, little endian on wire
+//Numbers are little endian. Frames with bad CRC are dropped without reply.
+//
+//Until first valid frame is received, USART1 works as before (echo, one key per byte).
+//After it, echo and key bytes are off until MENU_REMOTE_MODE with argument 1.
+//Ctrl-C in key mode starts text shell (menu_shell.h), frames are still accepted there.
+//
+//Keys and touches are queued and handled by menu in order, reply is sent when they are queued.
+//Screen dump is read by menu task (display is only used from it), when it waits for input.
+//Tools/menu_remote.py is PC side of protocol.
+
+#define MENU_REMOTE_VERSION			1
+#define MENU_REMOTE_FRAME				256		//Max received frame (encoded)
+#define MENU_REMOTE_PAYLOAD			600		//Max data in sent frame
+#define MENU_REMOTE_PRIORITY		2			//Task priority, above menu
+#define MENU_REMOTE_STACK				384		//Also runs shell commands
+
+//Commands
+#define MENU_REMOTE_PING				0x01	//-> [version][MENU_WIDTH u16][MENU_HEIGHT u16]
+#define MENU_REMOTE_KEY					0x02	//[key...] -> [queued count]
+#define MENU_REMOTE_TOUCH				0x03	//[gesture][x u16][y u16]
+#define MENU_REMOTE_PATH				0x04	//-> [depth][token]["Title/Title/..."]
+#define MENU_REMOTE_DUMP				0x05	//[x1 u16][y1 u16][x2 u16][y2 u16] -> rows: status MORE [y u16][RGB565 big endian...], then status OK
+#define MENU_REMOTE_MODE				0x06	//[1: back to key bytes and echo, 2: shell, 0: binary only]
+#define MENU_REMOTE_STREAM			0x07	//[1: start, 0: stop][period ms u16]
+#define MENU_REMOTE_SCREEN			0x08	//Only sent by device: changed screen areas, see menu_stream.h
+#define MENU_REMOTE_LOG					0x09	//Only sent by device: log records, see menu_log.h
+#define MENU_REMOTE_REPLY				0x80
+
+//Reply status
+#define MENU_REMOTE_OK					0
+#define MENU_REMOTE_MORE				1		//More replies follow
+#define MENU_REMOTE_UNKNOWN			2		//Unknown command
+#define MENU_REMOTE_BAD_ARGUMENT	3
+#define MENU_REMOTE_BUSY				4		//Queue full or dump already running
+
+extern volatile uint32_t menu_remote_frames;	//Valid frames
+extern volatile uint32_t menu_remote_errors;	//Frames with bad CRC, length or COBS
+
+//Create remote task, call before scheduler is started
+void menu_remote_init();
+//Remote stops reading USART1 while disabled (for functions which use it directly, like terminal)
+void menu_remote_enable(uint8_t enable);
+//Called by menu task while it waits for input, sends requested screen dump and stream
+void menu_remote_service();
+//Send frame, data is at most MENU_REMOTE_PAYLOAD bytes. Can be used from any task
+void menu_remote_send(uint8_t command, uint8_t sequence, uint8_t status, uint8_t* data, uint16_t length);
+
+#endif
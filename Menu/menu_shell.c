@@ -0,0 +1,364 @@
+#include "menu_shell.h"
+#include "menu_event.h"
+#include "menu_remote.h"
+#include "menu_log.h"
+#include "menu_logfile.h"
+#include "menu_profile.h"
+#include "USART.h"
+#include "tm_stm32f4_ili9341.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_CLI.h"
+#include "ff.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SHELL_ROOT_NAME		"main"
+#define SHELL_EMPTY				0xFF
+
+typedef struct shell_command{
+	menu* item;
+	uint32_t hash;
+	uint16_t name;		//Offset in shell_names
+	uint8_t parent;		//Index in shell_nodes
+}shell_command;
+
+//Menus with submenus, each one with index of its parent (SHELL_EMPTY for main menu)
+typedef struct shell_node{
+	menu* item;
+	uint8_t parent;
+}shell_node;
+
+//Paths in tree order (for "menu"), hash table has indexes of them
+static shell_command shell_commands[MENU_SHELL_COMMANDS];
+static uint8_t shell_command_count = 0;
+static shell_node shell_nodes[MENU_SHELL_MENUS];
+static uint8_t shell_node_count = 0;
+static uint8_t shell_hash[MENU_SHELL_HASH];
+static char shell_names[MENU_SHELL_NAMES];
+static uint16_t shell_names_used = 0;
+
+static char shell_line[MENU_SHELL_LINE + 1];
+static uint8_t shell_length = 0;
+static uint8_t shell_escape = 0;		//Skipping escape sequence (arrow keys)
+static char shell_last = 0;
+
+//State of commands which print more lines (one line per call)
+static uint8_t shell_next;
+static menu_profile_task shell_tasks[MENU_PROFILE_TASKS];
+static uint8_t shell_task_count;
+static FATFS shell_fatfs;
+static char shell_ls_path[MENU_SHELL_LINE + 1];
+static volatile uint8_t shell_ls_busy = 0;		//Set by shell until menu task has done listing
+
+static void shell_puts(const char* text){
+	USART1_Write((uint8_t*)text, strlen(text));
+}
+
+//FNV-1a
+static uint32_t shell_hash_string(const char* text, uint8_t length){
+	uint32_t hash = 2166136261UL;
+	uint8_t i;
+	for(i = 0; i < length; i++){
+		hash = (hash ^ (uint8_t)text[i]) * 16777619UL;
+	}
+	return hash;
+}
+
+static shell_command* shell_lookup(const char* path, uint8_t length){
+	uint32_t hash = shell_hash_string(path, length);
+	uint8_t slot = hash & (MENU_SHELL_HASH - 1);
+	shell_command* command;
+	while(shell_hash[slot] != SHELL_EMPTY){
+		command = &shell_commands[shell_hash[slot]];
+		if(command->hash == hash && strncmp(shell_names + command->name, path, length) == 0 && shell_names[command->name + length] == 0){
+			return command;
+		}
+		slot = (slot + 1) & (MENU_SHELL_HASH - 1);
+	}
+	return NULL;
+}
+
+menu* menu_shell_find(const char* path){
+	shell_command* command = shell_lookup(path, strlen(path));
+	return command != NULL ? command->item : NULL;
+}
+
+//Title as path part: lower case, spaces as '_', other characters are left out
+static uint8_t shell_add_name(char* path, uint8_t position, const char* title){
+	uint8_t i;
+	char c;
+	for(i = 0; i < TITLE_MAX && title[i] && position < MENU_SHELL_LINE; i++){
+		c = title[i];
+		if(c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+		else if(c == ' ') c = '_';
+		else if(!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) continue;
+		path[position++] = c;
+	}
+	return position;
+}
+
+//Path of item is in path, parent is index of its parent in shell_nodes, items without function are skipped
+static void shell_add_tree(menu* item, uint8_t parent, char* path, uint8_t length){
+	uint8_t i, slot;
+	shell_command* command;
+	if(item->submenus == 0){
+		if(item->function == NULL || shell_command_count == MENU_SHELL_COMMANDS) return;
+		if(shell_names_used + length + 1 > MENU_SHELL_NAMES) return;
+		if(shell_lookup(path, length) != NULL) return;	//Same title twice, first one is used
+		command = &shell_commands[shell_command_count];
+		command->item = item;
+		command->name = shell_names_used;
+		command->hash = shell_hash_string(path, length);
+		command->parent = parent;
+		memcpy(shell_names + shell_names_used, path, length);
+		shell_names[shell_names_used + length] = 0;
+		shell_names_used += length + 1;
+		slot = command->hash & (MENU_SHELL_HASH - 1);
+		while(shell_hash[slot] != SHELL_EMPTY) slot = (slot + 1) & (MENU_SHELL_HASH - 1);
+		shell_hash[slot] = shell_command_count++;
+		return;
+	}
+	if(length >= MENU_SHELL_LINE || shell_node_count == MENU_SHELL_MENUS) return;
+	shell_nodes[shell_node_count].item = item;
+	shell_nodes[shell_node_count].parent = parent;
+	parent = shell_node_count++;
+	for(i = 0; i < item->submenus; i++){
+		path[length] = '/';
+		shell_add_tree(item->submenu[i], parent, path, shell_add_name(path, length + 1, item->submenu[i]->title));
+	}
+}
+
+static BaseType_t shell_menu(char* buffer, size_t size, const char* command){
+	if(shell_next >= shell_command_count){
+		buffer[0] = 0;
+		shell_next = 0;
+		return pdFALSE;
+	}
+	snprintf(buffer, size, "%s\r\n", shell_names + shell_commands[shell_next].name);
+	shell_next++;
+	if(shell_next < shell_command_count) return pdTRUE;
+	shell_next = 0;
+	return pdFALSE;
+}
+
+static BaseType_t shell_tasks_command(char* buffer, size_t size, const char* command){
+	menu_profile_task* task;
+	if(shell_next == 0){
+		shell_task_count = menu_profile_sample(shell_tasks, MENU_PROFILE_TASKS);
+		if(shell_task_count == 0){
+			snprintf(buffer, size, "Measuring, try again in %u ms\r\n", MENU_PROFILE_WINDOW);
+			return pdFALSE;
+		}
+		snprintf(buffer, size, "Name             State Priority CPU%%   Stack free\r\n");
+		shell_next = 1;
+		return pdTRUE;
+	}
+	task = &shell_tasks[shell_next - 1];
+	snprintf(buffer, size, "%-16s %c     %-8u %3u.%u  %u\r\n", task->name, task->state,
+		task->priority, task->cpu/10, task->cpu%10, task->stack);
+	shell_next++;
+	if(shell_next <= shell_task_count) return pdTRUE;
+	shell_next = 0;
+	return pdFALSE;
+}
+
+static BaseType_t shell_timers(char* buffer, size_t size, const char* command){
+	menu_profile_timer* timer;
+	BaseType_t length;
+	if(shell_next == 0){
+		if(FreeRTOS_CLIGetParameter(command, 1, &length) != NULL){
+			menu_profile_reset_timers();
+			snprintf(buffer, size, "Timers reset\r\n");
+			return pdFALSE;
+		}
+		snprintf(buffer, size, "Timer            Count      Avg us     Max us\r\n");
+		shell_next = 1;
+		return pdTRUE;
+	}
+	timer = &menu_profile_timers[shell_next - 1];
+	snprintf(buffer, size, "%-16s %-10u %-10u %u\r\n", timer->name, timer->count,
+		timer->count ? MENU_PROFILE_US(timer->total/timer->count) : 0, MENU_PROFILE_US(timer->max));
+	shell_next++;
+	if(shell_next <= MENU_PROFILE_TIMERS) return pdTRUE;
+	shell_next = 0;
+	return pdFALSE;
+}
+
+static BaseType_t shell_heap(char* buffer, size_t size, const char* command){
+	snprintf(buffer, size, "Free %u of %u bytes\r\n", (unsigned int)xPortGetFreeHeapSize(), (unsigned int)configTOTAL_HEAP_SIZE);
+	return pdFALSE;
+}
+
+static BaseType_t shell_counters(char* buffer, size_t size, const char* command){
+	switch(shell_next++){
+		case 0:
+			snprintf(buffer, size, "LCD: %u commands, %u data bytes, %u windows, %u pixels read\r\n",
+				ILI9341_Counters.commands, ILI9341_Counters.data, ILI9341_Counters.windows, ILI9341_Counters.read);
+			return pdTRUE;
+		case 1:
+			snprintf(buffer, size, "SPI DMA: %u transfers, %u bytes\r\n", ILI9341_Counters.dma, ILI9341_Counters.dma_data);
+			return pdTRUE;
+		case 2:
+			snprintf(buffer, size, "USART1: %u received, %u RX overruns, %u HW overruns, %u TX dropped\r\n",
+				USART1_RxBytes, USART1_RxOverruns, USART1_HwOverruns, USART1_TxDropped);
+			return pdTRUE;
+		default:
+			snprintf(buffer, size, "Remote: %u frames, %u errors, log dropped %u\r\n",
+				menu_remote_frames, menu_remote_errors, menu_log_dropped);
+			shell_next = 0;
+			return pdFALSE;
+	}
+}
+
+//Runs in menu task, volume is mounted only for listing. Log file task keeps it mounted while log is open.
+static void shell_ls_run(){
+	char line[MENU_SHELL_LINE + 32];
+	DIR dir;
+	FILINFO info;
+	if(menu_logfile_is_open()){
+		shell_puts("Busy, disk is used by log file\r\n");
+	}
+	else if(f_mount(&shell_fatfs, "0:", 1) != FR_OK || f_opendir(&dir, shell_ls_path) != FR_OK){
+		snprintf(line, sizeof(line), "Cannot open %s\r\n", shell_ls_path);
+		shell_puts(line);
+		f_mount(NULL, "0:", 0);
+	}
+	else{
+		while(f_readdir(&dir, &info) == FR_OK && info.fname[0] != 0){
+			if(info.fattrib & AM_DIR) snprintf(line, sizeof(line), "%-12s <DIR>\r\n", info.fname);
+			else snprintf(line, sizeof(line), "%-12s %lu\r\n", info.fname, info.fsize);
+			shell_puts(line);
+		}
+		f_closedir(&dir);
+		f_mount(NULL, "0:", 0);
+	}
+	shell_ls_busy = 0;
+}
+
+//Listing is done by menu task (FatFs is not reentrant), lines come after prompt
+static BaseType_t shell_ls(char* buffer, size_t size, const char* command){
+	const char* parameter;
+	BaseType_t length;
+	if(shell_ls_busy){
+		snprintf(buffer, size, "Busy\r\n");
+		return pdFALSE;
+	}
+	parameter = FreeRTOS_CLIGetParameter(command, 1, &length);
+	if(parameter == NULL){
+		strcpy(shell_ls_path, "0:/");
+	}
+	else{
+		memcpy(shell_ls_path, parameter, length);
+		shell_ls_path[length] = 0;
+	}
+	shell_ls_busy = 1;
+	if(!menu_event_call(shell_ls_run)){
+		shell_ls_busy = 0;
+		snprintf(buffer, size, "Busy\r\n");
+		return pdFALSE;
+	}
+	buffer[0] = 0;
+	return pdFALSE;
+}
+
+static BaseType_t shell_exit(char* buffer, size_t size, const char* command){
+	buffer[0] = 0;
+	USART1_Interactive = USART1_KEYS;
+	return pdFALSE;
+}
+
+static const CLI_Command_Definition_t shell_builtins[] = {
+	{"menu", "menu:\r\n Lists menu commands\r\n", shell_menu, 0},
+	{"tasks", "tasks:\r\n Task state, priority, CPU load and least free stack\r\n", shell_tasks_command, 0},
+	{"timers", "timers [reset]:\r\n Hot path timers\r\n", shell_timers, -1},
+	{"heap", "heap:\r\n Free FreeRTOS heap\r\n", shell_heap, 0},
+	{"counters", "counters:\r\n LCD, SPI, USART and remote counters\r\n", shell_counters, 0},
+	{"ls", "ls [dir]:\r\n Lists directory on disk (menu task lists it when it waits for keys)\r\n", shell_ls, -1},
+	{"exit", "exit:\r\n Back to menu keys\r\n", shell_exit, 0}
+};
+
+void menu_shell_init(menu* root){
+	char path[MENU_SHELL_LINE];
+	uint8_t i;
+	memset(shell_hash, SHELL_EMPTY, sizeof(shell_hash));
+	strcpy(path, SHELL_ROOT_NAME);
+	shell_add_tree(root, SHELL_EMPTY, path, strlen(SHELL_ROOT_NAME));
+	for(i = 0; i < sizeof(shell_builtins)/sizeof(shell_builtins[0]); i++){
+		FreeRTOS_CLIRegisterCommand(&shell_builtins[i]);
+	}
+}
+
+void menu_shell_start(){
+	USART1_Interactive = USART1_SHELL;
+	shell_length = 0;
+	shell_escape = 0;
+	shell_puts("\r\nShell, \"help\" for commands, \"exit\" for keys\r\n" MENU_SHELL_PROMPT);
+}
+
+static void shell_execute(){
+	char* output = FreeRTOS_CLIGetOutputBuffer();
+	uint8_t length = 0;
+	shell_command* command;
+	menu* parents[MENU_PATH_DEPTH];
+	uint8_t depth = 0, parent;
+	BaseType_t more;
+
+	while(length < shell_length && shell_line[length] != ' ') length++;
+	command = shell_lookup(shell_line, length);
+	if(command != NULL){
+		//Parents from main menu, so menu_path is the same as if item was opened with keys
+		for(parent = command->parent; parent != SHELL_EMPTY; parent = shell_nodes[parent].parent) depth++;
+		length = depth;
+		for(parent = command->parent; parent != SHELL_EMPTY; parent = shell_nodes[parent].parent){
+			if(--length < MENU_PATH_DEPTH) parents[length] = shell_nodes[parent].item;
+		}
+		shell_puts(menu_event_open(command->item, parents, depth) ? "Opened\r\n" : "Busy\r\n");
+		return;
+	}
+	do{
+		more = FreeRTOS_CLIProcessCommand(shell_line, output, configCOMMAND_INT_MAX_OUTPUT_SIZE);
+		shell_puts(output);
+	}while(more != pdFALSE);
+}
+
+void menu_shell_input(char c){
+	if(shell_escape){
+		if((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '~') shell_escape = 0;
+		return;
+	}
+	if(c == '\n' && shell_last == '\r'){	//CR LF is one line end
+		shell_last = c;
+		return;
+	}
+	shell_last = c;
+	switch(c){
+		case '\r':
+		case '\n':
+			shell_puts("\r\n");
+			shell_line[shell_length] = 0;
+			if(shell_length > 0) shell_execute();
+			shell_length = 0;
+			if(USART1_Interactive == USART1_SHELL) shell_puts(MENU_SHELL_PROMPT);
+			break;
+		case '\b':
+		case 0x7F:
+			if(shell_length > 0){
+				shell_length--;
+				shell_puts("\b \b");
+			}
+			break;
+		case 27:
+			shell_escape = 1;
+			break;
+		case MENU_SHELL_START_KEY:	//Drop line
+			shell_length = 0;
+			shell_puts("^C\r\n" MENU_SHELL_PROMPT);
+			break;
+		default:
+			if(c < ' ' || shell_length == MENU_SHELL_LINE) break;
+			shell_line[shell_length++] = c;
+			USART1_Write((uint8_t*)&c, 1);
+			break;
+	}
+}
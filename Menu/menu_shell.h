@@ -0,0 +1,36 @@
+#ifndef MENU_SHELL_H
+#define MENU_SHELL_H
+
+#include <stdint.h>
+#include "menu_system.h"
+
+//Text command shell on USART1 (FreeRTOS+CLI).
+//Started by Ctrl-C while USART1 is in key mode (or MENU_REMOTE_MODE 2), "exit" returns to key mode.
+//
+//Every menu item with function is a command, path of lower case titles from main menu:
+//	main/led, main/info/version, main/world_domination...
+//Command opens item in menu task, as if it was selected (it waits while other command function runs).
+//Paths are in hash table built once by menu_shell_init, lookup does not walk the menu tree.
+//
+//Built-in commands: help, menu, tasks, timers [reset], heap, counters, ls [dir], exit.
+//Input is handled in remote task, so commands must not use display. ls runs in menu task (menu_event_call),
+//it does not mount the disk under menu functions or log file.
+
+#define MENU_SHELL_LINE				80
+#define MENU_SHELL_COMMANDS		48		//Menu items with function
+#define MENU_SHELL_MENUS			32		//Menu items with submenus, less than 255
+#define MENU_SHELL_HASH				128		//Hash table size, power of 2, bigger than MENU_SHELL_COMMANDS
+#define MENU_SHELL_NAMES			1024	//Bytes for all paths
+#define MENU_SHELL_START_KEY	3			//Ctrl-C
+#define MENU_SHELL_PROMPT			"> "
+
+//Build path table from menu tree and register built-in commands, call before scheduler is started
+void menu_shell_init(menu* root);
+//Switch USART1 to shell and print prompt
+void menu_shell_start();
+//Received byte while USART1 is in shell mode
+void menu_shell_input(char c);
+//Item with path (lower case, '/' separated), NULL if there is none
+menu* menu_shell_find(const char* path);
+
+#endif
@@ -0,0 +1,102 @@
+#include "menu_sprite.h"
+#include "menu_display.h"
+#include "menu_system.h"
+#include <stddef.h>
+
+static uint8_t sprite_row[2][MENU_WIDTH*2];	//One row is sent while next one is converted
+
+static uint8_t sprite_keyed(const menu_sprite_atlas* atlas, uint32_t pos){
+	if(atlas->color_key == MENU_SPRITE_NO_KEY) return 0;
+	if(atlas->format == MENU_SPRITE_INDEXED){
+		return ((const uint8_t*)atlas->data)[pos] == atlas->color_key;
+	}
+	return ((const uint16_t*)atlas->data)[pos] == atlas->color_key;
+}
+
+static uint16_t sprite_pixel(const menu_sprite_atlas* atlas, uint32_t pos, uint16_t background){
+	if(sprite_keyed(atlas, pos)) return background;
+	if(atlas->format == MENU_SPRITE_INDEXED){
+		return atlas->palette[((const uint8_t*)atlas->data)[pos]];
+	}
+	return ((const uint16_t*)atlas->data)[pos];
+}
+
+//Convert count pixels starting at pos to display byte order
+static void sprite_convert(const menu_sprite_atlas* atlas, uint32_t pos, uint16_t count, uint16_t background, uint8_t* out){
+	uint16_t color;
+	while(count--){
+		color = sprite_pixel(atlas, pos++, background);
+		*out++ = color >> 8;
+		*out++ = color & 0xFF;
+	}
+}
+
+//Transparent background - only runs of not keyed pixels are sent
+static void sprite_draw_runs(const menu_sprite_atlas* atlas, const menu_sprite* sprite, int16_t x, int16_t y, int16_t x1, int16_t y1, int16_t x2, int16_t y2){
+	int16_t row, col, start;
+	uint32_t pos;
+	for(row = y1; row <= y2; row++){
+		pos = sprite->offset + (uint32_t)(row - y)*sprite->width + (x1 - x);
+		col = x1;
+		while(col <= x2){
+			while(col <= x2 && sprite_keyed(atlas, pos)){
+				col++;
+				pos++;
+			}
+			start = col;
+			while(col <= x2 && !sprite_keyed(atlas, pos)){
+				col++;
+				pos++;
+			}
+			if(col > start){
+				sprite_convert(atlas, pos - (col - start), col - start, 0, sprite_row[0]);
+				menu_display_window(start, row, col - 1, row);
+				menu_display_write(sprite_row[0], (col - start)*2);
+			}
+		}
+	}
+}
+
+void menu_sprite_draw(const menu_sprite_atlas* atlas, uint16_t id, int16_t x, int16_t y, uint32_t background){
+	const menu_sprite* sprite;
+	int16_t x1, y1, x2, y2, row;
+	uint8_t buffer = 0;
+	menu_display_clip clip;
+
+	if(atlas == NULL || id >= atlas->count) return;
+	sprite = &atlas->sprites[id];
+	if(sprite->width == 0 || sprite->height == 0) return;
+
+	//Clip to current clip rectangle, nothing is sent if sprite is not visible
+	x2 = x + sprite->width - 1;
+	y2 = y + sprite->height - 1;
+	if(!menu_display_visible(x, y, x2, y2)) return;
+	menu_display_get_clip(&clip);
+	x1 = (x < (int16_t)clip.x1) ? clip.x1 : x;
+	y1 = (y < (int16_t)clip.y1) ? clip.y1 : y;
+	if(x2 > (int16_t)clip.x2) x2 = clip.x2;
+	if(y2 > (int16_t)clip.y2) y2 = clip.y2;
+
+	if((background & TRANSPARENT) && atlas->color_key != MENU_SPRITE_NO_KEY){
+		sprite_draw_runs(atlas, sprite, x, y, x1, y1, x2, y2);
+		return;
+	}
+
+	menu_display_window(x1, y1, x2, y2);
+	for(row = y1; row <= y2; row++){
+		sprite_convert(atlas, sprite->offset + (uint32_t)(row - y)*sprite->width + (x1 - x), x2 - x1 + 1, background, sprite_row[buffer]);
+		menu_display_write_async(sprite_row[buffer], (x2 - x1 + 1)*2);
+		buffer ^= 1;
+	}
+	menu_display_wait();
+}
+
+uint16_t menu_sprite_width(const menu_sprite_atlas* atlas, uint16_t id){
+	if(atlas == NULL || id >= atlas->count) return 0;
+	return atlas->sprites[id].width;
+}
+
+uint16_t menu_sprite_height(const menu_sprite_atlas* atlas, uint16_t id){
+	if(atlas == NULL || id >= atlas->count) return 0;
+	return atlas->sprites[id].height;
+}
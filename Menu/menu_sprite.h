@@ -0,0 +1,37 @@
+#ifndef MENU_SPRITE_H
+#define MENU_SPRITE_H
+
+#include <stdint.h>
+
+//Sprite atlas - many small icons packed into one const array with index table.
+//Each sprite is sent with one address window, keyed pixels are replaced with background color.
+//Only with TRANSPARENT background keyed pixels are skipped (one window per run, slower).
+
+#define MENU_SPRITE_NO_KEY	0x80000000
+
+typedef enum {
+	MENU_SPRITE_RGB565,		//uint16_t per pixel
+	MENU_SPRITE_INDEXED		//uint8_t index in palette per pixel
+}menu_sprite_format;
+
+typedef struct sprite{
+	uint32_t offset;		//First pixel of sprite in atlas data
+	uint16_t width;
+	uint16_t height;
+}menu_sprite;
+
+typedef struct sprite_atlas{
+	menu_sprite_format format;
+	const void* data;						//Pixels of all sprites, row by row
+	const uint16_t* palette;		//RGB565 colors, only for MENU_SPRITE_INDEXED
+	const menu_sprite* sprites;	//Index table
+	uint16_t count;
+	uint32_t color_key;					//Color (or palette index) which is not drawn, or MENU_SPRITE_NO_KEY
+}menu_sprite_atlas;
+
+//Draw sprite with top left corner at x, y. Sprite is clipped to current display clip
+void menu_sprite_draw(const menu_sprite_atlas* atlas, uint16_t id, int16_t x, int16_t y, uint32_t background);
+uint16_t menu_sprite_width(const menu_sprite_atlas* atlas, uint16_t id);
+uint16_t menu_sprite_height(const menu_sprite_atlas* atlas, uint16_t id);
+
+#endif
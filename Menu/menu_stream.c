@@ -0,0 +1,179 @@
+#include "menu_stream.h"
+#include "menu_remote.h"
+#include "menu_display.h"
+#include "menu_system.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+#define STREAM_RUN_MAX		128
+#define STREAM_HEADER			8
+
+typedef struct stream_rect{
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;
+	uint16_t y2;
+}stream_rect;
+
+static stream_rect dirty[MENU_STREAM_RECTS];
+static uint8_t dirty_count = 0;
+static volatile uint8_t stream_on = 0;
+static volatile uint8_t stream_restart = 0;
+static uint8_t stream_hooked = 0;		//Damage callback is set
+static TickType_t stream_period;
+static TickType_t stream_last;
+static uint8_t stream_frame = 0;
+static uint16_t sent_top, sent_height, sent_line;
+
+static uint8_t stream_row[MENU_WIDTH*2];
+static uint8_t stream_data[MENU_REMOTE_PAYLOAD];
+
+static uint32_t rect_area(stream_rect* rect){
+	return (uint32_t)(rect->x2 - rect->x1 + 1) * (rect->y2 - rect->y1 + 1);
+}
+
+static void rect_union(stream_rect* a, stream_rect* b, stream_rect* result){
+	result->x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+	result->y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+	result->x2 = a->x2 > b->x2 ? a->x2 : b->x2;
+	result->y2 = a->y2 > b->y2 ? a->y2 : b->y2;
+}
+
+//Rectangle is merged with one which wastes least pixels, new entry is used only if waste is too big
+static void stream_damage(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2){
+	stream_rect rect, merged;
+	uint32_t waste, best_waste = 0xFFFFFFFF;
+	uint8_t i, best = 0;
+
+	if(x2 >= MENU_WIDTH) x2 = MENU_WIDTH - 1;
+	if(y2 >= MENU_HEIGHT) y2 = MENU_HEIGHT - 1;
+	if(x1 > x2 || y1 > y2) return;
+	rect.x1 = x1;
+	rect.y1 = y1;
+	rect.x2 = x2;
+	rect.y2 = y2;
+
+	for(i = 0; i < dirty_count; i++){
+		rect_union(&dirty[i], &rect, &merged);
+		waste = rect_area(&merged) - rect_area(&dirty[i]);
+		waste = waste > rect_area(&rect) ? waste - rect_area(&rect) : 0;	//Overlap is not counted
+		if(waste < best_waste){
+			best_waste = waste;
+			best = i;
+		}
+	}
+	if(dirty_count < MENU_STREAM_RECTS && best_waste > MENU_STREAM_SLACK){
+		dirty[dirty_count++] = rect;
+		return;
+	}
+	rect_union(&dirty[best], &rect, &dirty[best]);
+}
+
+//Encode pixels as runs, returns used bytes (at most count*2 + count/128 + 1)
+static uint16_t stream_rle(uint8_t* pixels, uint16_t count, uint8_t* out){
+	uint16_t i = 0, o = 0, n, start;
+	while(i < count){
+		n = 1;
+		while(i + n < count && n < STREAM_RUN_MAX && pixels[(i+n)*2] == pixels[i*2] && pixels[(i+n)*2+1] == pixels[i*2+1]) n++;
+		if(n > 1){
+			out[o++] = 0x80 | (n - 1);
+			out[o++] = pixels[i*2];
+			out[o++] = pixels[i*2+1];
+			i = i + n;
+		}
+		else{	//Different pixels until next run
+			start = i;
+			n = 0;
+			while(i < count && n < STREAM_RUN_MAX && !(i + 1 < count && pixels[(i+1)*2] == pixels[i*2] && pixels[(i+1)*2+1] == pixels[i*2+1])){
+				i++;
+				n++;
+			}
+			out[o++] = n - 1;
+			memcpy(out + o, pixels + start*2, n*2);
+			o = o + n*2;
+		}
+	}
+	return o;
+}
+
+static void stream_put_u16(uint8_t* data, uint16_t value){
+	data[0] = value & 0xFF;
+	data[1] = value >> 8;
+}
+
+//Rows are packed in messages until next row might not fit
+static void stream_send_rect(stream_rect* rect){
+	uint16_t width = rect->x2 - rect->x1 + 1;
+	uint16_t worst = width*2 + width/STREAM_RUN_MAX + 1;
+	uint16_t length = STREAM_HEADER, y, first = rect->y1;
+
+	for(y = rect->y1; y <= rect->y2; y++){
+		menu_display_read(rect->x1, y, rect->x2, y, stream_row);
+		length = length + stream_rle(stream_row, width, stream_data + length);
+		if(y == rect->y2 || length + worst > MENU_REMOTE_PAYLOAD){
+			stream_put_u16(stream_data, rect->x1);
+			stream_put_u16(stream_data + 2, first);
+			stream_put_u16(stream_data + 4, rect->x2);
+			stream_put_u16(stream_data + 6, y);
+			menu_remote_send(MENU_REMOTE_SCREEN, stream_frame, MENU_REMOTE_MORE, stream_data, length);
+			length = STREAM_HEADER;
+			first = y + 1;
+		}
+	}
+}
+
+void menu_stream_start(uint16_t period){
+	if(period == 0) period = MENU_STREAM_PERIOD;
+	stream_period = period/portTICK_PERIOD_MS;
+	stream_restart = 1;
+	stream_on = 1;
+}
+
+void menu_stream_stop(){
+	stream_on = 0;
+}
+
+void menu_stream_service(){
+	uint16_t top, height, line;
+	uint8_t i;
+
+	if(!stream_on){
+		if(stream_hooked){
+			menu_display_on_damage(NULL);
+			stream_hooked = 0;
+			dirty_count = 0;
+		}
+		return;
+	}
+	if(stream_restart){	//Whole screen in first frame
+		menu_display_on_damage(stream_damage);
+		stream_hooked = 1;
+		dirty[0].x1 = 0;
+		dirty[0].y1 = 0;
+		dirty[0].x2 = MENU_WIDTH - 1;
+		dirty[0].y2 = MENU_HEIGHT - 1;
+		dirty_count = 1;
+		sent_height = 0;
+		stream_last = xTaskGetTickCount() - stream_period;
+		stream_restart = 0;
+	}
+	if((xTaskGetTickCount() - stream_last) < stream_period) return;
+
+	menu_display_get_scroll(&top, &height, &line);
+	if(dirty_count == 0 && top == sent_top && height == sent_height && line == sent_line &&
+		(xTaskGetTickCount() - stream_last) < MENU_STREAM_IDLE/portTICK_PERIOD_MS) return;
+	stream_last = xTaskGetTickCount();
+
+	for(i = 0; i < dirty_count; i++) stream_send_rect(&dirty[i]);
+	dirty_count = 0;
+
+	stream_put_u16(stream_data, top);
+	stream_put_u16(stream_data + 2, height);
+	stream_put_u16(stream_data + 4, line);
+	menu_remote_send(MENU_REMOTE_SCREEN, stream_frame, MENU_REMOTE_OK, stream_data, 6);
+	stream_frame++;
+	sent_top = top;
+	sent_height = height;
+	sent_line = line;
+}
@@ -0,0 +1,29 @@
+#ifndef MENU_STREAM_H
+#define MENU_STREAM_H
+
+#include <stdint.h>
+
+//Screen streaming over remote control link (menu_remote.h).
+//Display driver reports every written window, windows are merged in short list of dirty rectangles.
+//Each period dirty rectangles are read back from display memory and sent RLE compressed,
+//so used bandwidth depends on changed area, not on screen size.
+//
+//Frame is sent as MENU_REMOTE_SCREEN replies (not requested) with frame number as sequence:
+//	status MORE:	[x1 u16][y1 u16][x2 u16][y2 u16][RLE...]		part of rectangle, rows from top
+//		RLE:	[0x80 | (n-1)][pixel]				n times same pixel
+//					[n-1][pixel]...[pixel]			n different pixels (n <= 128), pixels RGB565 big endian
+//	status OK:		[scroll top u16][scroll height u16][scroll line u16]		end of frame
+//Rectangles are in display memory coordinates, viewer applies hardware scrolling.
+//Static screen gets empty frame (only end of frame) every MENU_STREAM_IDLE ms, viewer knows link is alive.
+//Tools/menu_viewer.py shows stream on PC.
+
+#define MENU_STREAM_RECTS		16		//Dirty rectangles, more are merged together
+#define MENU_STREAM_SLACK		512		//Pixels which may be sent needlessly when two rectangles are merged
+#define MENU_STREAM_PERIOD	100		//ms, default time between frames
+#define MENU_STREAM_IDLE		1000	//ms, end of frame without rectangles is sent when screen does not change
+
+void menu_stream_start(uint16_t period);	//Whole screen is sent in first frame, period 0 for default
+void menu_stream_stop();
+void menu_stream_service();	//Called by menu task (menu_remote_service), sends frame when period passed
+
+#endif
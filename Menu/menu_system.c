@@ -3,12 +3,50 @@
 #include "menu_event.h"
 #include "menu_button.h"
 #include "menu_touch.h"
+#include "menu_text.h"
+#include "menu_sprite.h"
+#include "menu_icons.h"
+#include "menu_overlay.h"
+#include "menu_profile.h"
 #include <stdio.h>
+#include <string.h>
 
 
 
 char refresh_flag = 0;
-char blanks[21] = "                    ";
+char keep_screen_flag = 0;
+menu* menu_path[MENU_PATH_DEPTH];
+uint8_t menu_path_depth = 0;
+const menu_sprite_atlas* menu_icon_atlas = &menu_icons;
+static menu* open_parents[MENU_PATH_DEPTH];	//Parents of item opened by shell
+static uint8_t open_depth;
+
+void menu_keep_screen(){
+	keep_screen_flag = 1;
+}
+
+//Command function left menu on screen (only overlays were used), only selection has to be redrawn
+static void check_keep_screen(display* menu_display){
+	if(keep_screen_flag && !menu_overlay_damaged()){
+		menu_display->screen_refresh = 0;
+		menu_display->option_refresh = 0;
+		menu_display->title_refresh = 0;
+		menu_display->refresh = 0;	//Selection is the same
+	}
+	keep_screen_flag = 0;
+}
+
+//Item opened by shell is under its own parents in menu_path while it is open, then path of current menu is back
+static void open_request(menu* item){
+	menu* saved[MENU_PATH_DEPTH];
+	uint8_t saved_depth = menu_path_depth;
+	memcpy(saved, menu_path, sizeof(saved));
+	memcpy(menu_path, open_parents, sizeof(menu_path));
+	menu_path_depth = open_depth;
+	cycle_menu(item);
+	memcpy(menu_path, saved, sizeof(saved));
+	menu_path_depth = saved_depth;
+}
 
 
 void cycle_menu(menu* menu){
@@ -16,10 +54,15 @@ void cycle_menu(menu* menu){
 	char i;
 	uint16_t x, y;
 	touch_gesture move;
+	struct menu* request;
+	menu_event_function call;
 	
 	struct menu* next_menu = menu->submenu[0];  //why struct
 	display menu_display;
 	
+	if(menu_path_depth < MENU_PATH_DEPTH) menu_path[menu_path_depth] = menu;
+	menu_path_depth++;
+	
 	for(i=0;i<menu->submenus;i++){
 		button[i].X1 = 0;
 		button[i].Y1 = 40 + (i*40);
@@ -38,11 +81,13 @@ void cycle_menu(menu* menu){
 	
 	if(menu->submenus == 0){	//This menu don't have submenus, so it is a command
 		if(menu->function != NULL){
+			keep_screen_flag = 0;
 			menu->function();
 			menu_display.screen_refresh = 1;
 			menu_display.option_refresh = 1;
 			menu_display.title_refresh = 1;
 			menu_display.refresh = 1;
+			menu_path_depth--;
 			return;
 		}
 	}
@@ -51,6 +96,7 @@ void cycle_menu(menu* menu){
 		
 		while(1){
 			move=menu_touch_gesture(&x, &y);
+			menu_toast_update();
 			update_display(menu, &menu_display);
 			display_menu(&menu_display);
 			if( get_key('s') || move == TOUCH_UP ){	
@@ -84,6 +130,7 @@ void cycle_menu(menu* menu){
 				menu_display.option_refresh = 1;
 				menu_display.title_refresh = 1;
 				menu_display.refresh = 1;
+				menu_path_depth--;
 				return;
 			}
 			
@@ -93,9 +140,22 @@ void cycle_menu(menu* menu){
 				menu_display.title_refresh = 1;
 				menu_display.refresh = 1;
 				cycle_menu(next_menu);
+				check_keep_screen(&menu_display);
 
 			}
 			
+			request = menu_event_take_open(open_parents, &open_depth);	//From shell
+			if(request != NULL){
+				menu_display.screen_refresh = 1;
+				menu_display.option_refresh = 1;
+				menu_display.title_refresh = 1;
+				menu_display.refresh = 1;
+				open_request(request);
+				check_keep_screen(&menu_display);
+			}
+			call = menu_event_take_call();	//From shell, runs in menu task
+			if(call != NULL) call();
+			
 			if(move == TOUCH_CLICK){
 				for(i=0;i<menu->submenus;i++){
 					if(check_button_pressed(&button[i], x, y)){
@@ -104,32 +164,53 @@ void cycle_menu(menu* menu){
 						menu_display.title_refresh = 1;
 						menu_display.refresh = 1;
 						cycle_menu(menu->submenu[i+menu_display.first-1]);
+						check_keep_screen(&menu_display);
 					}
 				}
 			}
 		}
 	}
+	menu_path_depth--;	//Command without function
 }
 
 
 void display_menu(display* menu_display){
-	uint8_t i;
+	uint8_t i, drawing;
+	uint32_t start = menu_profile_start();
+	if(menu_overlay_damaged()){	//Overlay was closed without saved pixels
+		menu_display->screen_refresh = 1;
+		menu_display->option_refresh = 1;
+		menu_display->title_refresh = 1;
+		menu_display->refresh = 1;
+		menu_overlay_clear_damage();
+	}
+	//Only calls which draw something are timed, menu loop calls it all the time
+	drawing = menu_display->screen_refresh || menu_display->title_refresh || menu_display->option_refresh || menu_display->refresh;
 	if(menu_display->screen_refresh){
+		menu_overlay_discard();
 		menu_display_fill(WHITE);
 		menu_display->screen_refresh = 0;
 	}
+	else if(menu_display->title_refresh || menu_display->option_refresh || menu_display->refresh){
+		menu_toast_hide();	//Toast would be left over old pixels
+	}
 	if(menu_display->title_refresh){
-		menu_display_draw_filled_rectangle(0, 0, MENU_WIDTH, 40,	WHITE);
-		menu_display_puts(5, 10, blanks, &TM_Font_11x18, BLACK, WHITE);
-		menu_display_puts(5, 10, menu_display->title, &MENU_FONT, BLACK, WHITE);
+		menu_text_draw(5, 10, MENU_WIDTH-6, menu_display->title, &MENU_FONT, MENU_TEXT_LEFT, BLACK, WHITE);
 		menu_display_draw_line(0, 39, MENU_WIDTH, 39, BLACK);
 		menu_display_draw_line(0, 40, MENU_WIDTH, 40, BLACK);
 		menu_display->title_refresh = 0;
 	}
 	if(menu_display->option_refresh){
 		for(i = menu_display->first;i <= menu_display->last;i++){
-			menu_display_puts(5, 10+((i-menu_display->first+1)*40), blanks, &MENU_FONT, BLACK, WHITE);
-			menu_display_puts(5, 10+((i-menu_display->first+1)*40), menu_display->option[i-1], &MENU_FONT, BLACK, WHITE);
+			if(menu_display->icon[i-1] && menu_icon_atlas != NULL){
+				//Cell may have text of row without icon, sprite does not cover all of it
+				menu_display_draw_filled_rectangle(5, ((i-menu_display->first+1)*40)+2, 5+MENU_ICON_SPACE-1, ((i-menu_display->first+1)*40)+40-2, WHITE);
+				menu_sprite_draw(menu_icon_atlas, menu_display->icon[i-1], 5, 11+((i-menu_display->first+1)*40), WHITE);
+				menu_text_draw(5+MENU_ICON_SPACE, 10+((i-menu_display->first+1)*40), MENU_WIDTH-6, menu_display->option[i-1], &MENU_FONT, MENU_TEXT_LEFT, BLACK, WHITE);
+			}
+			else{
+				menu_text_draw(5, 10+((i-menu_display->first+1)*40), MENU_WIDTH-6, menu_display->option[i-1], &MENU_FONT, MENU_TEXT_LEFT, BLACK, WHITE);
+			}
 		}
 		menu_display->option_refresh = 0;
 	}
@@ -143,6 +224,7 @@ void display_menu(display* menu_display){
 //		menu_display_puts(5, 10+((menu_display->selected-menu_display->first+1)*40), menu_display->option[menu_display->selected-1], &MENU_FONT, WHITE, BLACK);
 		menu_display->refresh = 0;
 	}
+	if(drawing) menu_profile_stop(MENU_PROFILE_DISPLAY_MENU, start);
 }
 
 void update_display(menu* menu, display* menu_display){
@@ -164,6 +246,7 @@ void update_display(menu* menu, display* menu_display){
 	}
 	for(i = menu_display->first; i <= menu_display->last; i++){
 		menu_display->option[i-1] = menu->submenu[i-1]->title;
+		menu_display->icon[i-1] = menu->submenu[i-1]->icon;
 	}
 }
 
@@ -177,6 +260,7 @@ void init_display(menu* menu, display* menu_display){
 	menu_display->title = menu->title;
 	for(i=0;i<menu_display->last;i++){
 		menu_display->option[i] = menu->submenu[i]->title;
+		menu_display->icon[i] = menu->submenu[i]->icon;
 	}
 	menu_display->screen_refresh = 1;
 	menu_display->option_refresh = 1;
@@ -3,12 +3,15 @@
 
 #include "stdint.h"
 #include "tm_stm32f4_fonts.h"	///
+#include "menu_sprite.h"
 #define TITLE_MAX	20
 #define	SUBMENU_MAX 30
 
 #define MENU_WIDTH	240	//
 #define MENU_HEIGHT 320	//
 #define MENU_FONT TM_Font_11x18
+#define MENU_ICON_SPACE 21	//Text is moved right for icon width + gap
+#define MENU_PATH_DEPTH 8		//Menus remembered in menu_path
 
 
 typedef struct menu{
@@ -20,6 +23,7 @@ typedef struct menu{
 		char first;			//
 		char last;
 		char prev_token;
+		uint8_t icon;		//Icon ID in menu_icon_atlas, 0 for none
 } menu;
 
 typedef struct display{
@@ -30,6 +34,7 @@ typedef struct display{
 		char previous;
 		char* title;
 		char* option[MENU_HEIGHT];
+		uint8_t icon[SUBMENU_MAX];
 		char screen_refresh;
 		char option_refresh;
 		char title_refresh;
@@ -39,11 +44,15 @@ typedef struct display{
 
 extern char refresh_flag;
 extern display menu_display;
+extern menu* menu_path[MENU_PATH_DEPTH];	//Open menus, from main menu to current one
+extern uint8_t menu_path_depth;
+extern const menu_sprite_atlas* menu_icon_atlas;	//Atlas used for menu entries, set to NULL to disable icons
 
 void cycle_menu(menu* menu);
 void display_menu(display* display);
 void update_display(menu* menu, display* display);
 void init_display(menu* menu, display* display);
+void menu_keep_screen();	//Call from command function which did not change screen (only overlays)
 
 
 #endif
\ No newline at end of file
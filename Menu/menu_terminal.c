@@ -0,0 +1,424 @@
+#include "menu_terminal.h"
+#include "menu_display.h"
+#include <string.h>
+
+#define TERMINAL_NO_LINE	0xFFFFFFFF
+#define TERMINAL_ESC			27
+
+#define ATTR(fg, bg)			((fg) | ((bg) << 4))
+#define ATTR_FG(attr)			((attr) & 0x0F)
+#define ATTR_BG(attr)			((attr) >> 4)
+
+typedef enum {
+	TERMINAL_NORMAL,
+	TERMINAL_ESCAPE,	//ESC received
+	TERMINAL_CSI			//ESC [ received, reading parameters
+}terminal_state;
+
+//ANSI colors: black, red, green, yellow, blue, magenta, cyan, white, then bright ones
+static uint16_t terminal_palette[16] = {
+	0x0000, 0xA800, 0x0540, 0xAAA0, 0x0015, 0xA815, 0x0555, 0xAD55,
+	0x7BEF, 0xF800, 0x07E0, 0xFFE0, 0x001F, 0xF81F, 0x07FF, 0xFFFF
+};
+
+//Model, line numbers are absolute, line N is in terminal_text[N % MENU_TERMINAL_LINES]
+static char terminal_text[MENU_TERMINAL_LINES][MENU_TERMINAL_COLUMNS];
+static uint8_t terminal_attr[MENU_TERMINAL_LINES][MENU_TERMINAL_COLUMNS];	//Palette index of foreground and background
+static uint32_t first_line;		//Oldest line still in buffer
+static uint32_t last_line;		//Bottom line of screen
+static uint32_t cursor_line;
+static uint16_t cursor_column;	//Can be MENU_TERMINAL_COLUMNS, then next character wraps
+static uint8_t cursor_visible;
+static uint32_t view_offset;		//Number of lines between last line and bottom of screen
+static uint8_t default_attr, current_attr, reverse;
+
+//Parser
+static terminal_state state = TERMINAL_NORMAL;
+static uint16_t params[MENU_TERMINAL_PARAMS];
+static uint8_t param_count;
+static uint8_t private_mode;
+static uint32_t saved_row;
+static uint16_t saved_column;
+static uint8_t saved_attr;
+
+//What is on screen, index is display memory row
+static uint32_t drawn_line[MENU_TERMINAL_ROWS];
+static uint8_t dirty_from[MENU_TERMINAL_ROWS];	//dirty_from > dirty_to means nothing changed
+static uint8_t dirty_to[MENU_TERMINAL_ROWS];
+static uint32_t cursor_line_drawn;
+static uint16_t cursor_column_drawn;
+static uint16_t scroll_drawn;
+
+static char* terminal_line(uint32_t line){
+	return terminal_text[line % MENU_TERMINAL_LINES];
+}
+
+static uint8_t* terminal_line_attr(uint32_t line){
+	return terminal_attr[line % MENU_TERMINAL_LINES];
+}
+
+static void terminal_dirty(uint32_t line, uint8_t from, uint8_t to){
+	uint16_t row = line % MENU_TERMINAL_ROWS;
+	if(from < dirty_from[row]) dirty_from[row] = from;
+	if(to > dirty_to[row]) dirty_to[row] = to;
+}
+
+//Clear part of line with current background
+static void terminal_erase(uint32_t line, uint8_t from, uint8_t to){
+	memset(terminal_line(line) + from, ' ', to - from + 1);
+	memset(terminal_line_attr(line) + from, current_attr, to - from + 1);
+	terminal_dirty(line, from, to);
+}
+
+//First line of screen when view is at bottom, cursor can be moved only on screen
+static uint32_t terminal_screen_top(){
+	return last_line - (MENU_TERMINAL_ROWS - 1);
+}
+
+static void terminal_line_feed(){
+	if(cursor_line < last_line){
+		cursor_line++;
+		return;
+	}
+	last_line++;
+	cursor_line = last_line;
+	if(last_line - first_line >= MENU_TERMINAL_LINES){	//Buffer is full, oldest line is overwritten
+		first_line++;
+	}
+	memset(terminal_line(last_line), ' ', MENU_TERMINAL_COLUMNS);
+	memset(terminal_line_attr(last_line), default_attr, MENU_TERMINAL_COLUMNS);
+}
+
+static void terminal_move(int32_t row, int32_t column){
+	if(row < 0) row = 0;
+	if(row > MENU_TERMINAL_ROWS - 1) row = MENU_TERMINAL_ROWS - 1;
+	if(column < 0) column = 0;
+	if(column > MENU_TERMINAL_COLUMNS - 1) column = MENU_TERMINAL_COLUMNS - 1;
+	cursor_line = terminal_screen_top() + row;
+	cursor_column = column;
+}
+
+static void terminal_print(char c){
+	if(cursor_column == MENU_TERMINAL_COLUMNS){	//Wrap
+		cursor_column = 0;
+		terminal_line_feed();
+	}
+	terminal_line(cursor_line)[cursor_column] = c;
+	terminal_line_attr(cursor_line)[cursor_column] = current_attr;
+	terminal_dirty(cursor_line, cursor_column, cursor_column);
+	cursor_column++;
+}
+
+static void terminal_control(char c){
+	if(c == '\r'){
+		cursor_column = 0;
+	}
+	else if(c == '\n'){
+		terminal_line_feed();
+	}
+	else if(c == '\b'){
+		if(cursor_column > 0) cursor_column--;
+	}
+	else if(c == '\t'){
+		cursor_column = (cursor_column/MENU_TERMINAL_TAB + 1)*MENU_TERMINAL_TAB;
+		if(cursor_column > MENU_TERMINAL_COLUMNS - 1) cursor_column = MENU_TERMINAL_COLUMNS - 1;
+	}
+}
+
+static void terminal_sgr(){
+	uint8_t i, fg, bg, tmp;
+	if(param_count == 0) params[param_count++] = 0;	//ESC [ m is reset
+	for(i = 0; i < param_count; i++){
+		fg = ATTR_FG(current_attr);
+		bg = ATTR_BG(current_attr);
+		if(reverse){	//Colors are set as not reversed
+			tmp = fg; fg = bg; bg = tmp;
+		}
+		if(params[i] == 0){
+			fg = ATTR_FG(default_attr);
+			bg = ATTR_BG(default_attr);
+			reverse = 0;
+		}
+		else if(params[i] == 1){
+			if(fg < 8) fg = fg + 8;
+		}
+		else if(params[i] == 22){
+			if(fg >= 8) fg = fg - 8;
+		}
+		else if(params[i] == 7) reverse = 1;
+		else if(params[i] == 27) reverse = 0;
+		else if(params[i] >= 30 && params[i] <= 37) fg = params[i] - 30;
+		else if(params[i] == 39) fg = ATTR_FG(default_attr);
+		else if(params[i] >= 40 && params[i] <= 47) bg = params[i] - 40;
+		else if(params[i] == 49) bg = ATTR_BG(default_attr);
+		else if(params[i] >= 90 && params[i] <= 97) fg = params[i] - 90 + 8;
+		else if(params[i] >= 100 && params[i] <= 107) bg = params[i] - 100 + 8;
+		if(reverse){
+			tmp = fg; fg = bg; bg = tmp;
+		}
+		current_attr = ATTR(fg, bg);
+	}
+}
+
+static void terminal_erase_screen(uint16_t mode){
+	uint32_t line, from = terminal_screen_top(), end = last_line + 1;	//Whole lines from - end (not included)
+	if(mode == 0){	//Cursor to end
+		if(cursor_column < MENU_TERMINAL_COLUMNS) terminal_erase(cursor_line, cursor_column, MENU_TERMINAL_COLUMNS - 1);
+		from = cursor_line + 1;
+	}
+	else if(mode == 1){	//Start to cursor
+		terminal_erase(cursor_line, 0, (cursor_column < MENU_TERMINAL_COLUMNS) ? cursor_column : MENU_TERMINAL_COLUMNS - 1);
+		end = cursor_line;
+	}
+	for(line = from; line < end; line++){
+		terminal_erase(line, 0, MENU_TERMINAL_COLUMNS - 1);
+	}
+}
+
+static void terminal_erase_line(uint16_t mode){
+	uint16_t column = (cursor_column < MENU_TERMINAL_COLUMNS) ? cursor_column : MENU_TERMINAL_COLUMNS - 1;
+	if(mode == 0) terminal_erase(cursor_line, column, MENU_TERMINAL_COLUMNS - 1);
+	else if(mode == 1) terminal_erase(cursor_line, 0, column);
+	else terminal_erase(cursor_line, 0, MENU_TERMINAL_COLUMNS - 1);
+}
+
+//Final character of CSI sequence
+static void terminal_csi(char c){
+	int32_t row = cursor_line - terminal_screen_top();
+	int32_t column = (cursor_column < MENU_TERMINAL_COLUMNS) ? cursor_column : MENU_TERMINAL_COLUMNS - 1;
+	uint16_t n = (param_count > 0 && params[0] > 0) ? params[0] : 1;	//Count, default 1
+	uint16_t mode = (param_count > 0) ? params[0] : 0;
+
+	if(private_mode){
+		if(mode == 25 && c == 'h') cursor_visible = 1;
+		if(mode == 25 && c == 'l') cursor_visible = 0;
+		return;
+	}
+	switch(c){
+		case 'A': terminal_move(row - n, column); break;
+		case 'B': terminal_move(row + n, column); break;
+		case 'C': terminal_move(row, column + n); break;
+		case 'D': terminal_move(row, column - n); break;
+		case 'E': terminal_move(row + n, 0); break;
+		case 'F': terminal_move(row - n, 0); break;
+		case 'G': terminal_move(row, n - 1); break;
+		case 'd': terminal_move(n - 1, column); break;
+		case 'H':
+		case 'f':
+			terminal_move(n - 1, (param_count > 1 && params[1] > 0) ? params[1] - 1 : 0);
+			break;
+		case 'J': terminal_erase_screen(mode); break;
+		case 'K': terminal_erase_line(mode); break;
+		case 'm': terminal_sgr(); break;
+		case 's':
+			saved_row = row;
+			saved_column = cursor_column;
+			saved_attr = current_attr;
+			break;
+		case 'u':
+			terminal_move(saved_row, saved_column);
+			current_attr = saved_attr;
+			break;
+		default: break;
+	}
+}
+
+static uint8_t terminal_palette_index(uint16_t color, uint8_t replace){
+	uint8_t i;
+	for(i = 0; i < 16; i++){
+		if(terminal_palette[i] == color) return i;
+	}
+	terminal_palette[replace] = color;
+	return replace;
+}
+
+static void terminal_draw(uint32_t line, uint8_t from, uint8_t to){
+	uint16_t y = (line % MENU_TERMINAL_ROWS)*MENU_TERMINAL_LINE_HEIGHT;
+	char* text = terminal_line(line);
+	uint8_t* attr = terminal_line_attr(line);
+	uint8_t column, start = from;
+	for(column = from; column <= to; column++){
+		menu_display_putc(column*MENU_TERMINAL_CHAR_WIDTH, y, text[column], &MENU_TERMINAL_FONT, terminal_palette[ATTR_FG(attr[column])], terminal_palette[ATTR_BG(attr[column])]);
+	}
+	//Pixel row under characters (font is 1 pixel lower than line), one line per background color run
+	y = y + MENU_TERMINAL_LINE_HEIGHT - 1;
+	for(column = from; column <= to; column++){
+		if(column == to || ATTR_BG(attr[column + 1]) != ATTR_BG(attr[start])){
+			menu_display_draw_line(start*MENU_TERMINAL_CHAR_WIDTH, y, (column + 1)*MENU_TERMINAL_CHAR_WIDTH - 1, y, terminal_palette[ATTR_BG(attr[start])]);
+			start = column + 1;
+		}
+	}
+}
+
+//Cursor is line under character, this pixel row is never used by font
+static void terminal_draw_cursor(uint32_t line, uint16_t column, uint16_t color){
+	uint16_t x = column*MENU_TERMINAL_CHAR_WIDTH;
+	uint16_t y = (line % MENU_TERMINAL_ROWS)*MENU_TERMINAL_LINE_HEIGHT + MENU_TERMINAL_LINE_HEIGHT - 1;
+	if(column >= MENU_TERMINAL_COLUMNS) return;
+	menu_display_draw_line(x, y, x + MENU_TERMINAL_CHAR_WIDTH - 1, y, color);
+}
+
+void menu_terminal_init(uint16_t foreground, uint16_t background){
+	uint16_t i;
+	default_attr = ATTR(terminal_palette_index(foreground, 7), terminal_palette_index(background, 0));
+	menu_terminal_clear();
+
+	//Screen is empty, every row shows empty line
+	menu_display_fill(background);
+	menu_display_scroll_area(0, MENU_TERMINAL_ROWS*MENU_TERMINAL_LINE_HEIGHT, MENU_HEIGHT - MENU_TERMINAL_ROWS*MENU_TERMINAL_LINE_HEIGHT);
+	menu_display_scroll(0);
+	scroll_drawn = 0;
+	for(i = 0; i < MENU_TERMINAL_ROWS; i++){
+		drawn_line[i] = i;
+	}
+}
+
+void menu_terminal_close(){
+	menu_display_scroll_area(0, MENU_HEIGHT, 0);
+	menu_display_scroll(0);
+}
+
+void menu_terminal_clear(){
+	uint16_t i;
+	memset(terminal_text, ' ', sizeof(terminal_text));
+	memset(terminal_attr, default_attr, sizeof(terminal_attr));
+	//Screen lines exist from start, so cursor can be moved anywhere on screen
+	first_line = 0;
+	last_line = MENU_TERMINAL_ROWS - 1;
+	cursor_line = 0;
+	cursor_column = 0;
+	cursor_visible = 1;
+	view_offset = 0;
+	current_attr = default_attr;
+	reverse = 0;
+	state = TERMINAL_NORMAL;
+	saved_row = 0;
+	saved_column = 0;
+	saved_attr = default_attr;
+	for(i = 0; i < MENU_TERMINAL_ROWS; i++){
+		drawn_line[i] = TERMINAL_NO_LINE;
+		dirty_from[i] = 0xFF;
+		dirty_to[i] = 0;
+	}
+	cursor_line_drawn = TERMINAL_NO_LINE;
+}
+
+uint8_t menu_terminal_escape(){
+	return state == TERMINAL_ESCAPE;
+}
+
+void menu_terminal_putc(char c){
+	view_offset = 0;
+	switch(state){
+		case TERMINAL_NORMAL:
+			if(c == TERMINAL_ESC) state = TERMINAL_ESCAPE;
+			else if(c >= ' ' && c <= '~') terminal_print(c);
+			else terminal_control(c);
+			break;
+
+		case TERMINAL_ESCAPE:
+			state = TERMINAL_NORMAL;
+			if(c == '['){
+				state = TERMINAL_CSI;
+				param_count = 0;
+				private_mode = 0;
+			}
+			else if(c == '7'){
+				saved_row = cursor_line - terminal_screen_top();
+				saved_column = cursor_column;
+				saved_attr = current_attr;
+			}
+			else if(c == '8'){
+				terminal_move(saved_row, saved_column);
+				current_attr = saved_attr;
+			}
+			else if(c == 'c'){
+				menu_terminal_clear();
+			}
+			else if(c == TERMINAL_ESC){
+				state = TERMINAL_ESCAPE;
+			}
+			break;
+
+		case TERMINAL_CSI:
+			if(c >= '0' && c <= '9'){
+				if(param_count == 0) params[param_count++] = 0;
+				if(params[param_count-1] < 1000) params[param_count-1] = params[param_count-1]*10 + (c - '0');
+			}
+			else if(c == ';'){
+				if(param_count == 0) params[param_count++] = 0;	//Empty first parameter
+				if(param_count < MENU_TERMINAL_PARAMS) params[param_count++] = 0;
+			}
+			else if(c == '?'){
+				private_mode = 1;
+			}
+			else if(c >= 0x40 && c <= 0x7E){	//Final byte
+				terminal_csi(c);
+				state = TERMINAL_NORMAL;
+			}
+			else if(c < ' '){	//Control characters are executed inside sequence
+				terminal_control(c);
+			}
+			break;
+	}
+}
+
+void menu_terminal_puts(char* str){
+	while(*str){
+		menu_terminal_putc(*str++);
+	}
+}
+
+void menu_terminal_view(int16_t lines){
+	uint32_t stored = last_line - first_line + 1;
+	uint32_t max = (stored > MENU_TERMINAL_ROWS) ? (stored - MENU_TERMINAL_ROWS) : 0;
+	int32_t offset = (int32_t)view_offset + lines;
+	if(offset < 0) offset = 0;
+	if((uint32_t)offset > max) offset = max;
+	view_offset = offset;
+}
+
+void menu_terminal_page_up(){
+	menu_terminal_view(MENU_TERMINAL_ROWS - 1);
+}
+
+void menu_terminal_page_down(){
+	menu_terminal_view(-(MENU_TERMINAL_ROWS - 1));
+}
+
+void menu_terminal_flush(){
+	uint32_t top = last_line - view_offset - (MENU_TERMINAL_ROWS - 1), line;
+	uint16_t i, row, scroll;
+
+	if(cursor_line_drawn != TERMINAL_NO_LINE){
+		terminal_draw_cursor(cursor_line_drawn, cursor_column_drawn, terminal_palette[ATTR_BG(terminal_line_attr(cursor_line_drawn)[cursor_column_drawn])]);
+		cursor_line_drawn = TERMINAL_NO_LINE;
+	}
+
+	//Each display row is drawn at most once, no matter how many line feeds or escape sequences were there
+	for(i = 0; i < MENU_TERMINAL_ROWS; i++){
+		line = top + i;
+		row = line % MENU_TERMINAL_ROWS;
+		if(drawn_line[row] != line){
+			terminal_draw(line, 0, MENU_TERMINAL_COLUMNS - 1);
+			drawn_line[row] = line;
+		}
+		else if(dirty_from[row] <= dirty_to[row]){
+			terminal_draw(line, dirty_from[row], dirty_to[row]);
+		}
+		dirty_from[row] = 0xFF;
+		dirty_to[row] = 0;
+	}
+
+	scroll = (top % MENU_TERMINAL_ROWS)*MENU_TERMINAL_LINE_HEIGHT;
+	if(scroll != scroll_drawn){
+		menu_display_scroll(scroll);
+		scroll_drawn = scroll;
+	}
+
+	if(view_offset == 0 && cursor_visible && cursor_column < MENU_TERMINAL_COLUMNS){
+		terminal_draw_cursor(cursor_line, cursor_column, terminal_palette[ATTR_FG(default_attr)]);
+		cursor_line_drawn = cursor_line;
+		cursor_column_drawn = cursor_column;
+	}
+}
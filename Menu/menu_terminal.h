@@ -0,0 +1,51 @@
+#ifndef MENU_TERMINAL_H
+#define MENU_TERMINAL_H
+
+#include <stdint.h>
+#include "menu_system.h"
+
+//Text terminal model with scrollback.
+//Lines are kept in circular buffer, new line only moves index (no memory moves), oldest line is overwritten.
+//Screen uses display hardware scrolling: line N is always drawn in display memory row N % MENU_TERMINAL_ROWS,
+//so after line feed only the new line is drawn and scroll start is moved.
+//Changes are only written to model, menu_terminal_flush draws changed cells once.
+//
+//Input is parsed by VT100/ANSI state machine:
+//	ESC [ n A/B/C/D/E/F/G/d	cursor up/down/forward/back/next line/previous line/column/row
+//	ESC [ r ; c H or f			cursor position
+//	ESC [ n J, ESC [ n K		erase in screen, erase in line (0 to end, 1 from start, 2 all)
+//	ESC [ ... m							colors 30-37, 39, 40-47, 49, 90-97, 100-107, bold (1, 22), reverse (7, 27), reset (0)
+//	ESC [ s/u, ESC 7/8			save/restore cursor
+//	ESC [ ? 25 h/l					show/hide cursor
+//	ESC c										reset
+//Other sequences are parsed and ignored. Scroll regions are not supported.
+
+#define MENU_TERMINAL_FONT				TM_Font_7x10
+#define MENU_TERMINAL_CHAR_WIDTH	7
+#define MENU_TERMINAL_LINE_HEIGHT	11
+#define MENU_TERMINAL_COLUMNS			(MENU_WIDTH/MENU_TERMINAL_CHAR_WIDTH)
+#define MENU_TERMINAL_ROWS				(MENU_HEIGHT/MENU_TERMINAL_LINE_HEIGHT)
+#define MENU_TERMINAL_LINES				256		//Scrollback, including visible lines
+#define MENU_TERMINAL_TAB					8
+#define MENU_TERMINAL_PARAMS			8			//Max CSI parameters
+
+//Clear terminal and screen, set hardware scrolling.
+//Default colors replace palette entries 7 and 0 if they are not in 16 color ANSI palette
+void menu_terminal_init(uint16_t foreground, uint16_t background);
+//Reset hardware scrolling, must be called before anything else is drawn
+void menu_terminal_close();
+
+void menu_terminal_putc(char c);	//Handles \r, \n, \b, \t and escape sequences
+void menu_terminal_puts(char* str);
+void menu_terminal_clear();
+uint8_t menu_terminal_escape();	//Returns 1 if last character was ESC (sequence not finished)
+
+//Show older (lines > 0) or newer (lines < 0) lines, new output returns view to bottom
+void menu_terminal_view(int16_t lines);
+void menu_terminal_page_up();
+void menu_terminal_page_down();
+
+//Draw all changes since last flush
+void menu_terminal_flush();
+
+#endif
@@ -0,0 +1,130 @@
+#include "menu_text.h"
+#include "menu_display.h"
+#include <stddef.h>
+
+static menu_text_layout text_cache[MENU_TEXT_CACHE_SIZE];
+static char ellipsis[] = "...";
+
+static uint16_t text_cache_index(char* str, TM_FontDef_t* font){
+	uint32_t key = (uint32_t)((uintptr_t)str ^ ((uintptr_t)font >> 3));
+	key ^= key >> 9;
+	return (key >> 2) & (MENU_TEXT_CACHE_SIZE - 1);
+}
+
+menu_text_layout* menu_text_measure(char* str, TM_FontDef_t* font){
+	menu_text_layout* layout = &text_cache[text_cache_index(str, font)];
+	uint16_t length = 0;
+	if(layout->str == str && layout->font == font){	//Hit
+		return layout;
+	}
+	while(str[length] && str[length] != '\n'){
+		length++;
+	}
+	layout->str = str;
+	layout->font = font;
+	layout->length = length;
+	layout->width = length * font->FontWidth;
+	layout->height = font->FontHeight;
+	return layout;
+}
+
+void menu_text_invalidate(char* str){
+	uint16_t i;
+	for(i = 0; i < MENU_TEXT_CACHE_SIZE; i++){
+		if(text_cache[i].str == str){
+			text_cache[i].str = NULL;
+		}
+	}
+}
+
+void menu_text_clear_cache(){
+	uint16_t i;
+	for(i = 0; i < MENU_TEXT_CACHE_SIZE; i++){
+		text_cache[i].str = NULL;
+	}
+}
+
+//Draw count characters, without any check
+static void menu_text_put_run(uint16_t x, uint16_t y, char* str, uint16_t count, TM_FontDef_t* font, uint32_t foreground, uint32_t background){
+	while(count--){
+		menu_display_putc(x, y, *str++, font, foreground, background);
+		x = x + font->FontWidth;
+	}
+}
+
+//Draw count characters (and dots from ellipsis) aligned in box, then clear what is left of the box row
+static void menu_text_draw_run(uint16_t x1, uint16_t y, uint16_t x2, char* str, uint16_t count, uint16_t dots, TM_FontDef_t* font, menu_text_align align, uint32_t foreground, uint32_t background){
+	uint16_t box_width = x2 - x1 + 1;
+	uint16_t width = (count + dots) * font->FontWidth;
+	uint16_t x = x1;
+
+	if(align == MENU_TEXT_CENTER){
+		x = x1 + (box_width - width)/2;
+	}
+	else if(align == MENU_TEXT_RIGHT){
+		x = x1 + box_width - width;
+	}
+
+	menu_text_put_run(x, y, str, count, font, foreground, background);
+	menu_text_put_run(x + count*font->FontWidth, y, ellipsis, dots, font, foreground, background);
+
+	if((background & TRANSPARENT) == 0){
+		if(x > x1){
+			menu_display_draw_filled_rectangle(x1, y, x - 1, y + font->FontHeight, background);
+		}
+		if(x + width <= x2){
+			menu_display_draw_filled_rectangle(x + width, y, x2, y + font->FontHeight, background);
+		}
+	}
+}
+
+void menu_text_draw(uint16_t x1, uint16_t y, uint16_t x2, char* str, TM_FontDef_t* font, menu_text_align align, uint32_t foreground, uint32_t background){
+	menu_text_layout* layout;
+	uint16_t max_chars, count, dots = 0;
+
+	if(x2 < x1) return;
+	layout = menu_text_measure(str, font);
+	max_chars = (x2 - x1 + 1)/font->FontWidth;
+	count = layout->length;
+	if(count > max_chars){	//Too long, ellipsize
+		if(max_chars > 3){
+			dots = 3;
+			count = max_chars - 3;
+		}
+		else count = max_chars;
+	}
+	menu_text_draw_run(x1, y, x2, str, count, dots, font, align, foreground, background);
+}
+
+uint16_t menu_text_draw_wrapped(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, char* str, TM_FontDef_t* font, menu_text_align align, uint32_t foreground, uint32_t background){
+	uint16_t max_chars, line_height = font->FontHeight + MENU_TEXT_LINE_SPACING;
+	uint16_t i, space, lines = 0, y = y1;
+
+	if(x2 < x1 || y2 < y1) return 0;
+	max_chars = (x2 - x1 + 1)/font->FontWidth;
+	if(max_chars == 0) return 0;
+
+	while(*str && (y + font->FontHeight - 1) <= y2){
+		space = 0;
+		for(i = 0; str[i] && str[i] != '\n' && i < max_chars; i++){
+			if(str[i] == ' ') space = i;
+		}
+		//Word would be cut, break on last space if there is one
+		if(str[i] && str[i] != '\n' && str[i] != ' ' && space > 0){
+			i = space;
+		}
+		menu_text_draw_run(x1, y, x2, str, i, 0, font, align, foreground, background);
+		if((background & TRANSPARENT) == 0 && (y + font->FontHeight) <= y2){
+			menu_display_draw_filled_rectangle(x1, y + font->FontHeight, x2, y + line_height, background);
+		}
+		str = str + i;
+		if(*str == ' ' || *str == '\n') str++;
+		y = y + line_height;
+		lines++;
+	}
+	//Clear rest of the box (previous text could have more lines)
+	if((background & TRANSPARENT) == 0 && y <= y2){
+		menu_display_draw_filled_rectangle(x1, y, x2, y2 + 1, background);
+	}
+	return lines;
+}
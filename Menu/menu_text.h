@@ -0,0 +1,40 @@
+#ifndef MENU_TEXT_H
+#define MENU_TEXT_H
+
+#include <stdint.h>
+#include "tm_stm32f4_fonts.h"
+
+//Formated print - text is measured once, aligned inside a box and only
+//pixels which are not covered by the new text are cleared.
+
+#define MENU_TEXT_CACHE_SIZE	16	//Number of measured strings kept in cache (power of 2)
+#define MENU_TEXT_LINE_SPACING	1		//Same spacing as TM_ILI9341_Puts uses for '\n'
+
+typedef enum {
+	MENU_TEXT_LEFT,
+	MENU_TEXT_CENTER,
+	MENU_TEXT_RIGHT
+}menu_text_align;
+
+typedef struct text_layout{
+	char* str;							//Key - pointer to string
+	TM_FontDef_t* font;			//Key - font used for measuring
+	uint16_t length;				//Number of characters in first line
+	uint16_t width;					//Width of first line in pixels
+	uint16_t height;
+}menu_text_layout;
+
+//Measure string (up to first '\n'). Result is cached by string pointer and font,
+//so do not change string content without calling menu_text_invalidate
+menu_text_layout* menu_text_measure(char* str, TM_FontDef_t* font);
+void menu_text_invalidate(char* str);
+void menu_text_clear_cache();
+
+//Single line of text inside box x1..x2 (inclusive), top at y.
+//Text which does not fit is ellipsized with "..."
+void menu_text_draw(uint16_t x1, uint16_t y, uint16_t x2, char* str, TM_FontDef_t* font, menu_text_align align, uint32_t foreground, uint32_t background);
+
+//Word wrapped text inside box x1,y1 - x2,y2 (inclusive). Returns number of lines drawn
+uint16_t menu_text_draw_wrapped(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, char* str, TM_FontDef_t* font, menu_text_align align, uint32_t foreground, uint32_t background);
+
+#endif
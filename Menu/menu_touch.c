@@ -1,7 +1,29 @@
 #include "XPT2046.h"
 #include "menu_touch.h"
+#include "menu_remote.h"
 #include <math.h>
 
+//Gestures from remote control, used before touch panel
+typedef struct touch_event{
+	touch_gesture gesture;
+	uint16_t x;
+	uint16_t y;
+}touch_event;
+
+static touch_event touch_queue[MENU_TOUCH_QUEUE];
+static volatile uint8_t touch_head = 0;
+static volatile uint8_t touch_tail = 0;
+
+uint8_t menu_touch_inject(touch_gesture gesture, uint16_t x, uint16_t y){
+	uint8_t next = (touch_head + 1) % MENU_TOUCH_QUEUE;
+	if(next == touch_tail) return 0;
+	touch_queue[touch_head].gesture = gesture;
+	touch_queue[touch_head].x = x;
+	touch_queue[touch_head].y = y;
+	touch_head = next;
+	return 1;
+}
+
 
 void menu_touch_init(){
 	XPT2046_Init();  //Programmer has to provide this function
@@ -18,6 +40,15 @@ uint8_t menu_touch_pressed(){
 touch_gesture menu_touch_gesture(uint16_t* x, uint16_t* y){
 	uint16_t X1, Y1, X2, Y2;
 	int16_t DX, DY;
+	touch_gesture gesture;
+	menu_remote_service();
+	if(touch_head != touch_tail){
+		gesture = touch_queue[touch_tail].gesture;
+		*x = touch_queue[touch_tail].x;
+		*y = touch_queue[touch_tail].y;
+		touch_tail = (touch_tail + 1) % MENU_TOUCH_QUEUE;
+		return gesture;
+	}
 	if(menu_touch_pressed()){
 		menu_get_touch_coordinates(&X1, &Y1);
 		while(menu_touch_pressed()){
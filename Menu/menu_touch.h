@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#define MENU_TOUCH_QUEUE	8	//Injected gestures
+
 typedef enum {
 	TOUCH_LEFT,
 	TOUCH_RIGHT,
@@ -16,5 +18,7 @@ void menu_touch_init();
 void menu_get_touch_coordinates(uint16_t* X, uint16_t* Y);
 uint8_t menu_touch_pressed();
 touch_gesture menu_touch_gesture(uint16_t* x, uint16_t* y);
+//Gesture which is returned by menu_touch_gesture before touch panel is read, returns 0 if queue is full
+uint8_t menu_touch_inject(touch_gesture gesture, uint16_t x, uint16_t y);
 
 #endif
\ No newline at end of file
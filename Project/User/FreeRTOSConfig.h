@@ -83,6 +83,7 @@
 #include "stm32f4xx.h"
 
 extern uint32_t SystemCoreClock;
+extern void menu_profile_clock_init(void);
 
 #define configUSE_PREEMPTION			1
 #define configUSE_IDLE_HOOK				0
@@ -94,17 +95,21 @@ extern uint32_t SystemCoreClock;
 //#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 75 * 1024 ) )
 #define configTOTAL_HEAP_SIZE			( ( size_t ) ( 35* 1024 ) )
 #define configMAX_TASK_NAME_LEN			( 16 )
-#define configUSE_TRACE_FACILITY		0
+#define configUSE_TRACE_FACILITY		1		//uxTaskGetSystemState for profiler
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
-#define configUSE_MUTEXES				0
+#define configUSE_MUTEXES				1
 #define configQUEUE_REGISTRY_SIZE		8
 #define configCHECK_FOR_STACK_OVERFLOW	0
-#define configUSE_RECURSIVE_MUTEXES		0
+#define configUSE_RECURSIVE_MUTEXES		1		//FatFs volume lock (TM/fatfs/option/syscall.c)
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	0
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	menu_profile_clock_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()					(DWT->CYCCNT)		//CPU cycles, see menu_profile.h
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS	1	//Log ring of task
+#define configCOMMAND_INT_MAX_OUTPUT_SIZE	128	//FreeRTOS+CLI output, one line at a time
 
 /* Low Power RTOS For ARM Cortex-M MCUs. */
 #define configOVERRIDE_DEFAULT_TICK_CONFIGURATION	0
@@ -131,6 +136,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			0
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetSchedulerState	1
+#define INCLUDE_pcTaskGetTaskName		1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
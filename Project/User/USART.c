@@ -1,49 +1,112 @@
 #include "USART.h"
 #include "menu_event.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stddef.h>
+#include <string.h>
 
 
 /*Tx-PB6
 	Rx-PB7
 	USART1, Pinspack2*/
 
+static uint8_t usart1_rx_buffer[USART1_RX_BUFFER_SIZE];
+static uint16_t usart1_rx_position = 0;		//DMA write position at last interrupt
+static uint32_t usart1_rx_consumed = 0;		//Bytes released by consumer
+
+volatile uint32_t USART1_RxBytes = 0;
+volatile uint32_t USART1_RxOverruns = 0;
+volatile uint32_t USART1_HwOverruns = 0;
+volatile uint8_t USART1_Interactive = USART1_KEYS;
+void (*USART1_RxNotify)(void) = NULL;
+
+#define USART1_TX_MASK	(USART1_TX_BUFFER_SIZE - 1)
+static uint8_t usart1_tx_buffer[USART1_TX_BUFFER_SIZE];
+static volatile uint16_t usart1_tx_head = 0;		//Next free byte
+static volatile uint16_t usart1_tx_tail = 0;		//First byte not sent yet (DMA is sending from here)
+static volatile uint16_t usart1_tx_dma = 0;			//Bytes in current DMA transfer, 0 if DMA is not running
+volatile uint32_t USART1_TxDropped = 0;
+
 void USART1_Init(){
 	GPIO_InitTypeDef GPIO_InitStructure;
 	USART_InitTypeDef USART_InitStructure;
 	NVIC_InitTypeDef NVIC_InitStructure;
-	
+	DMA_InitTypeDef DMA_InitStructure;
+
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
 	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOB, ENABLE);
-	
+	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2, ENABLE);
+
 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
 	GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
 	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_6 | GPIO_Pin_7;
 	GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_UP;
 	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_100MHz;
-	
+
 	GPIO_Init(GPIOB, &GPIO_InitStructure);
 	GPIO_PinAFConfig(GPIOB, GPIO_PinSource6, GPIO_AF_USART1);
 	GPIO_PinAFConfig(GPIOB, GPIO_PinSource7, GPIO_AF_USART1);
-	
-	USART_InitStructure.USART_BaudRate = 9600;
+
+	USART_InitStructure.USART_BaudRate = USART1_BAUDRATE;
 	USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
 	USART_InitStructure.USART_Parity = USART_Parity_No;
 	USART_InitStructure.USART_StopBits = USART_StopBits_1;
 	USART_InitStructure.USART_WordLength = USART_WordLength_8b;
 	USART_InitStructure.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
-	
+
 	USART_Init(USART1, &USART_InitStructure);
-	USART_ITConfig(USART1, USART_IT_RXNE, ENABLE);
+
+	//RX DMA, circular, interrupt on half and full buffer
+	DMA_DeInit(DMA2_Stream5);
+	DMA_StructInit(&DMA_InitStructure);
+	DMA_InitStructure.DMA_Channel = DMA_Channel_4;
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+	DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)usart1_rx_buffer;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+	DMA_InitStructure.DMA_BufferSize = USART1_RX_BUFFER_SIZE;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_Init(DMA2_Stream5, &DMA_InitStructure);
+	DMA_ITConfig(DMA2_Stream5, DMA_IT_HT | DMA_IT_TC, ENABLE);
+	DMA_Cmd(DMA2_Stream5, ENABLE);
+	USART_DMACmd(USART1, USART_DMAReq_Rx, ENABLE);
+
+	//TX DMA, one transfer for each continuous part of TX buffer
+	DMA_DeInit(DMA2_Stream7);
+	DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)usart1_tx_buffer;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_Init(DMA2_Stream7, &DMA_InitStructure);
+	DMA_ITConfig(DMA2_Stream7, DMA_IT_TC, ENABLE);
+	USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+
+	//Interrupt at the end of each burst instead of each byte
+	USART_ITConfig(USART1, USART_IT_IDLE, ENABLE);
 	USART_Cmd(USART1, ENABLE);
-	
+
 	NVIC_InitStructure.NVIC_IRQChannel = USART1_IRQn;
 	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 7;			//Because of FreeRTOS
 	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
 	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
 	NVIC_Init(&NVIC_InitStructure);
+	NVIC_InitStructure.NVIC_IRQChannel = DMA2_Stream5_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
+	NVIC_InitStructure.NVIC_IRQChannel = DMA2_Stream7_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
 	NVIC_PriorityGroupConfig( NVIC_PriorityGroup_4 );
 }
 
 void USART_puts(USART_TypeDef* USARTx, char* Data){
+	if(USARTx == USART1){
+		USART1_Write((uint8_t*)Data, strlen(Data));
+		return;
+	}
 	while(*Data){
 		while( !(USARTx->SR & 0x00000040) );
 		USART_SendData(USARTx, *Data);
@@ -52,18 +115,217 @@ void USART_puts(USART_TypeDef* USARTx, char* Data){
 }
 
 void USART_putc(USART_TypeDef* USARTx, char Data){
+	if(USARTx == USART1){
+		USART1_Write((uint8_t*)&Data, 1);
+		return;
+	}
 	while( !(USARTx->SR & 0x00000040) );
 	USART_SendData(USARTx, Data);
 	Data++;
 }
 
+//New bytes are between last and current DMA position
+static void USART1_RxUpdate(void){
+	uint16_t position = (USART1_RX_BUFFER_SIZE - DMA_GetCurrDataCounter(DMA2_Stream5)) & (USART1_RX_BUFFER_SIZE - 1);
+	uint16_t count = (position - usart1_rx_position) & (USART1_RX_BUFFER_SIZE - 1), i;
+	if(count == 0) return;
+
+#if USART1_ECHO == 1
+	if(USART1_Interactive == USART1_KEYS){
+		if(position > usart1_rx_position){
+			USART1_Write(usart1_rx_buffer + usart1_rx_position, count);
+		}
+		else{	//Chunk wraps around end of buffer
+			USART1_Write(usart1_rx_buffer + usart1_rx_position, USART1_RX_BUFFER_SIZE - usart1_rx_position);
+			USART1_Write(usart1_rx_buffer, position);
+		}
+	}
+#endif
+
+	//Each byte is also key event for menu
+	if(USART1_Interactive == USART1_KEYS){
+		for(i = usart1_rx_position; i != position; i = (i + 1) & (USART1_RX_BUFFER_SIZE - 1)){
+			menu_event_local(usart1_rx_buffer[i]);
+		}
+	}
+
+	usart1_rx_position = position;
+	USART1_RxBytes += count;
+
+	if(USART1_RxNotify != NULL) USART1_RxNotify();
+}
+
 void USART1_IRQHandler(){
-	uint8_t buffer;
+	uint32_t status;
   NVIC_PriorityGroupConfig( NVIC_PriorityGroup_4 ); //Na neku foru se bitovi za subriority poremete. Treba naci alternativu
-	buffer= USART1->DR;
-	menu_event_key = buffer;
-	menu_key_read = 0;
+	status = USART1->SR;
+	if(status & (USART_SR_IDLE | USART_SR_ORE)){
+		(void)USART1->DR;	//SR then DR read clears IDLE and ORE
+		if(status & USART_SR_ORE) USART1_HwOverruns++;
+		USART1_RxUpdate();
+	}
+}
+
+void DMA2_Stream5_IRQHandler(){
+	if(DMA_GetITStatus(DMA2_Stream5, DMA_IT_HTIF5)) DMA_ClearITPendingBit(DMA2_Stream5, DMA_IT_HTIF5);
+	if(DMA_GetITStatus(DMA2_Stream5, DMA_IT_TCIF5)) DMA_ClearITPendingBit(DMA2_Stream5, DMA_IT_TCIF5);
+	USART1_RxUpdate();
+}
+
+//Bytes which were overwritten by DMA are skipped
+static uint32_t USART1_Pending(void){
+	uint32_t pending = USART1_RxBytes - usart1_rx_consumed;
+	if(pending > USART1_RX_BUFFER_SIZE){
+		USART1_RxOverruns += pending - USART1_RX_BUFFER_SIZE;
+		usart1_rx_consumed = USART1_RxBytes - USART1_RX_BUFFER_SIZE;
+		pending = USART1_RX_BUFFER_SIZE;
+	}
+	return pending;
+}
 
-	USART_SendData(USART1, buffer); //Provjera
-	
+uint16_t USART1_GetChunk(uint8_t** data){
+	uint32_t pending = USART1_Pending();
+	uint16_t start = usart1_rx_consumed & (USART1_RX_BUFFER_SIZE - 1);
+	if(pending > USART1_RX_BUFFER_SIZE - start) pending = USART1_RX_BUFFER_SIZE - start;	//Until end of buffer
+	*data = usart1_rx_buffer + start;
+	return pending;
 }
+
+void USART1_ReleaseChunk(uint16_t length){
+	usart1_rx_consumed += length;
+}
+
+uint16_t USART1_Read(uint8_t* data, uint16_t size){
+	uint8_t* chunk;
+	uint16_t length, count = 0;
+	while(count < size && (length = USART1_GetChunk(&chunk)) > 0){
+		if(length > size - count) length = size - count;
+		memcpy(data + count, chunk, length);
+		USART1_ReleaseChunk(length);
+		count = count + length;
+	}
+	return count;
+}
+
+uint16_t USART1_Available(void){
+	return USART1_Pending();
+}
+
+void USART1_RxFlush(void){
+	usart1_rx_consumed = USART1_RxBytes;
+}
+
+//Start DMA for next continuous part of TX buffer, interrupts must be disabled
+static void USART1_TxStart(void){
+	uint16_t head = usart1_tx_head, tail = usart1_tx_tail;
+	if(usart1_tx_dma != 0 || head == tail) return;
+	usart1_tx_dma = (head > tail) ? (head - tail) : (USART1_TX_BUFFER_SIZE - tail);
+	DMA2_Stream7->M0AR = (uint32_t)(usart1_tx_buffer + tail);
+	DMA2_Stream7->NDTR = usart1_tx_dma;
+	DMA_ClearFlag(DMA2_Stream7, DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_FEIF7);
+	DMA_Cmd(DMA2_Stream7, ENABLE);
+}
+
+//DMA transfer finished, interrupts must be disabled
+static void USART1_TxComplete(void){
+	DMA_ClearFlag(DMA2_Stream7, DMA_FLAG_TCIF7);
+	usart1_tx_tail = (usart1_tx_tail + usart1_tx_dma) & USART1_TX_MASK;
+	usart1_tx_dma = 0;
+	USART1_TxStart();
+}
+
+void DMA2_Stream7_IRQHandler(){
+	if(DMA_GetITStatus(DMA2_Stream7, DMA_IT_TCIF7)){
+		USART1_TxComplete();
+	}
+}
+
+//Before scheduler is started or with masked interrupts, DMA interrupt can not run
+static void USART1_TxPoll(void){
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if(usart1_tx_dma != 0 && DMA_GetFlagStatus(DMA2_Stream7, DMA_FLAG_TCIF7) != RESET){
+		USART1_TxComplete();
+	}
+	__set_PRIMASK(primask);
+}
+
+static uint8_t USART1_CanWait(void){
+	return __get_IPSR() == 0 && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+uint16_t USART1_Write(uint8_t* data, uint16_t length){
+	uint16_t written = 0, count, free, head, part;
+	uint32_t primask;
+#if USART1_TX_POLICY == USART1_TX_BLOCK
+	TickType_t start = 0;
+	uint8_t waiting = 0, expired = 0;
+#endif
+
+	while(1){
+		primask = __get_PRIMASK();
+		__disable_irq();
+		free = USART1_TX_BUFFER_SIZE - 1 - ((usart1_tx_head - usart1_tx_tail) & USART1_TX_MASK);
+#if USART1_TX_POLICY == USART1_TX_OVERWRITE
+		if(free < length - written){	//Drop everything what is waiting behind current DMA transfer
+			head = (usart1_tx_tail + usart1_tx_dma) & USART1_TX_MASK;
+			USART1_TxDropped += (usart1_tx_head - head) & USART1_TX_MASK;
+			usart1_tx_head = head;
+			free = USART1_TX_BUFFER_SIZE - 1 - usart1_tx_dma;
+			if(free < length - written){	//Only end of message fits
+				USART1_TxDropped += length - written - free;
+				written = length - free;
+			}
+		}
+#endif
+		count = (free < length - written) ? free : (length - written);
+#if USART1_TX_POLICY == USART1_TX_BLOCK
+		//Message which fits in buffer is queued whole, so other task can not write into it while this one waits
+		if(!expired && count < length - written && length - written < USART1_TX_BUFFER_SIZE && USART1_CanWait()){
+			count = 0;
+		}
+#endif
+		head = usart1_tx_head;
+		part = USART1_TX_BUFFER_SIZE - head;	//Space until end of buffer
+		if(part > count) part = count;
+		memcpy(usart1_tx_buffer + head, data + written, part);
+		memcpy(usart1_tx_buffer, data + written + part, count - part);
+		usart1_tx_head = (head + count) & USART1_TX_MASK;
+		written = written + count;
+		USART1_TxStart();
+		__set_PRIMASK(primask);
+
+		if(written == length) break;
+#if USART1_TX_POLICY == USART1_TX_BLOCK
+		if(__get_IPSR() == 0){
+			if(!USART1_CanWait()){	//No scheduler, just wait for DMA
+				USART1_TxPoll();
+				continue;
+			}
+			if(!waiting){
+				waiting = 1;
+				start = xTaskGetTickCount();
+			}
+			if((xTaskGetTickCount() - start) < USART1_TX_TIMEOUT/portTICK_PERIOD_MS){
+				vTaskDelay(1);
+				continue;
+			}
+			if(!expired){	//Timeout, part which fits is queued and rest is dropped
+				expired = 1;
+				continue;
+			}
+		}
+#endif
+		USART1_TxDropped += length - written;
+		break;
+	}
+	return written;
+}
+
+void USART1_TxFlush(void){
+	while(usart1_tx_head != usart1_tx_tail){
+		if(USART1_CanWait()) vTaskDelay(1);
+		else USART1_TxPoll();
+	}
+}
+
@@ -3,9 +3,64 @@
 
 #include "stm32f4xx.h"
 
+/*USART1 RX is received by DMA in circular buffer (DMA2 Stream5 Channel4).
+	Interrupt is generated only on idle line (end of burst), half and full buffer,
+	then new bytes are handed to consumers as chunks directly from DMA buffer.
+	Buffer must be read at least once per USART1_RX_BUFFER_SIZE bytes, otherwise bytes are lost (USART1_RxOverruns).
+	
+	USART1 TX is queued in ring buffer and sent by DMA (DMA2 Stream7 Channel4), USART_puts returns immediately.
+	Each write is copied under short critical section, so it can be called from more tasks and from interrupts
+	and messages shorter than USART1_TX_BUFFER_SIZE are not mixed. When buffer is full USART1_TX_POLICY is used:
+		USART1_TX_DROP:				rest of message is dropped
+		USART1_TX_BLOCK:			task waits up to USART1_TX_TIMEOUT ms until whole message fits, then queues part which fits
+										and drops rest (interrupts never wait). Longer message is queued in parts while task waits,
+										other writes can get between them
+		USART1_TX_OVERWRITE:	queued data which is not being sent yet is dropped to make space for new one*/
+
+#define USART1_BAUDRATE					921600
+#define USART1_RX_BUFFER_SIZE		1024		//Power of 2
+#define USART1_ECHO							1				//Send received bytes back
+
+//USART1_Interactive values
+#define USART1_BINARY						0				//Only remote frames
+#define USART1_KEYS							1				//Echo, each byte is menu key
+#define USART1_SHELL						2				//Text lines for shell (menu_shell.h), shell echoes them
+
+#define USART1_TX_DROP					0
+#define USART1_TX_BLOCK					1
+#define USART1_TX_OVERWRITE			2
+
+#define USART1_TX_BUFFER_SIZE		1024		//Power of 2
+#define USART1_TX_POLICY				USART1_TX_BLOCK
+#define USART1_TX_TIMEOUT				20			//ms, only for USART1_TX_BLOCK
+
+extern volatile uint32_t USART1_RxBytes;			//All received bytes
+extern volatile uint32_t USART1_RxOverruns;		//Bytes overwritten in buffer before they were read
+extern volatile uint32_t USART1_HwOverruns;		//USART overrun errors (byte lost in hardware)
+extern volatile uint32_t USART1_TxDropped;		//Bytes not sent because TX buffer was full
+extern volatile uint8_t USART1_Interactive;		//USART1_KEYS, USART1_SHELL or USART1_BINARY (set by binary remote)
+
 void USART1_Init(void);
 void USART_puts(USART_TypeDef* USARTx, char* Data);
 void USART1_IRQHandler();
-void USART_putc(USART_TypeDef* USARTx, char Data);
+void DMA2_Stream5_IRQHandler();
+void DMA2_Stream7_IRQHandler();
+void USART_putc(USART_TypeDef* USARTx, char Data);	//USART1 is not blocking, other USARTs wait for each byte
+
+//Queue data for sending, returns number of queued bytes
+uint16_t USART1_Write(uint8_t* data, uint16_t length);
+//Wait until all queued data is sent
+void USART1_TxFlush(void);
+
+//Received data, returns number of bytes in chunk (0 if nothing new) and pointer to it.
+//Chunk is continuous part of DMA buffer, it has to be released after it is processed.
+uint16_t USART1_GetChunk(uint8_t** data);
+void USART1_ReleaseChunk(uint16_t length);
+uint16_t USART1_Read(uint8_t* data, uint16_t size);	//Copy received bytes
+uint16_t USART1_Available(void);
+void USART1_RxFlush(void);	//Forget all received bytes
+
+//Called from interrupt when new chunk is received, can be set by consumer (for example to give semaphore)
+extern void (*USART1_RxNotify)(void);
 
 #endif
@@ -49,6 +49,35 @@
 
 #define TM_SPI1_PRESCALER	SPI_BaudRatePrescaler_2
 
+/* DMA for ILI9341 pixel streams, SPI1 TX */
+#define ILI9341_USE_DMA				1
+#define ILI9341_DMA_CLK				RCC_AHB1Periph_DMA2
+#define ILI9341_DMA_STREAM			DMA2_Stream3
+#define ILI9341_DMA_CHANNEL			DMA_Channel_3
+#define ILI9341_DMA_FLAG_TC			DMA_FLAG_TCIF3
+#define ILI9341_DMA_FLAGS			(DMA_FLAG_TCIF3 | DMA_FLAG_HTIF3 | DMA_FLAG_TEIF3 | DMA_FLAG_DMEIF3 | DMA_FLAG_FEIF3)
+
+/* SD card on SPI4 (PE2 SCK, PE5 MISO, PE6 MOSI), SPI1 is used by LCD */
+#define FATFS_SPI					SPI4
+#define FATFS_SPI_PINSPACK			TM_SPI_PinsPack_1
+#define FATFS_CS_PORT				GPIOE
+#define FATFS_CS_PIN				GPIO_PIN_4
+#define FATFS_USE_DMA				1
+#define FATFS_DMA_CLK				RCC_AHB1Periph_DMA2
+#define FATFS_DMA_RX_STREAM			DMA2_Stream0
+#define FATFS_DMA_RX_CHANNEL		DMA_Channel_4
+#define FATFS_DMA_RX_FLAG_TC		DMA_FLAG_TCIF0
+#define FATFS_DMA_RX_FLAGS			(DMA_FLAG_TCIF0 | DMA_FLAG_HTIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0)
+#define FATFS_DMA_TX_STREAM			DMA2_Stream1
+#define FATFS_DMA_TX_CHANNEL		DMA_Channel_4
+#define FATFS_DMA_TX_FLAGS			(DMA_FLAG_TCIF1 | DMA_FLAG_HTIF1 | DMA_FLAG_TEIF1 | DMA_FLAG_DMEIF1 | DMA_FLAG_FEIF1)
+/* FatFs sector cache, 8 sets x 4 sectors = 16 kB */
+#define FATFS_CACHE_ENABLED			1
+#define FATFS_CACHE_SETS			8
+#define FATFS_CACHE_WAYS			4
+/* FatFs read-ahead and write-behind task */
+#define FATFS_WORKER_ENABLED		1
+
 /////////////////////
 
 #define XPT2046_CS_PORT	GPIOB
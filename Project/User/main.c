@@ -1,6 +1,9 @@
 #include "main.h"
 #include "USART.h"
 #include "XPT2046.h"
+#include "menu_remote.h"
+#include "menu_log.h"
+#include "menu_shell.h"
 
 ////////////////////////////////////////////////////
 __ALIGN_BEGIN USB_OTG_CORE_HANDLE      USB_OTG_Core __ALIGN_END;
@@ -10,8 +13,10 @@ __ALIGN_BEGIN USBH_HOST                USB_Host __ALIGN_END;
 
 ////////////////////////////////////////////////////
 void RTOS_test(){
+	uint32_t count = 0;
+	menu_log_register();
 	while(1){
-		USART_puts(USART1, "Zdravo");
+		LOG1("Zdravo %u", count++);
 		vTaskDelay(200);
 	}
 }
@@ -19,6 +24,7 @@ void RTOS_test(){
 
 ////////////////////////////////////////////////////
 void menu_task(){
+	menu_log_register();
 	menu_touch_init();
 	while(1){
 		cycle_menu(&main_menu);
@@ -72,7 +78,8 @@ int main(void) {
 		
 		////////////////////////////
 		USART1_Init();
-		USART_puts(USART1, "Zdravo");
+		menu_log_init();
+		LOG0("Start");
 		
 		TM_ILI9341_Puts(0, 10+40, "Test1Test1Test1", &TM_Font_11x18, ILI9341_COLOR_BLACK, ILI9341_TRANSPARENT);
 		TM_ILI9341_DrawCircle(240-20, 20+40, 10, ILI9341_COLOR_BLACK);
@@ -84,6 +91,8 @@ int main(void) {
 //		}
 		xTaskCreate(RTOS_test , "Test", 512, NULL, 1, NULL );
 		xTaskCreate(menu_task , "Menu", 2048, NULL, 1, NULL );
+		menu_remote_init();
+		menu_shell_init(&main_menu);
 //		xTaskCreate(usb_task , "USB", 2048, NULL, 1, NULL );
 
 		vTaskStartScheduler();
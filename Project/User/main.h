@@ -17,6 +17,7 @@
 #include "menu_functions.h"
 #include "menu_touch.h"
 #include "menu_button.h"
+#include "menu_icons.h"
 
 #include "usbh_core.h"
 #include "usbh_usr.h"
@@ -48,7 +49,10 @@ menu LED_Main_Menu =
     {
         "LED",
         LED,
-        0
+        0,
+				{NULL},
+				0, 0, 0, 0,
+				MENU_ICON_LED
     };
 menu Info_Main_Menu =
     {
@@ -56,7 +60,8 @@ menu Info_Main_Menu =
         NULL,
         2,
 				{&Version_Info, &Author_Info},
-				1
+				1, 0, 0, 0,
+				MENU_ICON_INFO
     };
  
 menu Voltmeter_Main_Menu =
@@ -77,7 +82,10 @@ menu Terminal_Main_Menu =
     {
         "Terminal",
         terminal,
-        0
+        0,
+				{NULL},
+				0, 0, 0, 0,
+				MENU_ICON_TERMINAL
     };
  
 menu Calculator_Main_Menu =
@@ -108,10 +116,37 @@ menu Apocalypse_Main_Menu =
         0
     };
 
+menu Images_Main_Menu =
+		{
+				"Images",
+				images,
+				0,
+				{NULL},
+				0, 0, 0, 0,
+				MENU_ICON_IMAGE
+		};
+
 menu Touch_Main_Menu =
 		{
 				"Touch",
 				touch,
+				0,
+				{NULL},
+				0, 0, 0, 0,
+				MENU_ICON_TOUCH
+		};
+		
+menu Files_Main_Menu =
+		{
+				"Files",
+				files,
+				0
+		};
+		
+menu Stats_Main_Menu =
+		{
+				"Stats",
+				stats,
 				0
 		};
 		
@@ -119,8 +154,8 @@ menu main_menu =
     {
         "Main Menu",
         NULL,
-        10,
-        {&LED_Main_Menu, &Voltmeter_Main_Menu, &Clock_Main_Menu, &Terminal_Main_Menu, &Calculator_Main_Menu, &Notepad_Main_Menu, &WorldDomination_Main_Menu, &Apocalypse_Main_Menu, &Info_Main_Menu, &Touch_Main_Menu},
+        13,
+        {&LED_Main_Menu, &Voltmeter_Main_Menu, &Clock_Main_Menu, &Terminal_Main_Menu, &Calculator_Main_Menu, &Notepad_Main_Menu, &WorldDomination_Main_Menu, &Apocalypse_Main_Menu, &Info_Main_Menu, &Touch_Main_Menu, &Images_Main_Menu, &Files_Main_Menu, &Stats_Main_Menu},
 				1
     };
 
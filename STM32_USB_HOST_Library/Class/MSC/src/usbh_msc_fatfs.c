@@ -2,6 +2,7 @@
 #include "usb_conf.h"
 #include "diskio.h"
 #include "usbh_msc_core.h"
+#include "menu_profile.h"
 /*--------------------------------------------------------------------------
 
 Module Private Functions and Variables
@@ -52,7 +53,7 @@ DSTATUS disk_status (
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
+static DRESULT usb_disk_read (
                    BYTE drv,			/* Physical drive number (0) */
                    BYTE *buff,			/* Pointer to the data buffer to store read data */
                    DWORD sector,		/* Start sector number (LBA) */
@@ -87,6 +88,19 @@ DRESULT disk_read (
   
 }
 
+DRESULT disk_read (
+                   BYTE drv,			/* Physical drive number (0) */
+                   BYTE *buff,			/* Pointer to the data buffer to store read data */
+                   DWORD sector,		/* Start sector number (LBA) */
+                   BYTE count			/* Sector count (1..255) */
+                     )
+{
+  uint32_t start = menu_profile_start();
+  DRESULT result = usb_disk_read(drv, buff, sector, count);
+  menu_profile_stop(MENU_PROFILE_DISK_READ, start);
+  return result;
+}
+
 
 
 /*-----------------------------------------------------------------------*/
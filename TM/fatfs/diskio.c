@@ -9,6 +9,12 @@
 
 #include "diskio.h"		/* FatFs lower layer API */
 #include "ff.h"
+#include <string.h>
+#if FATFS_WORKER_ENABLED == 1
+	#include "FreeRTOS.h"
+	#include "task.h"
+	#include "semphr.h"
+#endif
 
 /* Not USB in use */
 /* Define it in defines.h project file if you want to use USB */
@@ -16,6 +22,14 @@
 	#define FATFS_USE_USB				0
 #endif
 
+/* RAM disk and disk image file (POSIX, host build), set in defines.h */
+#ifndef FATFS_USE_RAM
+	#define FATFS_USE_RAM				0
+#endif
+#ifndef FATFS_USE_IMAGE
+	#define FATFS_USE_IMAGE				0
+#endif
+
 /* Set in defines.h file if you want it */
 #ifndef TM_FATFS_CUSTOM_FATTIME
 	#define TM_FATFS_CUSTOM_FATTIME		0
@@ -42,6 +56,13 @@
 	#include "fatfs_usb.h"
 #endif 	/* FATFS_USE_USB */
 
+#if FATFS_USE_RAM == 1
+	#include "fatfs_ram.h"
+#endif
+#if FATFS_USE_IMAGE == 1
+	#include "fatfs_image.h"
+#endif
+
 /* Include SD card files if is enabled */
 #if FATFS_USE_SDIO == 1
 	#include "fatfs_sd_sdio.h"
@@ -53,6 +74,29 @@
 /* Definitions of physical drive number for each media */
 #define ATA		0
 #define USB		1
+#define RAM		2
+#define IMAGE	3
+
+/* Drives with own cache and worker state */
+#if FATFS_USE_IMAGE == 1
+	#define DRIVES	4
+#elif FATFS_USE_RAM == 1
+	#define DRIVES	3
+#elif FATFS_USE_USB == 1
+	#define DRIVES	2
+#else
+	#define DRIVES	1
+#endif
+
+#if FATFS_WORKER_ENABLED == 1
+static void worker_init (void);
+static void media_lock (BYTE pdrv);
+static void media_unlock (BYTE pdrv);
+#else
+#define worker_init()
+#define media_lock(pdrv)
+#define media_unlock(pdrv)
+#endif
 
 /*-----------------------------------------------------------------------*/
 /* Inidialize a Drive                                                    */
@@ -63,6 +107,8 @@ DSTATUS disk_initialize (
 )
 {
 	DSTATUS status = STA_NOINIT;
+	worker_init();
+	media_lock(pdrv);
 	switch (pdrv) {
 		case ATA:	/* SD CARD */
 			#if FATFS_USE_SDIO == 1
@@ -76,9 +122,21 @@ DSTATUS disk_initialize (
 				status = TM_FATFS_USB_disk_initialize();			/* USB */
 			#endif
 			break;
+		case RAM:	/* RAM disk */
+			#if FATFS_USE_RAM == 1
+				status = TM_FATFS_RAM_disk_initialize();
+			#endif
+			break;
+		case IMAGE:	/* Disk image file */
+			#if FATFS_USE_IMAGE == 1
+				status = TM_FATFS_IMAGE_disk_initialize();
+			#endif
+			break;
 		default:
 			status = STA_NOINIT;
 	}
+	media_unlock(pdrv);
+	disk_cache_invalidate(pdrv);	/* Card could be changed */
 	
 	return status;
 }
@@ -109,6 +167,16 @@ DSTATUS disk_status (
 				status = TM_FATFS_USB_disk_status();				/* USB */
 			#endif
 			break;
+		case RAM:	/* RAM disk */
+			#if FATFS_USE_RAM == 1
+				status = TM_FATFS_RAM_disk_status();
+			#endif
+			break;
+		case IMAGE:	/* Disk image file */
+			#if FATFS_USE_IMAGE == 1
+				status = TM_FATFS_IMAGE_disk_status();
+			#endif
+			break;
 		default:
 			status = STA_NOINIT;
 	}
@@ -119,10 +187,10 @@ DSTATUS disk_status (
 
 
 /*-----------------------------------------------------------------------*/
-/* Read Sector(s)                                                        */
+/* Read Sector(s) from drive                                             */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
+static DRESULT drive_read (
 	BYTE pdrv,		/* Physical drive nmuber (0..) */
 	BYTE *buff,		/* Data buffer to store read data */
 	DWORD sector,	/* Sector address (LBA) */
@@ -143,21 +211,35 @@ DRESULT disk_read (
 				status = TM_FATFS_USB_disk_read(buff, sector, count);			/* USB */
 			#endif
 			break;
+		case RAM:	/* RAM disk */
+			#if FATFS_USE_RAM == 1
+				status = TM_FATFS_RAM_disk_read(buff, sector, count);
+			#endif
+			break;
+		case IMAGE:	/* Disk image file */
+			#if FATFS_USE_IMAGE == 1
+				status = TM_FATFS_IMAGE_disk_read(buff, sector, count);
+			#endif
+			break;
 		default:
 			status = RES_PARERR;
 	}
 	
+	if (status == RES_OK) {
+		disk_cache_stats.reads++;
+		disk_cache_stats.read_sectors += count;
+	}
 	return status;
 }
 
 
 
 /*-----------------------------------------------------------------------*/
-/* Write Sector(s)                                                       */
+/* Write Sector(s) to drive                                              */
 /*-----------------------------------------------------------------------*/
 
 #if _USE_WRITE
-DRESULT disk_write (
+static DRESULT drive_write (
 	BYTE pdrv,			/* Physical drive nmuber (0..) */
 	const BYTE *buff,	/* Data to be written */
 	DWORD sector,		/* Sector address (LBA) */
@@ -182,21 +264,35 @@ DRESULT disk_write (
 				status = TM_FATFS_USB_disk_write(buff, sector, count);					/* USB */
 			#endif
 			break;
+		case RAM:	/* RAM disk */
+			#if FATFS_USE_RAM == 1
+				status = TM_FATFS_RAM_disk_write(buff, sector, count);
+			#endif
+			break;
+		case IMAGE:	/* Disk image file */
+			#if FATFS_USE_IMAGE == 1
+				status = TM_FATFS_IMAGE_disk_write(buff, sector, count);
+			#endif
+			break;
 		default:
 			status = RES_PARERR;
 	}
 	
+	if (status == RES_OK) {
+		disk_cache_stats.writes++;
+		disk_cache_stats.write_sectors += count;
+	}
 	return status;
 }
 #endif
 
 
 /*-----------------------------------------------------------------------*/
-/* Miscellaneous Functions                                               */
+/* Miscellaneous Functions of drive                                      */
 /*-----------------------------------------------------------------------*/
 
 #if _USE_IOCTL
-DRESULT disk_ioctl (
+static DRESULT drive_ioctl (
 	BYTE pdrv,		/* Physical drive nmuber (0..) */
 	BYTE cmd,		/* Control code */
 	void *buff		/* Buffer to send/receive control data */
@@ -216,6 +312,16 @@ DRESULT disk_ioctl (
 				status = TM_FATFS_USB_disk_ioctl(cmd, buff);						/* USB */
 			#endif
 			break;
+		case RAM:	/* RAM disk */
+			#if FATFS_USE_RAM == 1
+				status = TM_FATFS_RAM_disk_ioctl(cmd, buff);
+			#endif
+			break;
+		case IMAGE:	/* Disk image file */
+			#if FATFS_USE_IMAGE == 1
+				status = TM_FATFS_IMAGE_disk_ioctl(cmd, buff);
+			#endif
+			break;
 		default:
 			status = RES_PARERR;
 	}
@@ -223,6 +329,601 @@ DRESULT disk_ioctl (
 }
 #endif
 
+/*-----------------------------------------------------------------------*/
+/* Read-ahead and write-behind worker                                    */
+/*-----------------------------------------------------------------------*/
+/* FreeRTOS task between cache and drive. Writes are copied to queue of  */
+/* FATFS_WORKER_WRITES sectors and written by worker in order, runs of   */
+/* consecutive sectors with one command. Error is reported by next write */
+/* or CTRL_SYNC, which waits until sectors of drive are written.        */
+/* When read continues where previous read of drive ended, worker reads  */
+/* next FATFS_WORKER_AHEAD sectors into one of two buffers, the other    */
+/* buffer is filled when reader gets into the first one.                 */
+/* Reads see queued writes, written sectors drop read-ahead buffers.     */
+/* Each drive has its own mutex and read-ahead buffers, one task per    */
+/* drive is expected (FatFs volume lock). Task waiting for worker waits  */
+/* on semaphore of its drive, worker gives semaphores of all drives      */
+/* after each write, waiter checks its condition again (also after a     */
+/* timeout). Before scheduler is started everything goes straight to    */
+/* drive.                                                                */
+/*-----------------------------------------------------------------------*/
+
+#if FATFS_WORKER_ENABLED == 1
+
+#define AHEAD_EMPTY		0
+#define AHEAD_REQUESTED	1
+#define AHEAD_FILLING	2
+#define AHEAD_READY		3
+
+typedef struct {
+	DWORD sector;
+	volatile BYTE state;
+	DWORD data[FATFS_WORKER_AHEAD][_MAX_SS / 4];
+} AHEAD_BUFFER;
+
+typedef struct {
+	DWORD sector;
+	BYTE pdrv;
+} WRITE_SLOT;
+
+static AHEAD_BUFFER worker_ahead[DRIVES][2];
+static WRITE_SLOT worker_slots[FATFS_WORKER_WRITES];
+static DWORD worker_slot_data[FATFS_WORKER_WRITES][_MAX_SS / 4];
+static volatile UINT worker_head = 0, worker_tail = 0, worker_pending = 0;
+static volatile UINT worker_queued[DRIVES];		/* Queued sectors of drive */
+static volatile DRESULT worker_error[DRIVES];	/* Failed write */
+static DWORD worker_last[DRIVES];				/* Sector after last read of drive */
+static SemaphoreHandle_t worker_media[DRIVES];	/* Drive and its read-ahead buffers */
+static SemaphoreHandle_t worker_work = NULL;	/* Writes queued or read-ahead requested */
+static SemaphoreHandle_t worker_done[DRIVES];	/* Queued sectors were written, one waiter per drive */
+
+static BYTE worker_running (void) {
+	return worker_work != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+static void media_lock (BYTE pdrv) {
+	if (pdrv < DRIVES && worker_running()) {
+		xSemaphoreTake(worker_media[pdrv], portMAX_DELAY);
+	}
+}
+
+static void media_unlock (BYTE pdrv) {
+	if (pdrv < DRIVES && worker_running()) {
+		xSemaphoreGive(worker_media[pdrv]);
+	}
+}
+
+/* Drop read-ahead sectors which will be overwritten */
+static void worker_ahead_drop (BYTE pdrv, DWORD sector, UINT count) {
+	AHEAD_BUFFER *ahead = worker_ahead[pdrv];
+	BYTE i;
+	taskENTER_CRITICAL();
+	for (i = 0; i < 2; i++) {
+		if (ahead[i].state != AHEAD_EMPTY &&
+			sector < ahead[i].sector + FATFS_WORKER_AHEAD && ahead[i].sector < sector + count) {
+			ahead[i].state = AHEAD_EMPTY;	/* Worker drops it if it is filling */
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+/* Buffer which is (or will be) filled with sector, -1 if there is none */
+static int worker_ahead_find (BYTE pdrv, DWORD sector) {
+	AHEAD_BUFFER *ahead = worker_ahead[pdrv];
+	int i;
+	for (i = 0; i < 2; i++) {
+		if (ahead[i].state != AHEAD_EMPTY && sector >= ahead[i].sector && sector - ahead[i].sector < FATFS_WORKER_AHEAD) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* After sequential read of sector..end-1, keep next FATFS_WORKER_AHEAD sectors requested */
+static void worker_ahead_request (BYTE pdrv, DWORD sector, DWORD end) {
+	AHEAD_BUFFER *ahead = worker_ahead[pdrv];
+	DWORD next = end;
+	int i = worker_ahead_find(pdrv, next);
+	if (i >= 0) {
+		next = ahead[i].sector + FATFS_WORKER_AHEAD;
+		if (worker_ahead_find(pdrv, next) >= 0) {
+			return;		/* Both buffers are ahead of reader */
+		}
+		i = 1 - i;
+	} else {
+		i = worker_ahead_find(pdrv, sector);		/* Keep buffer which is being read */
+		i = i == 0 ? 1 : 0;
+	}
+	taskENTER_CRITICAL();
+	ahead[i].sector = next;
+	ahead[i].state = AHEAD_REQUESTED;
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(worker_work);
+}
+
+static void worker_write_queued (void) {
+	UINT first, count;
+	BYTE pdrv;
+	DRESULT status;
+	first = worker_tail;
+	pdrv = worker_slots[first].pdrv;
+	count = 1;
+	while (count < worker_pending && first + count < FATFS_WORKER_WRITES &&
+		worker_slots[first + count].pdrv == pdrv &&
+		worker_slots[first + count].sector == worker_slots[first].sector + count) {
+		count++;
+	}
+	xSemaphoreTake(worker_media[pdrv], portMAX_DELAY);
+	status = drive_write(pdrv, (BYTE *)worker_slot_data[first], worker_slots[first].sector, count);
+	taskENTER_CRITICAL();
+	if (status != RES_OK) {
+		worker_error[pdrv] = status;
+	}
+	worker_tail = (first + count) % FATFS_WORKER_WRITES;
+	worker_pending -= count;
+	worker_queued[pdrv] -= count;
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(worker_media[pdrv]);
+	for (pdrv = 0; pdrv < DRIVES; pdrv++) {
+		xSemaphoreGive(worker_done[pdrv]);	/* Slots are free for any drive */
+	}
+}
+
+static void worker_read_ahead (BYTE pdrv, AHEAD_BUFFER *ahead) {
+	DRESULT status;
+	xSemaphoreTake(worker_media[pdrv], portMAX_DELAY);
+	taskENTER_CRITICAL();
+	if (ahead->state != AHEAD_REQUESTED) {
+		taskEXIT_CRITICAL();
+		xSemaphoreGive(worker_media[pdrv]);
+		return;
+	}
+	ahead->state = AHEAD_FILLING;
+	taskEXIT_CRITICAL();
+	status = drive_read(pdrv, (BYTE *)ahead->data, ahead->sector, FATFS_WORKER_AHEAD);	/* Can fail at end of disk */
+	taskENTER_CRITICAL();
+	if (ahead->state == AHEAD_FILLING) {
+		ahead->state = status == RES_OK ? AHEAD_READY : AHEAD_EMPTY;
+	}
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(worker_media[pdrv]);
+}
+
+static void worker_task (void *parameters) {
+	BYTE pdrv, i;
+	for (;;) {
+		xSemaphoreTake(worker_work, portMAX_DELAY);
+		/* Writes first, read-ahead must not get older data */
+		while (worker_pending > 0) {
+			worker_write_queued();
+		}
+		for (pdrv = 0; pdrv < DRIVES; pdrv++) {
+			for (i = 0; i < 2; i++) {
+				if (worker_ahead[pdrv][i].state == AHEAD_REQUESTED) {
+					worker_read_ahead(pdrv, &worker_ahead[pdrv][i]);
+				}
+			}
+		}
+	}
+}
+
+static void worker_init (void) {
+	BYTE pdrv;
+	if (worker_work != NULL) {
+		return;
+	}
+	for (pdrv = 0; pdrv < DRIVES; pdrv++) {
+		worker_media[pdrv] = xSemaphoreCreateMutex();
+		worker_done[pdrv] = xSemaphoreCreateBinary();
+	}
+	worker_work = xSemaphoreCreateBinary();
+	xTaskCreate(worker_task, "Disk", FATFS_WORKER_STACK, NULL, FATFS_WORKER_PRIORITY, NULL);
+}
+
+/* Wait until all queued sectors are written, returns and clears write error of drive */
+static DRESULT worker_drain (BYTE pdrv) {
+	DRESULT status;
+	if (pdrv >= DRIVES) {
+		return RES_OK;
+	}
+	while (worker_running() && worker_queued[pdrv] > 0) {
+		xSemaphoreTake(worker_done[pdrv], FATFS_WORKER_WAIT);
+	}
+	taskENTER_CRITICAL();
+	status = worker_error[pdrv];
+	worker_error[pdrv] = RES_OK;
+	taskEXIT_CRITICAL();
+	return status;
+}
+
+static DRESULT media_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+	AHEAD_BUFFER *ahead;
+	DRESULT status;
+	UINT i, slot, pending;
+	int found;
+	if (pdrv >= DRIVES || !worker_running()) {
+		return drive_read(pdrv, buff, sector, count);
+	}
+	xSemaphoreTake(worker_media[pdrv], portMAX_DELAY);
+	found = worker_ahead_find(pdrv, sector);
+	ahead = &worker_ahead[pdrv][found < 0 ? 0 : found];
+	if (found >= 0 && ahead->state == AHEAD_READY && sector - ahead->sector + count <= FATFS_WORKER_AHEAD) {
+		memcpy(buff, ahead->data[sector - ahead->sector], count * _MAX_SS);
+		disk_cache_stats.ahead += count;
+		status = RES_OK;
+	} else {
+		status = drive_read(pdrv, buff, sector, count);
+	}
+	/* Queued writes are newer than drive */
+	slot = worker_tail;
+	pending = worker_pending;
+	for (i = 0; i < pending && status == RES_OK; i++) {
+		if (worker_slots[slot].pdrv == pdrv && worker_slots[slot].sector >= sector && worker_slots[slot].sector - sector < count) {
+			memcpy(buff + (worker_slots[slot].sector - sector) * _MAX_SS, worker_slot_data[slot], _MAX_SS);
+		}
+		slot = (slot + 1) % FATFS_WORKER_WRITES;
+	}
+	xSemaphoreGive(worker_media[pdrv]);
+	if (status == RES_OK && sector == worker_last[pdrv]) {
+		worker_ahead_request(pdrv, sector, sector + count);
+	}
+	worker_last[pdrv] = sector + count;
+	return status;
+}
+
+static DRESULT media_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+	DRESULT status;
+	BYTE queued;
+	if (pdrv >= DRIVES || !worker_running()) {
+		return drive_write(pdrv, buff, sector, count);
+	}
+	worker_ahead_drop(pdrv, sector, count);
+	while (count > 0) {
+		/* Sector is copied in critical section, other drive can queue at the same time */
+		taskENTER_CRITICAL();
+		queued = worker_pending < FATFS_WORKER_WRITES;
+		if (queued) {
+			worker_slots[worker_head].pdrv = pdrv;
+			worker_slots[worker_head].sector = sector;
+			memcpy(worker_slot_data[worker_head], buff, _MAX_SS);
+			worker_head = (worker_head + 1) % FATFS_WORKER_WRITES;
+			worker_pending++;
+			worker_queued[pdrv]++;
+		}
+		taskEXIT_CRITICAL();
+		if (!queued) {
+			xSemaphoreTake(worker_done[pdrv], FATFS_WORKER_WAIT);
+			continue;
+		}
+		xSemaphoreGive(worker_work);
+		disk_cache_stats.behind++;
+		buff += _MAX_SS;
+		sector++;
+		count--;
+	}
+	taskENTER_CRITICAL();
+	status = worker_error[pdrv];
+	worker_error[pdrv] = RES_OK;
+	taskEXIT_CRITICAL();
+	return status;
+}
+
+#else
+
+#define worker_drain(pdrv)	RES_OK
+#define media_read			drive_read
+#define media_write			drive_write
+
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Sector cache                                                          */
+/*-----------------------------------------------------------------------*/
+/* Single sector requests go through N-way set-associative cache, these  */
+/* are FAT, directory and partial file sectors (window of FatFs and FIL  */
+/* buffers). Writes stay in cache (write-back) until line is evicted or  */
+/* CTRL_SYNC is received. Multi sector requests are bulk file data, they */
+/* go straight to drive and do not evict anything.                       */
+/* Line which is hit again is protected, FAT and directory sectors are   */
+/* read many times, streamed data once. Protected line is evicted only   */
+/* when there is no unprotected line in set, at most WAYS-1 are          */
+/* protected, so data can still use one way of each set.                 */
+/* Each drive has its own lines, so volumes on SD card and USB can be    */
+/* used from two tasks at the same time.                                 */
+/*-----------------------------------------------------------------------*/
+
+DCACHE_STATS disk_cache_stats;
+
+#if FATFS_CACHE_ENABLED == 1
+
+#define CACHE_LINES		(FATFS_CACHE_SETS * FATFS_CACHE_WAYS)
+#define CACHE_VALID		0x01
+#define CACHE_DIRTY		0x02
+#define CACHE_PROTECTED	0x04
+
+typedef struct {
+	DWORD sector;
+	DWORD used;		/* Access stamp for LRU */
+	BYTE pdrv;
+	BYTE flags;
+} CACHE_LINE;
+
+static CACHE_LINE cache_lines[DRIVES * CACHE_LINES];
+static DWORD cache_data[DRIVES * CACHE_LINES][_MAX_SS / 4];	/* Word aligned for DMA */
+static DWORD cache_clock[DRIVES];
+
+#define CACHE_BUFFER(line)	((BYTE *)cache_data[line])
+#define CACHE_SET(pdrv, sector)	((pdrv) * CACHE_LINES + ((sector) & (FATFS_CACHE_SETS - 1)) * FATFS_CACHE_WAYS)
+
+/* Line with sector, -1 if it is not in cache */
+static int cache_find (BYTE pdrv, DWORD sector) {
+	int line = CACHE_SET(pdrv, sector);
+	int end = line + FATFS_CACHE_WAYS;
+	for (; line < end; line++) {
+		if ((cache_lines[line].flags & CACHE_VALID) && cache_lines[line].sector == sector) {
+			return line;
+		}
+	}
+	return -1;
+}
+
+/* Write line to drive if it is dirty */
+static DRESULT cache_clean (int line) {
+	DRESULT status;
+	if (!(cache_lines[line].flags & CACHE_DIRTY)) {
+		return RES_OK;
+	}
+	status = media_write(cache_lines[line].pdrv, CACHE_BUFFER(line), cache_lines[line].sector, 1);
+	if (status == RES_OK) {
+		cache_lines[line].flags &= ~CACHE_DIRTY;
+		disk_cache_stats.writebacks++;
+	}
+	return status;
+}
+
+/* Update LRU stamp, second access protects line */
+static void cache_touch (int line, BYTE hit) {
+	int first = line - line % FATFS_CACHE_WAYS, i, oldest = -1, count = 0;
+	if (hit && !(cache_lines[line].flags & CACHE_PROTECTED) && FATFS_CACHE_WAYS > 1) {
+		for (i = first; i < first + FATFS_CACHE_WAYS; i++) {
+			if (cache_lines[i].flags & CACHE_PROTECTED) {
+				count++;
+				if (oldest < 0 || cache_lines[i].used < cache_lines[oldest].used) {
+					oldest = i;
+				}
+			}
+		}
+		if (count >= FATFS_CACHE_WAYS - 1) {
+			cache_lines[oldest].flags &= ~CACHE_PROTECTED;	/* Back to LRU of data lines */
+		}
+		cache_lines[line].flags |= CACHE_PROTECTED;
+	}
+	cache_lines[line].used = ++cache_clock[cache_lines[line].pdrv];
+}
+
+/* Free line in set of sector: empty, least recently used unprotected or least recently used */
+static DRESULT cache_victim (BYTE pdrv, DWORD sector, int *victim) {
+	int first = CACHE_SET(pdrv, sector), line, best = -1;
+	DRESULT status;
+	for (line = first; line < first + FATFS_CACHE_WAYS; line++) {
+		if (!(cache_lines[line].flags & CACHE_VALID)) {
+			best = line;
+			break;
+		}
+		if (best < 0 ||
+			(cache_lines[best].flags & CACHE_PROTECTED) > (cache_lines[line].flags & CACHE_PROTECTED) ||
+			((cache_lines[best].flags & CACHE_PROTECTED) == (cache_lines[line].flags & CACHE_PROTECTED) && cache_lines[line].used < cache_lines[best].used)) {
+			best = line;
+		}
+	}
+	status = cache_clean(best);
+	if (status != RES_OK) {
+		return status;
+	}
+	cache_lines[best].flags = 0;
+	*victim = best;
+	return RES_OK;
+}
+
+static DRESULT cache_read (BYTE pdrv, BYTE *buff, DWORD sector) {
+	int line = cache_find(pdrv, sector);
+	DRESULT status;
+	if (line >= 0) {
+		disk_cache_stats.hits++;
+		cache_touch(line, 1);
+	} else {
+		disk_cache_stats.misses++;
+		status = cache_victim(pdrv, sector, &line);
+		if (status != RES_OK) {
+			return status;
+		}
+		status = media_read(pdrv, CACHE_BUFFER(line), sector, 1);
+		if (status != RES_OK) {
+			return status;
+		}
+		cache_lines[line].pdrv = pdrv;
+		cache_lines[line].sector = sector;
+		cache_lines[line].flags = CACHE_VALID;
+		cache_touch(line, 0);
+	}
+	memcpy(buff, CACHE_BUFFER(line), _MAX_SS);
+	return RES_OK;
+}
+
+static DRESULT cache_write (BYTE pdrv, const BYTE *buff, DWORD sector) {
+	int line = cache_find(pdrv, sector);
+	DRESULT status;
+	if (line >= 0) {
+		disk_cache_stats.hits++;
+		cache_touch(line, 1);
+	} else {
+		disk_cache_stats.misses++;
+		status = cache_victim(pdrv, sector, &line);
+		if (status != RES_OK) {
+			return status;
+		}
+		cache_lines[line].pdrv = pdrv;
+		cache_lines[line].sector = sector;
+		cache_touch(line, 0);
+	}
+	memcpy(CACHE_BUFFER(line), buff, _MAX_SS);
+	cache_lines[line].flags |= CACHE_VALID | CACHE_DIRTY;
+	return RES_OK;
+}
+
+/* Multi sector request done on drive, cached sectors in range are newer (read) or older (write) */
+static void cache_bypass (BYTE pdrv, BYTE *buff, DWORD sector, UINT count, BYTE write) {
+	int line;
+	for (line = pdrv * CACHE_LINES; line < (pdrv + 1) * CACHE_LINES; line++) {
+		if ((cache_lines[line].flags & CACHE_VALID) &&
+			cache_lines[line].sector >= sector && cache_lines[line].sector - sector < count) {
+			if (write) {
+				memcpy(CACHE_BUFFER(line), buff + (cache_lines[line].sector - sector) * _MAX_SS, _MAX_SS);
+				cache_lines[line].flags &= ~CACHE_DIRTY;
+			} else if (cache_lines[line].flags & CACHE_DIRTY) {
+				memcpy(buff + (cache_lines[line].sector - sector) * _MAX_SS, CACHE_BUFFER(line), _MAX_SS);
+			}
+		}
+	}
+	disk_cache_stats.bypass += count;
+}
+
+#endif
+
+DRESULT disk_cache_flush (
+	BYTE pdrv		/* Physical drive nmuber (0..) */
+)
+{
+#if FATFS_CACHE_ENABLED == 1
+	int line;
+	BYTE pass;
+	DRESULT status;
+	if (pdrv >= DRIVES) {
+		return RES_OK;
+	}
+	/* File data first, FAT and directory after it */
+	for (pass = 0; pass <= CACHE_PROTECTED; pass += CACHE_PROTECTED) {
+		for (line = pdrv * CACHE_LINES; line < (pdrv + 1) * CACHE_LINES; line++) {
+			if ((cache_lines[line].flags & CACHE_PROTECTED) == pass) {
+				status = cache_clean(line);
+				if (status != RES_OK) {
+					return status;
+				}
+			}
+		}
+	}
+#endif
+	return RES_OK;
+}
+
+void disk_cache_invalidate (
+	BYTE pdrv		/* Physical drive nmuber (0..) */
+)
+{
+#if FATFS_CACHE_ENABLED == 1
+	int line;
+	if (pdrv >= DRIVES) {
+		return;
+	}
+	for (line = pdrv * CACHE_LINES; line < (pdrv + 1) * CACHE_LINES; line++) {
+		cache_lines[line].flags = 0;
+	}
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+	BYTE pdrv,		/* Physical drive nmuber (0..) */
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Sector address (LBA) */
+	UINT count		/* Number of sectors to read (1..128) */
+)
+{
+#if FATFS_CACHE_ENABLED == 1
+	DRESULT status;
+	if (pdrv >= DRIVES) {
+		return media_read(pdrv, buff, sector, count);
+	}
+	if (count == 1) {
+		return cache_read(pdrv, buff, sector);
+	}
+	status = media_read(pdrv, buff, sector, count);
+	if (status == RES_OK) {
+		cache_bypass(pdrv, buff, sector, count, 0);
+	}
+	return status;
+#else
+	return media_read(pdrv, buff, sector, count);
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_WRITE
+DRESULT disk_write (
+	BYTE pdrv,			/* Physical drive nmuber (0..) */
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Sector address (LBA) */
+	UINT count			/* Number of sectors to write (1..128) */
+)
+{
+#if FATFS_CACHE_ENABLED == 1
+	DRESULT status;
+	if (pdrv >= DRIVES) {
+		return media_write(pdrv, buff, sector, count);
+	}
+	if (count == 1) {
+		return cache_write(pdrv, buff, sector);
+	}
+	status = media_write(pdrv, buff, sector, count);
+	if (status == RES_OK) {
+		cache_bypass(pdrv, (BYTE *)buff, sector, count, 1);
+	}
+	return status;
+#else
+	return media_write(pdrv, buff, sector, count);
+#endif
+}
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_IOCTL
+DRESULT disk_ioctl (
+	BYTE pdrv,		/* Physical drive nmuber (0..) */
+	BYTE cmd,		/* Control code */
+	void *buff		/* Buffer to send/receive control data */
+)
+{
+	DRESULT status;
+	if (cmd == CTRL_SYNC) {
+		status = disk_cache_flush(pdrv);
+		if (status == RES_OK) {
+			status = worker_drain(pdrv);		/* Barrier, all queued writes are on drive */
+		}
+		if (status != RES_OK) {
+			return status;
+		}
+	}
+	media_lock(pdrv);
+	status = drive_ioctl(pdrv, cmd, buff);
+	media_unlock(pdrv);
+	return status;
+}
+#endif
+
 __weak DWORD get_fattime(void) {
 	/* Returns current time packed into a DWORD variable */
 	return	  ((DWORD)(2013 - 1980) << 25)	/* Year 2013 */
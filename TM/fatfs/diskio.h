@@ -28,6 +28,54 @@ typedef enum {
 //#define FATFS_DEBUG_SEND_USART(x)	TM_USART_Puts(USART6, x); TM_USART_Puts(USART6, "\n");
 #define FATFS_DEBUG_SEND_USART(x)
 
+/* Sector cache between FatFs and drivers, override in defines.h */
+/* FATFS_CACHE_SETS x FATFS_CACHE_WAYS sectors of _MAX_SS bytes, shared by all drives */
+#ifndef FATFS_CACHE_ENABLED
+#define FATFS_CACHE_ENABLED		1
+#endif
+#ifndef FATFS_CACHE_SETS
+#define FATFS_CACHE_SETS		4	/* Power of 2, set is sector % FATFS_CACHE_SETS */
+#endif
+#ifndef FATFS_CACHE_WAYS
+#define FATFS_CACHE_WAYS		4	/* Sectors in one set */
+#endif
+
+/* Read-ahead and write-behind task between cache and drives, needs FreeRTOS */
+#ifndef FATFS_WORKER_ENABLED
+#define FATFS_WORKER_ENABLED	0
+#endif
+#ifndef FATFS_WORKER_AHEAD
+#define FATFS_WORKER_AHEAD		8	/* Sectors read ahead, two buffers */
+#endif
+#ifndef FATFS_WORKER_WRITES
+#define FATFS_WORKER_WRITES		8	/* Sectors waiting to be written */
+#endif
+#ifndef FATFS_WORKER_STACK
+#define FATFS_WORKER_STACK		192
+#endif
+#ifndef FATFS_WORKER_PRIORITY
+#define FATFS_WORKER_PRIORITY	2	/* Above tasks using files */
+#endif
+#ifndef FATFS_WORKER_WAIT
+#define FATFS_WORKER_WAIT		(100 / portTICK_PERIOD_MS)	/* Task waiting for worker checks queue again */
+#endif
+
+/* Cache and drive counters, in sectors unless noted */
+typedef struct {
+	DWORD hits;			/* Single sector read or write found in cache */
+	DWORD misses;		/* Single sector read or write not found in cache */
+	DWORD writebacks;	/* Dirty sectors written to drive */
+	DWORD bypass;		/* Sectors of multi sector requests, they are not cached */
+	DWORD ahead;		/* Sectors read from read-ahead buffers */
+	DWORD behind;		/* Sectors queued for write-behind */
+	DWORD reads;		/* Read commands sent to drivers */
+	DWORD read_sectors;	/* Sectors read by drivers */
+	DWORD writes;		/* Write commands sent to drivers */
+	DWORD write_sectors;	/* Sectors written by drivers */
+} DCACHE_STATS;
+
+extern DCACHE_STATS disk_cache_stats;
+
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
 
@@ -36,6 +84,8 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+DRESULT disk_cache_flush (BYTE pdrv);		/* Write dirty sectors of drive, also done by CTRL_SYNC */
+void disk_cache_invalidate (BYTE pdrv);	/* Drop all sectors of drive, dirty ones are lost */
 
 /* Disk Status Bits (DSTATUS) */
 
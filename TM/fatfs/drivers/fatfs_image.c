@@ -0,0 +1,135 @@
+#include "fatfs_image.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+static int IMAGE_File = -1;
+static DWORD IMAGE_Sectors = 0;
+static volatile DSTATUS IMAGE_Stat = STA_NOINIT;	/* Disk status */
+
+int TM_FATFS_IMAGE_Attach(const char* path, DWORD sectors) {
+	struct stat info;
+
+	TM_FATFS_IMAGE_Detach();
+	IMAGE_File = open(path, O_RDWR | O_CREAT, 0644);
+	if (IMAGE_File < 0) {
+		return -1;
+	}
+	if (sectors && ftruncate(IMAGE_File, (off_t)sectors * 512) != 0) {
+		TM_FATFS_IMAGE_Detach();
+		return -1;
+	}
+	if (fstat(IMAGE_File, &info) != 0) {
+		TM_FATFS_IMAGE_Detach();
+		return -1;
+	}
+	IMAGE_Sectors = (DWORD)(info.st_size / 512);
+	return 0;
+}
+
+void TM_FATFS_IMAGE_Detach(void) {
+	if (IMAGE_File >= 0) {
+		close(IMAGE_File);
+	}
+	IMAGE_File = -1;
+	IMAGE_Sectors = 0;
+	IMAGE_Stat = STA_NOINIT;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Initialize image                                                      */
+/*-----------------------------------------------------------------------*/
+DSTATUS TM_FATFS_IMAGE_disk_initialize(void) {
+	if (IMAGE_File >= 0) {
+		IMAGE_Stat &= ~STA_NOINIT;
+	} else {
+		IMAGE_Stat = STA_NOINIT | STA_NODISK;
+	}
+
+	return IMAGE_Stat;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+DSTATUS TM_FATFS_IMAGE_disk_status(void) {
+	return IMAGE_Stat;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+DRESULT TM_FATFS_IMAGE_disk_read (
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Sector address (LBA) */
+	UINT count		/* Number of sectors to read (1..128) */
+)
+{
+	if (!count || sector >= IMAGE_Sectors || count > IMAGE_Sectors - sector) {
+		return RES_PARERR;
+	}
+	if (IMAGE_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+	if (pread(IMAGE_File, buff, (size_t)count * 512, (off_t)sector * 512) != (ssize_t)count * 512) {
+		return RES_ERROR;
+	}
+
+	return RES_OK;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+#if _USE_WRITE
+DRESULT TM_FATFS_IMAGE_disk_write (
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Sector address (LBA) */
+	UINT count			/* Number of sectors to write (1..128) */
+)
+{
+	if (!count || sector >= IMAGE_Sectors || count > IMAGE_Sectors - sector) {
+		return RES_PARERR;
+	}
+	if (IMAGE_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+	if (pwrite(IMAGE_File, buff, (size_t)count * 512, (off_t)sector * 512) != (ssize_t)count * 512) {
+		return RES_ERROR;
+	}
+
+	return RES_OK;
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+#if _USE_IOCTL
+DRESULT TM_FATFS_IMAGE_disk_ioctl (
+	BYTE cmd,		/* Control code */
+	void *buff		/* Buffer to send/receive control data */
+)
+{
+	if (IMAGE_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	switch (cmd) {
+		case CTRL_SYNC:
+			return fsync(IMAGE_File) == 0 ? RES_OK : RES_ERROR;
+		case GET_SECTOR_COUNT:
+			*(DWORD*)buff = IMAGE_Sectors;
+			return RES_OK;
+		case GET_SECTOR_SIZE:
+			*(WORD*)buff = 512;
+			return RES_OK;
+		case GET_BLOCK_SIZE:	/* Erase block in sectors */
+			*(DWORD*)buff = 1;
+			return RES_OK;
+		default:
+			return RES_PARERR;
+	}
+}
+#endif
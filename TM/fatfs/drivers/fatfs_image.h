@@ -0,0 +1,26 @@
+/*-----------------------------------------------------------------------/
+/  Low level disk interface modlue include file   (C)ChaN, 2013          /
+/-----------------------------------------------------------------------*/
+
+#ifndef _DISKIO_DEFINED_IMAGE
+#define _DISKIO_DEFINED_IMAGE
+
+#include "diskio.h"
+#include "integer.h"
+
+/*---------------------------------------*/
+/* Disk image file, POSIX only (host build, Tools/fatfs_bench) */
+/* Image is created or extended to sectors, 0 keeps size of existing image */
+/* Returns 0 on success, -1 if file can not be opened */
+extern int TM_FATFS_IMAGE_Attach(const char* path, DWORD sectors);
+extern void TM_FATFS_IMAGE_Detach(void);
+
+/*---------------------------------------*/
+/* Prototypes for disk control functions */
+extern DSTATUS TM_FATFS_IMAGE_disk_initialize(void);
+extern DSTATUS TM_FATFS_IMAGE_disk_status(void);
+extern DRESULT TM_FATFS_IMAGE_disk_read(BYTE* buff, DWORD sector, UINT count);
+extern DRESULT TM_FATFS_IMAGE_disk_write(const BYTE* buff, DWORD sector, UINT count);
+extern DRESULT TM_FATFS_IMAGE_disk_ioctl(BYTE cmd, void* buff);
+
+#endif
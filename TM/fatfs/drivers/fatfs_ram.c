@@ -0,0 +1,105 @@
+#include "fatfs_ram.h"
+#include <string.h>
+
+static BYTE* RAM_Memory = 0;				/* Sector 0 */
+static DWORD RAM_Sectors = 0;
+static volatile DSTATUS RAM_Stat = STA_NOINIT;	/* Disk status */
+
+void TM_FATFS_RAM_Attach(BYTE* memory, DWORD sectors) {
+	RAM_Memory = memory;
+	RAM_Sectors = sectors;
+	RAM_Stat = STA_NOINIT;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Initialize RAM disk                                                   */
+/*-----------------------------------------------------------------------*/
+DSTATUS TM_FATFS_RAM_disk_initialize(void) {
+	if (RAM_Memory) {
+		RAM_Stat &= ~STA_NOINIT;
+	} else {
+		RAM_Stat = STA_NOINIT | STA_NODISK;
+	}
+
+	return RAM_Stat;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+DSTATUS TM_FATFS_RAM_disk_status(void) {
+	return RAM_Stat;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+DRESULT TM_FATFS_RAM_disk_read (
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Sector address (LBA) */
+	UINT count		/* Number of sectors to read (1..128) */
+)
+{
+	if (!count || sector >= RAM_Sectors || count > RAM_Sectors - sector) {
+		return RES_PARERR;
+	}
+	if (RAM_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+	memcpy(buff, RAM_Memory + sector * 512, count * 512);
+
+	return RES_OK;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+#if _USE_WRITE
+DRESULT TM_FATFS_RAM_disk_write (
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Sector address (LBA) */
+	UINT count			/* Number of sectors to write (1..128) */
+)
+{
+	if (!count || sector >= RAM_Sectors || count > RAM_Sectors - sector) {
+		return RES_PARERR;
+	}
+	if (RAM_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+	memcpy(RAM_Memory + sector * 512, buff, count * 512);
+
+	return RES_OK;
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+#if _USE_IOCTL
+DRESULT TM_FATFS_RAM_disk_ioctl (
+	BYTE cmd,		/* Control code */
+	void *buff		/* Buffer to send/receive control data */
+)
+{
+	if (RAM_Stat & STA_NOINIT) {
+		return RES_NOTRDY;
+	}
+
+	switch (cmd) {
+		case CTRL_SYNC:			/* Nothing is cached */
+			return RES_OK;
+		case GET_SECTOR_COUNT:
+			*(DWORD*)buff = RAM_Sectors;
+			return RES_OK;
+		case GET_SECTOR_SIZE:
+			*(WORD*)buff = 512;
+			return RES_OK;
+		case GET_BLOCK_SIZE:	/* Erase block in sectors */
+			*(DWORD*)buff = 1;
+			return RES_OK;
+		default:
+			return RES_PARERR;
+	}
+}
+#endif
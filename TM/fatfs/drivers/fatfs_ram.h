@@ -0,0 +1,24 @@
+/*-----------------------------------------------------------------------/
+/  Low level disk interface modlue include file   (C)ChaN, 2013          /
+/-----------------------------------------------------------------------*/
+
+#ifndef _DISKIO_DEFINED_RAM
+#define _DISKIO_DEFINED_RAM
+
+#include "diskio.h"
+#include "integer.h"
+
+/*---------------------------------------*/
+/* RAM disk, memory is given by application (CCM RAM on target, malloc on host) */
+/* Content is lost on reset, f_mkfs has to be called first */
+extern void TM_FATFS_RAM_Attach(BYTE* memory, DWORD sectors);
+
+/*---------------------------------------*/
+/* Prototypes for disk control functions */
+extern DSTATUS TM_FATFS_RAM_disk_initialize(void);
+extern DSTATUS TM_FATFS_RAM_disk_status(void);
+extern DRESULT TM_FATFS_RAM_disk_read(BYTE* buff, DWORD sector, UINT count);
+extern DRESULT TM_FATFS_RAM_disk_write(const BYTE* buff, DWORD sector, UINT count);
+extern DRESULT TM_FATFS_RAM_disk_ioctl(BYTE cmd, void* buff);
+
+#endif
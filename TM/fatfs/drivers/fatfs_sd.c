@@ -31,6 +31,10 @@ static volatile DSTATUS TM_FATFS_SD_Stat = STA_NOINIT;	/* Physical drive status
 
 static BYTE TM_FATFS_SD_CardType;			/* Card type flags */
 
+#if FATFS_USE_DMA == 1
+static BYTE TM_FATFS_SD_Dummy;				/* Received bytes which are not needed, 0xFF for sending */
+#endif
+
 /* Initialize MMC interface */
 static void init_spi (void) {
 	/* Init delay functions */
@@ -42,10 +46,24 @@ static void init_spi (void) {
 	/* Set CS high */
 	FATFS_CS_HIGH;
 	
+#if FATFS_USE_DMA == 1
+	RCC_AHB1PeriphClockCmd(FATFS_DMA_CLK, ENABLE);
+#endif
+	
 	/* Wait for stable */
 	Delayms(10);
 }
 
+/* Card is initialized, data can be sent with full speed */
+static void fast_spi (void) {
+	uint16_t cr1 = FATFS_SPI->CR1;
+	
+	/* Prescaler can be changed only when SPI is disabled */
+	FATFS_SPI->CR1 = cr1 & ~SPI_CR1_SPE;
+	FATFS_SPI->CR1 = (cr1 & ~(SPI_CR1_BR | SPI_CR1_SPE)) | FATFS_SPI_FAST_PRESCALER;
+	FATFS_SPI->CR1 |= SPI_CR1_SPE;
+}
+
 
 /* Exchange a byte */
 static BYTE xchg_spi (
@@ -57,6 +75,56 @@ static BYTE xchg_spi (
 }
 
 
+#if FATFS_USE_DMA == 1
+/* Full duplex DMA transfer, NULL tx sends 0xFF, NULL rx drops received bytes */
+static void dma_spi (
+	const BYTE *tx,	/* Data to send or NULL */
+	BYTE *rx,		/* Buffer for received data or NULL */
+	UINT count		/* Number of bytes */
+)
+{
+	DMA_InitTypeDef DMA_InitStruct;
+	
+	DMA_StructInit(&DMA_InitStruct);
+	DMA_InitStruct.DMA_PeripheralBaseAddr = (uint32_t)&FATFS_SPI->DR;
+	DMA_InitStruct.DMA_BufferSize = count;
+	DMA_InitStruct.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStruct.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStruct.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStruct.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStruct.DMA_Priority = DMA_Priority_High;
+	DMA_InitStruct.DMA_FIFOMode = DMA_FIFOMode_Disable;
+	
+	/* Receive stream always runs, so RX register never overruns */
+	DMA_InitStruct.DMA_Channel = FATFS_DMA_RX_CHANNEL;
+	DMA_InitStruct.DMA_DIR = DMA_DIR_PeripheralToMemory;
+	DMA_InitStruct.DMA_Memory0BaseAddr = rx ? (uint32_t)rx : (uint32_t)&TM_FATFS_SD_Dummy;
+	DMA_InitStruct.DMA_MemoryInc = rx ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+	DMA_Init(FATFS_DMA_RX_STREAM, &DMA_InitStruct);
+	
+	TM_FATFS_SD_Dummy = 0xFF;
+	DMA_InitStruct.DMA_Channel = FATFS_DMA_TX_CHANNEL;
+	DMA_InitStruct.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+	DMA_InitStruct.DMA_Memory0BaseAddr = tx ? (uint32_t)tx : (uint32_t)&TM_FATFS_SD_Dummy;
+	DMA_InitStruct.DMA_MemoryInc = tx ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+	DMA_Init(FATFS_DMA_TX_STREAM, &DMA_InitStruct);
+	
+	DMA_ClearFlag(FATFS_DMA_RX_STREAM, FATFS_DMA_RX_FLAGS);
+	DMA_ClearFlag(FATFS_DMA_TX_STREAM, FATFS_DMA_TX_FLAGS);
+	DMA_Cmd(FATFS_DMA_RX_STREAM, ENABLE);
+	DMA_Cmd(FATFS_DMA_TX_STREAM, ENABLE);
+	SPI_I2S_DMACmd(FATFS_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+	
+	/* Last received byte means last byte was sent too */
+	while (DMA_GetFlagStatus(FATFS_DMA_RX_STREAM, FATFS_DMA_RX_FLAG_TC) == RESET);
+	
+	SPI_I2S_DMACmd(FATFS_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+	DMA_Cmd(FATFS_DMA_RX_STREAM, DISABLE);
+	DMA_Cmd(FATFS_DMA_TX_STREAM, DISABLE);
+}
+#endif
+
+
 /* Receive multiple byte */
 static void rcvr_spi_multi (
 	BYTE *buff,		/* Pointer to data buffer */
@@ -65,6 +133,12 @@ static void rcvr_spi_multi (
 {
 	FATFS_DEBUG_SEND_USART("rcvr_spi_multi: inside");
 	
+#if FATFS_USE_DMA == 1
+	if (btr >= FATFS_DMA_MIN) {
+		dma_spi(0, buff, btr);
+		return;
+	}
+#endif
 	TM_SPI_ReadMulti(FATFS_SPI, buff, 0xFF, btr);
 	
 	FATFS_DEBUG_SEND_USART("rcvr_spi_multi: done"); 
@@ -80,6 +154,12 @@ static void xmit_spi_multi (
 {
 	FATFS_DEBUG_SEND_USART("xmit_spi_multi: inside");
 	
+#if FATFS_USE_DMA == 1
+	if (btx >= FATFS_DMA_MIN) {
+		dma_spi(buff, 0, btx);
+		return;
+	}
+#endif
 	TM_SPI_WriteMulti(FATFS_SPI, (uint8_t *)buff, btx);
 }
 #endif
@@ -182,17 +262,21 @@ static int rcvr_datablock (	/* 1:OK, 0:Error */
 #if _USE_WRITE
 static int xmit_datablock (	/* 1:OK, 0:Failed */
 	const BYTE *buff,	/* Ponter to 512 byte data to be sent */
-	BYTE token			/* Token */
+	BYTE token,			/* Token */
+	BYTE wait			/* 1: wait until card finished previous block, 0: card is known to be ready */
 )
 {
 	BYTE resp;
 	
 	FATFS_DEBUG_SEND_USART("xmit_datablock: inside");
 
-	if (!wait_ready(500)) {
+	if (wait && !wait_ready(500)) {
 		FATFS_DEBUG_SEND_USART("xmit_datablock: not ready");
 		return 0;		/* Wait for card ready */
 	}
+	if (!wait) {
+		xchg_spi(0xFF);					/* Nwr, at least one byte between command response and token */
+	}
 	FATFS_DEBUG_SEND_USART("xmit_datablock: ready");
 
 	xchg_spi(token);					/* Send token */
@@ -339,6 +423,10 @@ DSTATUS TM_FATFS_SD_disk_initialize (void) {
 	TM_FATFS_SD_CardType = ty;	/* Card type */
 	FATFS_DEBUG_SEND_USART("disk_initialize: deselecting");
 	deselect();
+	
+	if (ty) {
+		fast_spi();
+	}
 
 	if (ty) {			/* OK */
 		TM_FATFS_SD_Stat &= ~STA_NOINIT;	/* Clear STA_NOINIT flag */
@@ -432,6 +520,8 @@ DRESULT TM_FATFS_SD_disk_write (
 	UINT count			/* Number of sectors to write (1..128) */
 )
 {
+	BYTE wait;
+	
 	FATFS_DEBUG_SEND_USART("disk_write: inside");
 	if (!TM_FATFS_Detect()) {
 		return RES_ERROR;
@@ -451,20 +541,24 @@ DRESULT TM_FATFS_SD_disk_write (
 		sector *= 512;	/* LBA ==> BA conversion (byte addressing cards) */
 	}
 
+	/* send_cmd waits until card is ready, so first block is sent without busy polling (only Nwr byte).
+	   Card is busy while it programs a block, next one can be sent only after that. */
 	if (count == 1) {	/* Single sector write */
 		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
-			&& xmit_datablock(buff, 0xFE))
+			&& xmit_datablock(buff, 0xFE, 0))
 			count = 0;
 	} else {				/* Multiple sector write */
-		if (TM_FATFS_SD_CardType & CT_SDC) send_cmd(ACMD23, count);	/* Predefine number of sectors */
+		if (TM_FATFS_SD_CardType & CT_SDC) send_cmd(ACMD23, count);	/* Pre-erase sectors, card can program them faster */
 		if (send_cmd(CMD25, sector) == 0) {	/* WRITE_MULTIPLE_BLOCK */
+			wait = 0;
 			do {
-				if (!xmit_datablock(buff, 0xFC)) {
+				if (!xmit_datablock(buff, 0xFC, wait)) {
 					break;
 				}
 				buff += 512;
+				wait = 1;
 			} while (--count);
-			if (!xmit_datablock(0, 0xFD)) {	/* STOP_TRAN token */
+			if (!xmit_datablock(0, 0xFD, 1)) {	/* STOP_TRAN token */
 				count = 1;
 			}
 		}
@@ -32,6 +32,34 @@
 #define FATFS_CS_PIN						GPIO_PIN_6
 #endif
 
+/* SPI clock after card is initialized, card initialization uses TM_SPIx_PRESCALER (SD cards support up to 25MHz) */
+#ifndef FATFS_SPI_FAST_PRESCALER
+#define FATFS_SPI_FAST_PRESCALER			SPI_BaudRatePrescaler_4
+#endif
+
+/* DMA for data blocks, set streams and channels of FATFS_SPI RX and TX in defines.h file
+ *
+ *	#define FATFS_USE_DMA						1
+ *	#define FATFS_DMA_CLK						RCC_AHB1Periph_DMA2
+ *	#define FATFS_DMA_RX_STREAM					DMA2_Stream0
+ *	#define FATFS_DMA_RX_CHANNEL				DMA_Channel_4
+ *	#define FATFS_DMA_RX_FLAG_TC				DMA_FLAG_TCIF0
+ *	#define FATFS_DMA_RX_FLAGS					(DMA_FLAG_TCIF0 | DMA_FLAG_HTIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0)
+ *	#define FATFS_DMA_TX_STREAM					DMA2_Stream1
+ *	#define FATFS_DMA_TX_CHANNEL				DMA_Channel_4
+ *	#define FATFS_DMA_TX_FLAGS					(DMA_FLAG_TCIF1 | DMA_FLAG_HTIF1 | DMA_FLAG_TEIF1 | DMA_FLAG_DMEIF1 | DMA_FLAG_FEIF1)
+ *
+ * Buffers passed to FatFs must not be in CCM RAM (0x10000000), DMA can not access it.
+ */
+#ifndef FATFS_USE_DMA
+#define FATFS_USE_DMA						0
+#endif
+
+/* Shorter transfers are sent by CPU, DMA setup would take longer */
+#ifndef FATFS_DMA_MIN
+#define FATFS_DMA_MIN						32
+#endif
+
 #ifndef FATFS_USE_DETECT_PIN
 #define FATFS_USE_DETECT_PIN				0
 #endif
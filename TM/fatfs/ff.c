@@ -409,6 +409,10 @@ static BYTE CurrVol;			/* Current drive */
 
 #if _FS_LOCK
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
+#ifndef _FS_LOCK_ENTER			/* Files[] is shared by all volumes, entries are taken under it */
+#define _FS_LOCK_ENTER()
+#define _FS_LOCK_EXIT()
+#endif
 #endif
 
 #if _USE_LFN == 0			/* Non LFN feature */
@@ -585,6 +589,7 @@ UINT inc_lock (	/* Increment object open counter and returns its index (0:Intern
 	UINT i;
 
 
+	_FS_LOCK_ENTER();
 	for (i = 0; i < _FS_LOCK; i++) {	/* Find the object */
 		if (Files[i].fs == dp->fs &&
 			Files[i].clu == dp->sclust &&
@@ -593,16 +598,23 @@ UINT inc_lock (	/* Increment object open counter and returns its index (0:Intern
 
 	if (i == _FS_LOCK) {				/* Not opened. Register it as new. */
 		for (i = 0; i < _FS_LOCK && Files[i].fs; i++) ;
-		if (i == _FS_LOCK) return 0;	/* No free entry to register (int err) */
+		if (i == _FS_LOCK) {			/* No free entry to register (int err) */
+			_FS_LOCK_EXIT();
+			return 0;
+		}
 		Files[i].fs = dp->fs;
 		Files[i].clu = dp->sclust;
 		Files[i].idx = dp->index;
 		Files[i].ctr = 0;
 	}
 
-	if (acc && Files[i].ctr) return 0;	/* Access violation (int err) */
+	if (acc && Files[i].ctr) {			/* Access violation (int err) */
+		_FS_LOCK_EXIT();
+		return 0;
+	}
 
 	Files[i].ctr = acc ? 0x100 : Files[i].ctr + 1;	/* Set semaphore value */
+	_FS_LOCK_EXIT();
 
 	return i + 1;
 }
@@ -618,11 +630,13 @@ FRESULT dec_lock (	/* Decrement object open counter */
 
 
 	if (--i < _FS_LOCK) {	/* Shift index number origin from 0 */
+		_FS_LOCK_ENTER();
 		n = Files[i].ctr;
 		if (n == 0x100) n = 0;		/* If write mode open, delete the entry */
 		if (n) n--;					/* Decrement read mode open count */
 		Files[i].ctr = n;
 		if (!n) Files[i].fs = 0;	/* Delete the entry if open count gets zero */
+		_FS_LOCK_EXIT();
 		res = FR_OK;
 	} else {
 		res = FR_INT_ERR;			/* Invalid index nunber */
@@ -638,9 +652,11 @@ void clear_lock (	/* Clear lock entries of the volume */
 {
 	UINT i;
 
+	_FS_LOCK_ENTER();
 	for (i = 0; i < _FS_LOCK; i++) {
 		if (Files[i].fs == fs) Files[i].fs = 0;
 	}
+	_FS_LOCK_EXIT();
 }
 #endif
 
@@ -1407,17 +1423,19 @@ BYTE sum_sfn (
 /*-----------------------------------------------------------------------*/
 
 static
-FRESULT dir_find (
-	DIR* dp			/* Pointer to the directory object linked to the file name */
+FRESULT dir_scan (
+	DIR* dp,		/* Pointer to the directory object linked to the file name */
+	UINT idx,		/* Index to start at */
+	int one			/* 0:Scan to end of table, 1:Check only the object at idx */
 )
 {
 	FRESULT res;
 	BYTE c, *dir;
 #if _USE_LFN
-	BYTE a, ord, sum;
+	BYTE a, ord, sum, seq = 0, seqsum = 0;
 #endif
 
-	res = dir_sdi(dp, 0);			/* Rewind directory object */
+	res = dir_sdi(dp, idx);			/* Rewind directory object */
 	if (res != FR_OK) return res;
 
 #if _USE_LFN
@@ -1433,8 +1451,15 @@ FRESULT dir_find (
 		a = dir[DIR_Attr] & AM_MASK;
 		if (c == DDEM || ((a & AM_VOL) && a != AM_LFN)) {	/* An entry without valid data */
 			ord = 0xFF; dp->lfn_idx = 0xFFFF;	/* Reset LFN sequence */
+			if (one) { res = FR_NO_FILE; break; }	/* The object is gone */
 		} else {
 			if (a == AM_LFN) {			/* An LFN entry is found */
+				if (one) {				/* The object starts with LFN start and has one LFN sequence (stale index slot) */
+					if ((c & LLEF) ? dp->index != idx : (dp->index == idx || c != seq || dir[LDIR_Chksum] != seqsum)) {
+						res = FR_NO_FILE; break;
+					}
+					seq = (BYTE)((c & ~LLEF) - 1); seqsum = dir[LDIR_Chksum];
+				}
 				if (dp->lfn) {
 					if (c & LLEF) {		/* Is it start of LFN sequence? */
 						sum = dir[LDIR_Chksum];
@@ -1445,14 +1470,17 @@ FRESULT dir_find (
 					ord = (c == ord && sum == dir[LDIR_Chksum] && cmp_lfn(dp->lfn, dir)) ? ord - 1 : 0xFF;
 				}
 			} else {					/* An SFN entry is found */
+				if (one && dp->index != idx && (seq || seqsum != sum_sfn(dir))) { res = FR_NO_FILE; break; }	/* LFN sequence is broken */
 				if (!ord && sum == sum_sfn(dir)) break;	/* LFN matched? */
 				if (!(dp->fn[NSFLAG] & NS_LOSS) && !mem_cmp(dir, dp->fn, 11)) break;	/* SFN matched? */
 				ord = 0xFF; dp->lfn_idx = 0xFFFF;	/* Reset LFN sequence */
+				if (one) { res = FR_NO_FILE; break; }	/* The object has other name */
 			}
 		}
 #else		/* Non LFN configuration */
 		if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dp->fn, 11)) /* Is it a valid entry? */
 			break;
+		if (one) { res = FR_NO_FILE; break; }
 #endif
 		res = dir_next(dp, 0);		/* Next entry */
 	} while (res == FR_OK);
@@ -1463,6 +1491,406 @@ FRESULT dir_find (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Name hash index of the directory                 */
+/*-----------------------------------------------------------------------*/
+#if _USE_DIRINDEX
+#if _DIRINDEX_DIRS < 1 || _DIRINDEX_MAX < 64 || _DIRINDEX_MAX > 0x4000 || (_DIRINDEX_MAX & (_DIRINDEX_MAX - 1))
+#error Wrong _DIRINDEX_DIRS or _DIRINDEX_MAX setting
+#endif
+
+#define DIX_EMPTY	0xFFFF	/* Entry index of an empty slot */
+#define DIX_FULL	0xFFFF	/* Slot count of a directory with too many names */
+#define DIX_MIN		64		/* Slots of the smallest table */
+#define DIX_LIMIT(n)	((n) / 4 * 3)	/* Slots which can be used in a table of n slots */
+#define DIX_HASH(h)	((WORD)((h) ^ (h) >> 16))
+#define DIX_UPPER(c)	((c) < 0x80 ? (WCHAR)(IsLower(c) ? (c) - 0x20 : (c)) : ff_wtoupper(c))	/* ff_wtoupper() searches a table */
+
+/* Hash of a name is a sum of its characters mixed with their positions,
+/  so an LFN can be hashed entry by entry in any order. */
+static
+DWORD dix_mix (
+	UINT pos,		/* Character position in the name */
+	WCHAR chr		/* Up-cased character */
+)
+{
+	DWORD x;
+
+	x = (DWORD)(((DWORD)pos << 16 | chr) * 0x9E3779B1UL);
+	return x ^ x >> 15;
+}
+
+
+static
+WORD dix_sfn (		/* Hash of the SFN */
+	const BYTE* sfn	/* SFN in directory entry format */
+)
+{
+	UINT i;
+	DWORD h = 0;
+
+	for (i = 0; i < 11; i++) h += dix_mix(i, sfn[i]);
+	return DIX_HASH(h);
+}
+
+
+#if _USE_LFN
+static
+DWORD dix_lfn (		/* Hash sum of the LFN, not folded */
+	const WCHAR* lfn
+)
+{
+	UINT i;
+	DWORD h = 0;
+
+	for (i = 0; lfn[i]; i++) h += dix_mix(i, DIX_UPPER(lfn[i]));
+	return h;
+}
+
+
+static
+DWORD dix_lfn_part (	/* Hash sum of characters in an LFN entry */
+	BYTE* dir
+)
+{
+	UINT i, s;
+	WCHAR wc;
+	DWORD h = 0;
+
+	i = ((dir[LDIR_Ord] & ~LLEF) - 1) * 13;
+	for (s = 0; s < 13; s++) {
+		wc = LD_WORD(dir + LfnOfs[s]);
+		if (!wc) break;					/* Terminator, fillers follow */
+		h += dix_mix(i + s, DIX_UPPER(wc));
+	}
+	return h;
+}
+#endif
+
+
+static
+void dix_free (		/* Drop the table, the directory is not indexed */
+	DIRINDEX* dix
+)
+{
+	if (dix->slot) ff_memfree(dix->slot);
+	dix->slot = 0;
+	dix->size = 0;
+	dix->sclust = 1;
+}
+
+
+static
+void dix_insert (
+	DIRINDEX* dix,	/* Index of the directory */
+	WORD hash,		/* Name hash */
+	UINT idx		/* Index of first entry of the object */
+)
+{
+	UINT i;
+
+	if (dix->count == DIX_FULL) {	/* Too many names, count slots over the limit */
+		if (dix->stale < 0xFFFF) dix->stale++;
+		return;
+	}
+	if (!dix->slot) {				/* Counting slots before the table is made */
+		if (dix->count < DIX_FULL - 1) dix->count++;
+		return;
+	}
+	if (idx >= DIX_EMPTY) {			/* Entry index does not fit in the slot, try again after a removal */
+		dix_free(dix);				/* Caller sets the directory */
+		dix->count = DIX_FULL;
+		dix->stale = 1;
+		return;
+	}
+	if (dix->count >= DIX_LIMIT(dix->size)) {	/* Table is full, a bigger one is built on next search */
+		dix_free(dix);
+		return;
+	}
+	for (i = hash & (dix->size - 1); (WORD)dix->slot[i] != DIX_EMPTY; i = (i + 1) & (dix->size - 1)) ;
+	dix->slot[i] = (DWORD)hash << 16 | idx;
+	dix->count++;
+}
+
+
+static
+DIRINDEX* dix_get (	/* Index of the directory, 0:Not indexed */
+	FATFS* fs,
+	DWORD sclust	/* Directory start cluster */
+)
+{
+	UINT i;
+
+	for (i = 0; i < _DIRINDEX_DIRS; i++) {
+		if (fs->dix[i].sclust == sclust) return &fs->dix[i];
+	}
+	return 0;
+}
+
+
+static
+void dix_init (		/* Set up indexes of a new file system object */
+	FATFS* fs
+)
+{
+	UINT i;
+
+	for (i = 0; i < _DIRINDEX_DIRS; i++) {
+		fs->dix[i].slot = 0;
+		fs->dix[i].size = 0;
+		fs->dix[i].sclust = 1;
+		fs->dix[i].stamp = 0;
+	}
+	fs->dixclock = 0;
+}
+
+
+static
+void dix_clear (	/* Drop all indexes of the volume */
+	FATFS* fs
+)
+{
+	UINT i;
+
+	for (i = 0; i < _DIRINDEX_DIRS; i++) dix_free(&fs->dix[i]);
+	dix_init(fs);
+}
+
+
+static
+FRESULT dix_scan (	/* Put all names of the directory into the index (or count them without table) */
+	DIR* dp,
+	DIRINDEX* dix
+)
+{
+	FRESULT res;
+	UINT start = 0;
+	BYTE c, a, *dir;
+#if _USE_LFN
+	BYTE ord = 0xFF, sum = 0xFF;
+	DWORD h = 0;
+#endif
+
+	res = dir_sdi(dp, 0);
+	while (res == FR_OK && dix->count != DIX_FULL) {
+		res = move_window(dp->fs, dp->sect);
+		if (res != FR_OK) break;
+		dir = dp->dir;
+		c = dir[DIR_Name];
+		if (c == 0) break;				/* End of table */
+		a = dir[DIR_Attr] & AM_MASK;
+#if _USE_LFN
+		if (c == DDEM || ((a & AM_VOL) && a != AM_LFN)) {	/* Same rules as dir_scan() */
+			ord = 0xFF;
+		} else if (a == AM_LFN) {
+			if (c & LLEF) {
+				sum = dir[LDIR_Chksum];
+				c &= ~LLEF; ord = c;
+				start = dp->index; h = 0;
+			}
+			if (c == ord && sum == dir[LDIR_Chksum]) {
+				h += dix_lfn_part(dir);
+				ord--;
+			} else {
+				ord = 0xFF;
+			}
+		} else {
+			if (!ord && sum == sum_sfn(dir)) {
+				dix_insert(dix, DIX_HASH(h), start);	/* Found by LFN */
+			} else {
+				start = dp->index;
+			}
+			dix_insert(dix, dix_sfn(dir), start);		/* Found by SFN */
+			ord = 0xFF;
+		}
+#else
+		if (c != DDEM && !(a & AM_VOL)) dix_insert(dix, dix_sfn(dir), dp->index);
+#endif
+		res = dir_next(dp, 0);
+	}
+	if (res == FR_NO_FILE) res = FR_OK;
+	(void)start;
+
+	return res;
+}
+
+
+static
+FRESULT dix_build (	/* Make the table for names of the directory, sized by their count */
+	DIR* dp,
+	DIRINDEX* dix
+)
+{
+	FRESULT res;
+	UINT i, n, size;
+
+
+	dix_free(dix);
+	dix->count = 0;
+	dix->stale = 0;
+	res = dix_scan(dp, dix);		/* Count slots */
+	if (res != FR_OK) return res;
+	dix->sclust = dp->sclust;
+	if (dix->count == DIX_FULL) return FR_OK;
+	n = dix->count;
+	if (n > DIX_LIMIT(_DIRINDEX_MAX)) {	/* Too many names, build it again when removals bring them under the limit */
+		dix->count = DIX_FULL;
+		dix->stale = (WORD)(n - DIX_LIMIT(_DIRINDEX_MAX));
+		return FR_OK;
+	}
+	for (size = DIX_MIN; size < _DIRINDEX_MAX && DIX_LIMIT(size) < n + n / 4 + 8; size <<= 1) ;	/* Room for new names */
+	dix->slot = ff_memalloc(size * sizeof (DWORD));
+	if (!dix->slot) {				/* No memory, try again after a removal */
+		dix->count = DIX_FULL;
+		dix->stale = 1;
+		return FR_OK;
+	}
+	dix->size = (WORD)size;
+	for (i = 0; i < size; i++) dix->slot[i] = DIX_EMPTY;
+	dix->count = 0;
+	res = dix_scan(dp, dix);
+	if (res != FR_OK) dix_free(dix);
+	dix->sclust = (res == FR_OK) ? dp->sclust : 1;
+
+	return res;
+}
+
+
+static
+FRESULT dix_open (	/* Get index of the directory, build it if the directory is not indexed */
+	DIR* dp,
+	DIRINDEX** pdix	/* Index or 0 if the directory has too many names */
+)
+{
+	FRESULT res;
+	FATFS *fs = dp->fs;
+	DIRINDEX *dix;
+	UINT i;
+
+	dix = dix_get(fs, dp->sclust);
+	if (!dix) {						/* Replace the least recently used index */
+		dix = &fs->dix[0];
+		for (i = 1; i < _DIRINDEX_DIRS; i++) {
+			if ((WORD)(fs->dixclock - fs->dix[i].stamp) > (WORD)(fs->dixclock - dix->stamp))
+				dix = &fs->dix[i];
+		}
+		res = dix_build(dp, dix);
+		if (res != FR_OK) return res;
+	}
+	dix->stamp = ++fs->dixclock;
+	*pdix = (dix->count == DIX_FULL || !dix->slot) ? 0 : dix;
+
+	return FR_OK;
+}
+
+
+static
+FRESULT dix_find (	/* Check objects in the slots with hash of the name */
+	DIR* dp,
+	DIRINDEX* dix,
+	WORD hash
+)
+{
+	FRESULT res;
+	UINT i;
+	DWORD slot;
+
+	for (i = hash & (dix->size - 1); ; i = (i + 1) & (dix->size - 1)) {
+		slot = dix->slot[i];
+		if ((WORD)slot == DIX_EMPTY) return FR_NO_FILE;
+		if ((WORD)(slot >> 16) == hash) {
+			res = dir_scan(dp, (WORD)slot, 1);
+			if (res != FR_NO_FILE) return res;
+		}
+	}
+}
+
+
+#if !_FS_READONLY
+static
+void dix_register (	/* Add new object to index of the directory */
+	DIR* dp,
+	UINT idx		/* Index of first entry of the object */
+)
+{
+	DIRINDEX *dix;
+
+	dix = dix_get(dp->fs, dp->sclust);
+	if (!dix || (!dix->slot && dix->count != DIX_FULL)) return;
+#if _USE_LFN
+	if (dp->fn[NSFLAG] & NS_LFN) dix_insert(dix, DIX_HASH(dix_lfn(dp->lfn)), idx);
+#endif
+	dix_insert(dix, dix_sfn(dp->fn), idx);
+	if (dix->count == DIX_FULL) dix->sclust = dp->sclust;	/* Entry index was too big for the slot */
+}
+#endif
+
+
+#if !_FS_READONLY && !_FS_MINIMIZE
+static
+FRESULT dix_remove (	/* Object pointed by the directory object is going to be removed */
+	DIR* dp
+)
+{
+	FRESULT res;
+	DIRINDEX *dix;
+	UINT n = 1;
+
+
+	res = move_window(dp->fs, dp->sect);
+	if (res != FR_OK) return res;
+	dix = dix_get(dp->fs, dp->sclust);
+	if (dix) {
+		if (dix->count != DIX_FULL) {
+			dix->stale++;			/* Its slots stay, they do not match on check */
+		} else {					/* Too many names, build it again when they fit */
+#if _USE_LFN
+			if (dp->lfn_idx != 0xFFFF) n = 2;
+#endif
+			if (dix->stale <= n) dix->sclust = 1;
+			else dix->stale -= (WORD)n;
+		}
+	}
+	if (dp->dir[DIR_Attr] & AM_DIR) {	/* Cluster of removed directory can be used by new one */
+		dix = dix_get(dp->fs, ld_clust(dp->fs, dp->dir));
+		if (dix) dix_free(dix);
+	}
+
+	return FR_OK;
+}
+#endif
+#endif	/* _USE_DIRINDEX */
+
+
+static
+FRESULT dir_find (
+	DIR* dp			/* Pointer to the directory object linked to the file name */
+)
+{
+#if _USE_DIRINDEX
+	FRESULT res;
+	DIRINDEX *dix;
+
+
+	res = dix_open(dp, &dix);
+	if (res != FR_OK) return res;
+	if (dix) {
+#if _USE_LFN
+		if (dp->lfn) {
+			res = dix_find(dp, dix, DIX_HASH(dix_lfn(dp->lfn)));
+			if (res != FR_NO_FILE) return res;
+		}
+		if (dp->fn[NSFLAG] & NS_LOSS) return FR_NO_FILE;	/* Not found by LFN and has no SFN */
+#endif
+		return dix_find(dp, dix, dix_sfn(dp->fn));
+	}
+#endif
+	return dir_scan(dp, 0, 0);
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Read an object from the directory                                     */
 /*-----------------------------------------------------------------------*/
@@ -1532,6 +1960,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 )
 {
 	FRESULT res;
+#if _USE_DIRINDEX
+	UINT start;
+#endif
 #if _USE_LFN	/* LFN configuration */
 	UINT n, nent;
 	BYTE sn[12], *fn, sum;
@@ -1563,6 +1994,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 		nent = 1;
 	}
 	res = dir_alloc(dp, nent);		/* Allocate entries */
+#if _USE_DIRINDEX
+	start = dp->index - (nent - 1);	/* First entry of the object */
+#endif
 
 	if (res == FR_OK && --nent) {	/* Set LFN entry if needed */
 		res = dir_sdi(dp, dp->index - nent);
@@ -1579,6 +2013,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 	}
 #else	/* Non LFN configuration */
 	res = dir_alloc(dp, 1);		/* Allocate an entry for SFN */
+#if _USE_DIRINDEX
+	start = dp->index;
+#endif
 #endif
 
 	if (res == FR_OK) {				/* Set SFN entry */
@@ -1590,6 +2027,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 			dp->dir[DIR_NTres] = dp->fn[NSFLAG] & (NS_BODY | NS_EXT);	/* Put NT flag */
 #endif
 			dp->fs->wflag = 1;
+#if _USE_DIRINDEX
+			dix_register(dp, start);
+#endif
 		}
 	}
 
@@ -1610,9 +2050,15 @@ FRESULT dir_remove (	/* FR_OK: Successful, FR_DISK_ERR: A disk error */
 )
 {
 	FRESULT res;
-#if _USE_LFN	/* LFN configuration */
+#if _USE_LFN
 	UINT i;
+#endif
 
+#if _USE_DIRINDEX
+	res = dix_remove(dp);
+	if (res != FR_OK) return res;
+#endif
+#if _USE_LFN	/* LFN configuration */
 	i = dp->index;	/* SFN index */
 	res = dir_sdi(dp, (dp->lfn_idx == 0xFFFF) ? i : dp->lfn_idx);	/* Goto the SFN or top of the LFN entries */
 	if (res == FR_OK) {
@@ -2310,6 +2756,9 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #if _FS_LOCK			/* Clear file lock semaphores */
 	clear_lock(fs);
 #endif
+#if _USE_DIRINDEX
+	dix_clear(fs);
+#endif
 
 	return FR_OK;
 }
@@ -2379,10 +2828,16 @@ FRESULT f_mount (
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
 		cfs->fs_type = 0;				/* Clear old fs object */
+#if _USE_DIRINDEX
+		dix_clear(cfs);					/* Free tables of its indexes */
+#endif
 	}
 
 	if (fs) {
 		fs->fs_type = 0;				/* Clear new fs object */
+#if _USE_DIRINDEX
+		dix_init(fs);
+#endif
 #if _FS_REENTRANT						/* Create sync object for the new volume */
 		if (!ff_cre_syncobj((BYTE)vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -73,6 +73,21 @@ typedef char TCHAR;
 
 
 
+/* Directory index (DIRINDEX) */
+
+#if _USE_DIRINDEX
+typedef struct {
+	DWORD	sclust;			/* Indexed directory start cluster (1:Not used) */
+	WORD	size;			/* Slots in the table (0:No table) */
+	WORD	count;			/* Used slots (0xFFFF:Too many names) */
+	WORD	stale;			/* Removed objects since the index was built, slots over the limit with too many names */
+	WORD	stamp;			/* Last use */
+	DWORD*	slot;			/* Table on heap, b31-16:Name hash, b15-0:First entry index (0xFFFF:Empty) */
+} DIRINDEX;
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -104,6 +119,10 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory start sector (FAT32:Cluster#) */
 	DWORD	database;		/* Data start sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _USE_DIRINDEX
+	WORD	dixclock;		/* Directory index use counter */
+	DIRINDEX	dix[_DIRINDEX_DIRS];	/* Indexes of the last searched directories */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
@@ -268,10 +287,14 @@ DWORD get_fattime (void);
 #if _USE_LFN							/* Unicode - OEM code conversion */
 WCHAR ff_convert (WCHAR chr, UINT dir);	/* OEM-Unicode bidirectional conversion */
 WCHAR ff_wtoupper (WCHAR chr);			/* Unicode upper-case conversion */
-#if _USE_LFN == 3						/* Memory functions */
+#if _USE_LFN == 3 || _USE_DIRINDEX		/* Memory functions */
 void* ff_memalloc (UINT msize);			/* Allocate memory block */
 void ff_memfree (void* mblock);			/* Free memory block */
 #endif
+#if _USE_CPTABLE						/* Compressed code page table (option/cctable.c) */
+FRESULT ff_cpt_attach (const BYTE* table);	/* Use table in memory, 0 removes table */
+FRESULT ff_cpt_load (const TCHAR* path);	/* Use table file */
+#endif
 #endif
 
 /* Sync functions */
@@ -47,14 +47,33 @@
 /  f_findfirst() and f_findnext(). (0:Disable or 1:Enable) */
 
 
+#ifndef FATFS_HOST
 #define	_USE_MKFS		0
+#else
+#define	_USE_MKFS		1	/* Host benchmark formats RAM disk and image */
+#endif
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_FASTSEEK	0
+#define	_USE_FASTSEEK	1
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 
+#define	_USE_DIRINDEX	1
+#define	_DIRINDEX_DIRS	2
+#define	_DIRINDEX_MAX	4096
+/* This option switches the directory index. (0:Disable or 1:Enable)
+/  The last _DIRINDEX_DIRS searched directories of each volume get a hash table
+/  of names, so f_open(), f_stat() and path lookups in them do not scan the
+/  directory. The table is allocated by ff_memalloc() when the directory is
+/  indexed, 4 bytes a slot, power of 2 from 64 to _DIRINDEX_MAX slots with room
+/  for 1/4 more names. A name takes one slot, two if it has LFN, and 3/4 of the
+/  slots can be used: 4096 slots (16 KB) index directories of up to 3072 8.3
+/  names or 1536 long names. Bigger directories, or when the table can not be
+/  allocated, are scanned as without the index. Their index is built again
+/  when enough objects are removed. */
+
+
 #define _USE_LABEL		1
 /* This option switches volume label functions, f_getlabel() and f_setlabel().
 /  (0:Disable or 1:Enable) */
@@ -101,7 +120,25 @@
 /   1    - ASCII (No extended character. Valid for only non-LFN configuration.) */
 
 
-#define	_USE_LFN	1
+#define	_USE_CPTABLE	0
+#define	_CPTABLE_BLOCKS	160
+#define	_CPTABLE_CACHE	2
+#define	_CPTABLE_FRAGS	8
+/* This option switches the compressed code page table for DBCS code pages (932,
+/  936, 949 and 950) with LFN. (0:Disable or 1:Enable)
+/  option/cctable.c is used instead of option/cc9xx.c (60 to 175 KB of flash).
+/  Its table is made from cc9xx.c by Tools/fatfs_cptable.py (42 to 64 KB) and is
+/  attached from flash with ff_cpt_attach() or read from a file with ff_cpt_load().
+/  A table file is read by 512 byte blocks, last _CPTABLE_CACHE blocks are kept
+/  in RAM. _CPTABLE_BLOCKS is the size of the block index in RAM (2 bytes a block)
+/  and _CPTABLE_FRAGS the number of fragments of the table file. */
+
+
+#ifndef FATFS_HOST
+#define	_USE_LFN	3	/* Work area on FreeRTOS heap (option/syscall.c), 1 is not thread-safe */
+#else
+#define	_USE_LFN	2
+#endif
 #define	_MAX_LFN	255
 /* The _USE_LFN option switches the LFN feature.
 /
@@ -149,7 +186,7 @@
 / Drive/Volume Configurations
 /---------------------------------------------------------------------------*/
 
-#define _VOLUMES	2
+#define _VOLUMES	4	/* 0: SD card, 1: USB, 2: RAM disk, 3: disk image (diskio.c) */
 /* Number of volumes (logical drives) to be used. */
 
 
@@ -217,7 +254,7 @@
 /  These options have no effect at read-only configuration (_FS_READONLY == 1). */
 
 
-#define	_FS_LOCK	0
+#define	_FS_LOCK	8
 /* The _FS_LOCK option switches file lock feature to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
 /  is 1.
@@ -229,9 +266,20 @@
 /      lock feature is independent of re-entrancy. */
 
 
-#define _FS_REENTRANT	0
+#ifndef FATFS_HOST
+#define _FS_REENTRANT	1
+#define _FS_TIMEOUT		1000
+#define	_SYNC_t			SemaphoreHandle_t
+#include "FreeRTOS.h"	/* Mutex of volume (option/syscall.c) */
+#include "task.h"
+#include "semphr.h"
+#define _FS_LOCK_ENTER()	taskENTER_CRITICAL()	/* File lock table is shared by volumes */
+#define _FS_LOCK_EXIT()		taskEXIT_CRITICAL()
+#else
+#define _FS_REENTRANT	0	/* Host build without FreeRTOS (Tools/fatfs_bench) */
 #define _FS_TIMEOUT		1000
-#define	_SYNC_t			HANDLE
+#define	_SYNC_t			int
+#endif
 /* The _FS_REENTRANT option switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
 /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -1,13 +1,24 @@
 /*------------------------------------------------------------------------*/
-/* Sample code of OS dependent controls for FatFs                         */
+/* OS dependent controls for FatFs, FreeRTOS                              */
 /* (C)ChaN, 2014                                                          */
 /*------------------------------------------------------------------------*/
+/* Each volume has its own mutex, tasks using different volumes (SD card  */
+/* and USB) do not wait for each other. Mutex is created by first mount   */
+/* of the volume and kept, so heap is not fragmented by mount/unmount.    */
+/* Mutex is recursive, code page table (option/cctable.c) locks volume of */
+/* its file also from file functions of that volume.                      */
+/*------------------------------------------------------------------------*/
 
 
 #include "../ff.h"
+#ifdef FATFS_HOST
+#include <stdlib.h>
+#endif
 
 
 #if _FS_REENTRANT
+static SemaphoreHandle_t SyncObjects[_VOLUMES];
+
 /*------------------------------------------------------------------------*/
 /* Create a Synchronization Object                                        */
 /*------------------------------------------------------------------------*/
@@ -21,22 +32,12 @@ int ff_cre_syncobj (	/* !=0:Function succeeded, ==0:Could not create due to any
 	_SYNC_t *sobj		/* Pointer to return the created sync object */
 )
 {
-	int ret;
-
-
-	*sobj = CreateMutex(NULL, FALSE, NULL);		/* Win32 */
-	ret = (int)(*sobj != INVALID_HANDLE_VALUE);
-
-//	*sobj = SyncObjects[vol];			/* uITRON (give a static created sync object) */
-//	ret = 1;							/* The initial value of the semaphore must be 1. */
+	if (!SyncObjects[vol]) {
+		SyncObjects[vol] = xSemaphoreCreateRecursiveMutex();
+	}
+	*sobj = SyncObjects[vol];
 
-//	*sobj = OSMutexCreate(0, &err);		/* uC/OS-II */
-//	ret = (int)(err == OS_NO_ERR);
-
-//	*sobj = xSemaphoreCreateMutex();	/* FreeRTOS */
-//	ret = (int)(*sobj != NULL);
-
-	return ret;
+	return (int)(*sobj != NULL);
 }
 
 
@@ -53,20 +54,9 @@ int ff_del_syncobj (	/* !=0:Function succeeded, ==0:Could not delete due to any
 	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
 )
 {
-	int ret;
-
-
-	ret = CloseHandle(sobj);	/* Win32 */
-
-//	ret = 1;					/* uITRON (nothing to do) */
-
-//	OSMutexDel(sobj, OS_DEL_ALWAYS, &err);	/* uC/OS-II */
-//	ret = (int)(err == OS_NO_ERR);
+	(void)sobj;		/* Mutex is used again by next mount of the volume */
 
-//  vSemaphoreDelete(sobj);		/* FreeRTOS */
-//	ret = 1;
-
-	return ret;
+	return 1;
 }
 
 
@@ -82,18 +72,7 @@ int ff_req_grant (	/* 1:Got a grant to access the volume, 0:Could not get a gran
 	_SYNC_t sobj	/* Sync object to wait */
 )
 {
-	int ret;
-
-	ret = (int)(WaitForSingleObject(sobj, _FS_TIMEOUT) == WAIT_OBJECT_0);	/* Win32 */
-
-//	ret = (int)(wai_sem(sobj) == E_OK);			/* uITRON */
-
-//	OSMutexPend(sobj, _FS_TIMEOUT, &err));		/* uC/OS-II */
-//	ret = (int)(err == OS_NO_ERR);
-
-//	ret = (int)(xSemaphoreTake(sobj, _FS_TIMEOUT) == pdTRUE);	/* FreeRTOS */
-
-	return ret;
+	return (int)(xSemaphoreTakeRecursive(sobj, _FS_TIMEOUT) == pdTRUE);
 }
 
 
@@ -108,13 +87,7 @@ void ff_rel_grant (
 	_SYNC_t sobj	/* Sync object to be signaled */
 )
 {
-	ReleaseMutex(sobj);		/* Win32 */
-
-//	sig_sem(sobj);			/* uITRON */
-
-//	OSMutexPost(sobj);		/* uC/OS-II */
-
-//	xSemaphoreGive(sobj);	/* FreeRTOS */
+	xSemaphoreGiveRecursive(sobj);
 }
 
 #endif
@@ -122,7 +95,7 @@ void ff_rel_grant (
 
 
 
-#if _USE_LFN == 3	/* LFN with a working buffer on the heap */
+#if _USE_LFN == 3 || _USE_DIRINDEX	/* LFN working buffer and directory index tables on the heap */
 /*------------------------------------------------------------------------*/
 /* Allocate a memory block                                                */
 /*------------------------------------------------------------------------*/
@@ -133,7 +106,11 @@ void* ff_memalloc (	/* Returns pointer to the allocated memory block */
 	UINT msize		/* Number of bytes to allocate */
 )
 {
-	return malloc(msize);	/* Allocate a new memory block with POSIX API */
+#ifndef FATFS_HOST
+	return pvPortMalloc(msize);	/* LFN buffer and power of 2 index tables, heap_2 reuses blocks of these sizes */
+#else
+	return malloc(msize);
+#endif
 }
 
 
@@ -145,7 +122,11 @@ void ff_memfree (
 	void* mblock	/* Pointer to the memory block to free */
 )
 {
-	free(mblock);	/* Discard the memory block with POSIX API */
+#ifndef FATFS_HOST
+	vPortFree(mblock);
+#else
+	free(mblock);
+#endif
 }
 
 #endif
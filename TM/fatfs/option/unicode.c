@@ -2,7 +2,9 @@
 
 #if _USE_LFN != 0
 
-#if   _CODE_PAGE == 932	/* Japanese Shift_JIS */
+#if   _USE_CPTABLE		/* DBCS with compressed table (Tools/fatfs_cptable.py) */
+#include "cctable.c"
+#elif _CODE_PAGE == 932	/* Japanese Shift_JIS */
 #include "cc932.c"
 #elif _CODE_PAGE == 936	/* Simplified Chinese GBK */
 #include "cc936.c"
@@ -17,6 +17,7 @@
  * |----------------------------------------------------------------------
  */
 #include "tm_stm32f4_fatfs.h"
+#include <string.h>
 
 FRESULT TM_FATFS_DriveSize(uint32_t* total, uint32_t* free) {
 	FATFS *fs;
@@ -58,6 +59,8 @@ FRESULT TM_FATFS_USBDriveSize(uint32_t* total, uint32_t* free) {
 
 FRESULT TM_FATFS_TruncateBeginning(FIL* fil, uint32_t index) {
 	uint8_t Buffer[FATFS_TRUNCATE_BUFFER_SIZE];				/* Buffer for temporary data */
+	DWORD Table[FATFS_FASTSEEK_TABLE_SIZE];					/* Cluster map, both seeks in loop are O(1) */
+	DWORD* UserTable = fil->cltbl;							/* Fast seek table set by user */
 
 	uint32_t FileSize = f_size(fil);						/* Size of file */
 	uint32_t ReadIndex = index;								/* Starting read index */
@@ -65,9 +68,9 @@ FRESULT TM_FATFS_TruncateBeginning(FIL* fil, uint32_t index) {
 	uint32_t TotalSize = FileSize - ReadIndex;				/* New file size after truncate */
 	uint32_t NewSize = TotalSize;							/* Save new file size */
 	uint32_t BlockSize;										/* Block size for read operation */
-	uint32_t Read;											/* Read bytes */
-	uint32_t Written;										/* Written bytes */
-	FRESULT fr;												/* Result typedef */
+	UINT Read;												/* Read bytes */
+	UINT Written;											/* Written bytes */
+	FRESULT fr = FR_OK;										/* Result typedef */
 	
 	/* Index is 0 or file is empty, nothing to do */
 	if (index == 0 || FileSize == 0) {
@@ -76,33 +79,245 @@ FRESULT TM_FATFS_TruncateBeginning(FIL* fil, uint32_t index) {
 	
 	/* Check if index is more than file size, truncate all */
 	if (index > FileSize) {
+		TM_FATFS_NormalSeek(fil);							/* File is shortened */
 		fr = f_lseek(fil, 0);								/* Go to beginning */
 		if (fr) return fr;									/* Check for success */
 		return f_truncate(fil);								/* Truncate file from new end to actual end */
 	}
 	
+	/* Data are moved inside file, it is not extended, fast seek can be used */
+	/* Too fragmented file stays in normal seek mode */
+	if (UserTable == 0) {
+		TM_FATFS_FastSeek(fil, Table, FATFS_FASTSEEK_TABLE_SIZE);
+	}
+	
 	/* Until we have available data in file after user specific index */
 	while (TotalSize > 0) {
 		/* Calculate new block size for new read operation */
 		BlockSize = (TotalSize > FATFS_TRUNCATE_BUFFER_SIZE) ? (FATFS_TRUNCATE_BUFFER_SIZE) : (TotalSize);
 	
 		fr = f_lseek(fil, ReadIndex);						/* Go to the read index */
-		if (fr) return fr;									/* Check for success */
+		if (fr) break;										/* Check for success */
 		fr = f_read(fil, &Buffer, BlockSize, &Read);		/* Read data */
-		if (fr) return fr;									/* Check for success */
+		if (fr) break;										/* Check for success */
 
 		fr = f_lseek(fil, WriteIndex);						/* Go back to the write index */
-		if (fr) return fr;									/* Check for success */
+		if (fr) break;										/* Check for success */
 		fr = f_write(fil, &Buffer, BlockSize, &Written);/* Write data */
-		if (fr) return fr;									/* Check for success */
+		if (fr) break;										/* Check for success */
 
 		TotalSize -= BlockSize;								/* Calculate new total size we have more to move everything */
 		ReadIndex += Read;									/* Calculate new read pointer */
 		WriteIndex += Written;								/* Calculate new write pointer */
 	}
 	
+	/* Local table is not valid after return, truncate changes cluster chain */
+	TM_FATFS_NormalSeek(fil);
+	if (fr) return fr;
+	
 	fr = f_lseek(fil, NewSize);								/* Move pointer to the "end" of new file */
 	if (fr) return fr;										/* Check for success */
 	fr =  f_truncate(fil);									/* Truncate file from new end to actual end */
+	if (fr) return fr;										/* Check for success */
+	
+	/* Rebuild user table, shorter chain needs at most as many items as before */
+	if (UserTable != 0) {
+		TM_FATFS_FastSeek(fil, UserTable, UserTable[0]);
+	}
 	return f_lseek(fil, 0);									/* Move pointer to the beginning */
 }
+
+FRESULT TM_FATFS_FastSeek(FIL* fil, DWORD* table, uint32_t size) {
+	FRESULT fr;
+	
+	/* First item is table size, FatFs replaces it with used size */
+	table[0] = size;
+	fil->cltbl = table;
+	fr = f_lseek(fil, CREATE_LINKMAP);
+	if (fr != FR_OK) {
+		fil->cltbl = 0;										/* Table is not complete, normal seek */
+	}
+	return fr;
+}
+
+FRESULT TM_FATFS_OpenFastSeek(FIL* fil, const TCHAR* path, BYTE mode, DWORD* table, uint32_t size) {
+	FRESULT fr;
+	
+	fr = f_open(fil, path, mode);
+	if (fr) return fr;										/* Check for success */
+	fr = TM_FATFS_FastSeek(fil, table, size);
+	if (fr == FR_NOT_ENOUGH_CORE) {
+		return FR_OK;										/* File is opened, only in normal seek mode */
+	}
+	if (fr) {
+		f_close(fil);
+	}
+	return fr;
+}
+
+void TM_FATFS_NormalSeek(FIL* fil) {
+	fil->cltbl = 0;
+}
+
+
+/* Private functions */
+static FRESULT TM_FATFS_RingWriteHeader(TM_FATFS_Ring_t* Ring) {
+	UINT Written;
+	FRESULT fr;
+	
+	Ring->Header.Sequence++;
+	fr = f_lseek(&Ring->File, 0);
+	if (fr) return fr;										/* Check for success */
+	fr = f_write(&Ring->File, &Ring->Header, sizeof(TM_FATFS_RingHeader_t), &Written);
+	if (fr) return fr;										/* Check for success */
+	return (Written == sizeof(TM_FATFS_RingHeader_t)) ? FR_OK : FR_DENIED;
+}
+
+static FRESULT TM_FATFS_RingSeek(TM_FATFS_Ring_t* Ring, uint32_t offset) {
+	/* Seek only when needed, sequential writes and reads continue where they are */
+	if (f_tell(&Ring->File) == FATFS_RING_HEADER_SIZE + offset) {
+		return FR_OK;
+	}
+	return f_lseek(&Ring->File, FATFS_RING_HEADER_SIZE + offset);
+}
+
+FRESULT TM_FATFS_RingOpen(TM_FATFS_Ring_t* Ring, const TCHAR* path, uint32_t size) {
+	TM_FATFS_RingHeader_t* Header = &Ring->Header;
+	UINT Read;
+	FRESULT fr;
+	
+	fr = f_open(&Ring->File, path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+	if (fr) return fr;										/* Check for success */
+	
+	/* Existing ring is continued if header is valid */
+	if (
+		f_size(&Ring->File) == FATFS_RING_HEADER_SIZE + size &&
+		f_read(&Ring->File, Header, sizeof(TM_FATFS_RingHeader_t), &Read) == FR_OK && Read == sizeof(TM_FATFS_RingHeader_t) &&
+		Header->Magic == FATFS_RING_MAGIC && Header->Size == size &&
+		Header->Head < size && Header->Tail < size && Header->Used <= size
+	) {
+		TM_FATFS_FastSeek(&Ring->File, Ring->Table, FATFS_RING_TABLE_SIZE);
+		return FR_OK;
+	}
+	
+	/* Seek after end allocates clusters without writing data, longer file is cut */
+	fr = f_lseek(&Ring->File, FATFS_RING_HEADER_SIZE + size);
+	if (fr == FR_OK && f_tell(&Ring->File) != FATFS_RING_HEADER_SIZE + size) {
+		fr = FR_DENIED;										/* Disk is full */
+	}
+	if (fr == FR_OK) {
+		fr = f_truncate(&Ring->File);
+	}
+	
+	/* Empty ring */
+	if (fr == FR_OK) {
+		memset(Header, 0, sizeof(TM_FATFS_RingHeader_t));
+		Header->Magic = FATFS_RING_MAGIC;
+		Header->Size = size;
+		fr = TM_FATFS_RingWriteHeader(Ring);
+	}
+	if (fr == FR_OK) {
+		fr = f_sync(&Ring->File);
+	}
+	if (fr) {
+		f_close(&Ring->File);
+		return fr;
+	}
+	
+	/* Too fragmented file still works, seeks follow FAT chain */
+	TM_FATFS_FastSeek(&Ring->File, Ring->Table, FATFS_RING_TABLE_SIZE);
+	return FR_OK;
+}
+
+FRESULT TM_FATFS_RingWrite(TM_FATFS_Ring_t* Ring, const void* data, uint32_t count) {
+	TM_FATFS_RingHeader_t* Header = &Ring->Header;
+	const uint8_t* Data = (const uint8_t *)data;
+	uint32_t Chunk, Drop;
+	UINT Written;
+	FRESULT fr;
+	
+	while (count > 0) {
+		/* Up to end of data area, then wrap */
+		Chunk = Header->Size - Header->Head;
+		if (Chunk > count) {
+			Chunk = count;
+		}
+		
+		/* Drop oldest blocks to make space, only tail is moved */
+		if (Header->Used + Chunk > Header->Size) {
+			Drop = Header->Used + Chunk - Header->Size;
+			Drop = (Drop + FATFS_RING_DROP_SIZE - 1) & ~(FATFS_RING_DROP_SIZE - 1);
+			TM_FATFS_RingConsume(Ring, Drop);
+		}
+		
+		fr = TM_FATFS_RingSeek(Ring, Header->Head);
+		if (fr) return fr;									/* Check for success */
+		fr = f_write(&Ring->File, Data, Chunk, &Written);
+		if (fr) return fr;									/* Check for success */
+		if (Written != Chunk) return FR_DENIED;
+		
+		Header->Head = (Header->Head + Chunk) % Header->Size;
+		Header->Used += Chunk;
+		Data += Chunk;
+		count -= Chunk;
+	}
+	return FR_OK;
+}
+
+FRESULT TM_FATFS_RingRead(TM_FATFS_Ring_t* Ring, void* data, uint32_t count, uint32_t* read) {
+	TM_FATFS_RingHeader_t* Header = &Ring->Header;
+	uint8_t* Data = (uint8_t *)data;
+	uint32_t Chunk;
+	UINT Read;
+	FRESULT fr;
+	
+	*read = 0;
+	if (count > Header->Used) {
+		count = Header->Used;
+	}
+	while (count > 0) {
+		/* Up to end of data area, then wrap */
+		Chunk = Header->Size - Header->Tail;
+		if (Chunk > count) {
+			Chunk = count;
+		}
+		
+		fr = TM_FATFS_RingSeek(Ring, Header->Tail);
+		if (fr) return fr;									/* Check for success */
+		fr = f_read(&Ring->File, Data, Chunk, &Read);
+		if (fr) return fr;									/* Check for success */
+		if (Read != Chunk) return FR_INT_ERR;				/* File is shorter than header says */
+		
+		TM_FATFS_RingConsume(Ring, Chunk);
+		*read += Chunk;
+		Data += Chunk;
+		count -= Chunk;
+	}
+	return FR_OK;
+}
+
+void TM_FATFS_RingConsume(TM_FATFS_Ring_t* Ring, uint32_t count) {
+	if (count > Ring->Header.Used) {
+		count = Ring->Header.Used;
+	}
+	Ring->Header.Tail = (Ring->Header.Tail + count) % Ring->Header.Size;
+	Ring->Header.Used -= count;
+}
+
+FRESULT TM_FATFS_RingSync(TM_FATFS_Ring_t* Ring) {
+	FRESULT fr;
+	
+	fr = f_sync(&Ring->File);								/* Data first */
+	if (fr) return fr;										/* Check for success */
+	fr = TM_FATFS_RingWriteHeader(Ring);					/* Then header which points to them */
+	if (fr) return fr;										/* Check for success */
+	return f_sync(&Ring->File);
+}
+
+FRESULT TM_FATFS_RingClose(TM_FATFS_Ring_t* Ring) {
+	FRESULT fr;
+	
+	fr = TM_FATFS_RingSync(Ring);
+	f_close(&Ring->File);
+	return fr;
+}
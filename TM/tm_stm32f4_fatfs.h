@@ -312,11 +312,15 @@ f_mount(&usb_fs, "1:", 1);
 @endverbatim
  */
 
+#ifndef FATFS_HOST		/* Host build uses only FatFs wrappers (Tools/fatfs_bench) */
 #include "stm32f4xx.h"
 #include "stm32f4xx_rcc.h"
 #include "stm32f4xx_gpio.h"
-#include "defines.h"
 #include "tm_stm32f4_gpio.h"
+#else
+#include <stdint.h>
+#endif
+#include "defines.h"
 #include "ff.h"
 
 /**
@@ -335,6 +339,72 @@ f_mount(&usb_fs, "1:", 1);
 #define FATFS_TRUNCATE_BUFFER_SIZE	256
 #endif
 
+/**
+ * @brief  Default size of cluster link map table for fast seek, in DWORDs
+ * @note   File with N fragments (continuous cluster runs) needs 2 * N + 2 items.
+ *         Table is used by @ref TM_FATFS_TruncateBeginning and can be used for @ref TM_FATFS_FastSeek
+ */
+#ifndef FATFS_FASTSEEK_TABLE_SIZE
+#define FATFS_FASTSEEK_TABLE_SIZE	32
+#endif
+
+/**
+ * @brief  Ring file header sector size in bytes, data start after it
+ */
+#define FATFS_RING_HEADER_SIZE		512
+
+/**
+ * @brief  Ring file header magic, "RING"
+ */
+#define FATFS_RING_MAGIC			0x474E4952
+
+/**
+ * @brief  When ring file is full, oldest data are dropped in blocks of this size
+ * @note   Power of 2. With 512, tail stays sector aligned if writes are aligned
+ */
+#ifndef FATFS_RING_DROP_SIZE
+#define FATFS_RING_DROP_SIZE		512
+#endif
+
+/**
+ * @brief  Fast seek table size of ring file, in DWORDs
+ * @note   Preallocated file is usually in one or two fragments
+ */
+#ifndef FATFS_RING_TABLE_SIZE
+#define FATFS_RING_TABLE_SIZE		8
+#endif
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup TM_FATFS_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  Ring file header, first bytes of header sector
+ */
+typedef struct {
+	uint32_t Magic;		/*!< @ref FATFS_RING_MAGIC */
+	uint32_t Size;		/*!< Data bytes after header sector */
+	uint32_t Head;		/*!< Next write offset in data */
+	uint32_t Tail;		/*!< Offset of oldest byte */
+	uint32_t Used;		/*!< Valid bytes from tail */
+	uint32_t Sequence;	/*!< Incremented with every header write */
+} TM_FATFS_RingHeader_t;
+
+/**
+ * @brief  Ring file, use @ref TM_FATFS_RingOpen to initialize it
+ */
+typedef struct {
+	FIL File;								/*!< Opened ring file */
+	TM_FATFS_RingHeader_t Header;			/*!< Header in RAM, written by @ref TM_FATFS_RingSync */
+	DWORD Table[FATFS_RING_TABLE_SIZE];		/*!< Fast seek table of file */
+} TM_FATFS_Ring_t;
+
 /**
  * @}
  */
@@ -373,10 +443,108 @@ FRESULT TM_FATFS_USBDriveSize(uint32_t* total, uint32_t* free);
  * @param  *fil: Pointer to already opened file
  * @param  index: Number of characters that will be truncated from beginning
  * @note   If index is more than file size, everything will be truncated, but file will not be deleted
+ * @note   Whole rest of file is copied. For logs and queues use ring file (@ref TM_FATFS_RingOpen),
+ *         it drops old data by moving offset in header
  * @retval FRESULT struct members. If everything ok, FR_OK is returned
  */
 FRESULT TM_FATFS_TruncateBeginning(FIL* fil, uint32_t index);
 
+/**
+ * @brief  Enables fast seek on opened file
+ * @note   Cluster link map table (CLMT) of file is built once, f_lseek and f_read/f_write
+ *         across clusters then find cluster in table instead of following FAT chain.
+ *         Table must be valid while file is open and file must not be extended in fast seek mode,
+ *         call @ref TM_FATFS_NormalSeek before writing after end of file or f_truncate.
+ * @param  *fil: Pointer to already opened file
+ * @param  *table: Pointer to table for cluster link map
+ * @param  size: Number of DWORD items in table, @ref FATFS_FASTSEEK_TABLE_SIZE is usually enough
+ * @retval FRESULT struct members. If file is too fragmented for table, FR_NOT_ENOUGH_CORE
+ *         is returned and file stays in normal seek mode
+ */
+FRESULT TM_FATFS_FastSeek(FIL* fil, DWORD* table, uint32_t size);
+
+/**
+ * @brief  Opens file and enables fast seek on it
+ * @param  *fil: Pointer to file object
+ * @param  *path: File name
+ * @param  mode: Open mode, same as for f_open
+ * @param  *table: Pointer to table for cluster link map
+ * @param  size: Number of DWORD items in table
+ * @retval FRESULT struct members. Fragmented file which does not fit to table is opened in normal seek mode
+ */
+FRESULT TM_FATFS_OpenFastSeek(FIL* fil, const TCHAR* path, BYTE mode, DWORD* table, uint32_t size);
+
+/**
+ * @brief  Returns file to normal seek mode, table is not used anymore
+ * @param  *fil: Pointer to opened file
+ * @retval None
+ */
+void TM_FATFS_NormalSeek(FIL* fil);
+
+/**
+ * @brief  Opens ring file, existing ring with valid header and the same size is continued
+ * @note   New file is preallocated to @ref FATFS_RING_HEADER_SIZE + size bytes (clusters are allocated,
+ *         data are not written) and opened in fast seek mode, so every seek is O(1).
+ *         Head, tail and used size are kept in header sector at the beginning of file.
+ * @param  *Ring: Pointer to ring structure
+ * @param  *path: File name
+ * @param  size: Data size in bytes, multiple of @ref FATFS_RING_DROP_SIZE
+ * @retval FRESULT struct members. FR_DENIED is returned when disk is full
+ */
+FRESULT TM_FATFS_RingOpen(TM_FATFS_Ring_t* Ring, const TCHAR* path, uint32_t size);
+
+/**
+ * @brief  Appends data at head of ring
+ * @note   When ring is full, oldest data are dropped in blocks of @ref FATFS_RING_DROP_SIZE bytes,
+ *         only tail in header is moved, nothing is copied
+ * @param  *Ring: Pointer to opened ring
+ * @param  *data: Data to write
+ * @param  count: Number of bytes
+ * @retval FRESULT struct members. If everything ok, FR_OK is returned
+ */
+FRESULT TM_FATFS_RingWrite(TM_FATFS_Ring_t* Ring, const void* data, uint32_t count);
+
+/**
+ * @brief  Reads and removes oldest data from ring
+ * @param  *Ring: Pointer to opened ring
+ * @param  *data: Buffer for data
+ * @param  count: Max number of bytes
+ * @param  *read: Number of bytes read, less than count when ring has less data
+ * @retval FRESULT struct members. If everything ok, FR_OK is returned
+ */
+FRESULT TM_FATFS_RingRead(TM_FATFS_Ring_t* Ring, void* data, uint32_t count, uint32_t* read);
+
+/**
+ * @brief  Removes oldest data from ring without reading them, constant time
+ * @param  *Ring: Pointer to opened ring
+ * @param  count: Number of bytes, everything is removed if it is more than used size
+ * @retval None
+ */
+void TM_FATFS_RingConsume(TM_FATFS_Ring_t* Ring, uint32_t count);
+
+/**
+ * @brief  Syncs data and then writes header
+ * @note   Header never points to data which are not on disk. Head and tail changes since last sync
+ *         are lost on power loss
+ * @param  *Ring: Pointer to opened ring
+ * @retval FRESULT struct members. If everything ok, FR_OK is returned
+ */
+FRESULT TM_FATFS_RingSync(TM_FATFS_Ring_t* Ring);
+
+/**
+ * @brief  Syncs and closes ring file
+ * @param  *Ring: Pointer to opened ring
+ * @retval FRESULT struct members. If everything ok, FR_OK is returned
+ */
+FRESULT TM_FATFS_RingClose(TM_FATFS_Ring_t* Ring);
+
+/**
+ * @brief  Number of bytes in ring
+ * @param  *Ring: Pointer to opened ring
+ * @retval Used bytes
+ */
+#define TM_FATFS_RingUsed(Ring)		((Ring)->Header.Used)
+
 /**
  * @}
  */
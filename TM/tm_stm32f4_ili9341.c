@@ -22,7 +22,13 @@
 uint16_t ILI9341_x;
 uint16_t ILI9341_y;
 TM_ILI931_Options_t ILI9341_Opts;
+TM_ILI9341_Clip_t ILI9341_Clip;
+TM_ILI9341_Counters_t ILI9341_Counters;
 uint8_t ILI9341_INT_CalledFromPuts = 0;
+void (*ILI9341_DamageCallback)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) = 0;
+#if ILI9341_USE_DMA == 1
+volatile uint8_t ILI9341_DMA_Busy = 0;
+#endif
 
 /* Private functions */
 void TM_ILI9341_InitLCD(void);
@@ -30,6 +36,10 @@ void TM_ILI9341_SendData(uint8_t data);
 void TM_ILI9341_SendCommand(uint8_t data);
 void TM_ILI9341_Delay(volatile unsigned int delay);
 void TM_ILI9341_SetCursorPosition(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+void TM_ILI9341_INT_SetAddress(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+void TM_ILI9341_INT_FillWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint32_t color);
+void TM_ILI9341_INT_FillRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color);
+void TM_ILI9341_INT_DrawPixel(int16_t x, int16_t y, uint32_t color);
 
 void TM_ILI9341_Init() {
 	/* Init WRX pin */
@@ -47,6 +57,12 @@ void TM_ILI9341_Init() {
 	/* Init SPI */
 	TM_SPI_Init(ILI9341_SPI, ILI9341_SPI_PINS);
 	
+#if ILI9341_USE_DMA == 1
+	/* Enable DMA clock */
+	RCC_AHB1PeriphClockCmd(ILI9341_DMA_CLK, ENABLE);
+	DMA_DeInit(ILI9341_DMA_STREAM);
+#endif
+	
 	/* Init LCD */
 	TM_ILI9341_InitLCD();	
 	
@@ -55,6 +71,7 @@ void TM_ILI9341_Init() {
 	ILI9341_Opts.width = ILI9341_WIDTH;
 	ILI9341_Opts.height = ILI9341_HEIGHT;
 	ILI9341_Opts.orientation = TM_ILI9341_Portrait;
+	TM_ILI9341_ResetClip();
 	
 	/* Fill with white color */
 	TM_ILI9341_Fill(ILI9341_COLOR_WHITE);
@@ -174,6 +191,8 @@ void TM_ILI9341_DisplayOff(void) {
 }
 
 void TM_ILI9341_SendCommand(uint8_t data) {
+	TM_ILI9341_WaitDMA();
+	ILI9341_Counters.commands++;
 	ILI9341_WRX_RESET;
 	ILI9341_CS_RESET;
 	TM_SPI_Send(ILI9341_SPI, data);
@@ -181,6 +200,7 @@ void TM_ILI9341_SendCommand(uint8_t data) {
 }
 
 void TM_ILI9341_SendData(uint8_t data) {
+	ILI9341_Counters.data++;
 	ILI9341_WRX_SET;
 	ILI9341_CS_RESET;
 	TM_SPI_Send(ILI9341_SPI, data);
@@ -188,6 +208,10 @@ void TM_ILI9341_SendData(uint8_t data) {
 }
 
 void TM_ILI9341_DrawPixel(uint16_t x, uint16_t y, uint32_t color) {
+	/* Check clip */
+	if (x < ILI9341_Clip.x1 || x > ILI9341_Clip.x2 || y < ILI9341_Clip.y1 || y > ILI9341_Clip.y2) {
+		return;
+	}
 	TM_ILI9341_SetCursorPosition(x, y, x, y);
 
 	TM_ILI9341_SendCommand(ILI9341_GRAM);
@@ -197,6 +221,19 @@ void TM_ILI9341_DrawPixel(uint16_t x, uint16_t y, uint32_t color) {
 
 
 void TM_ILI9341_SetCursorPosition(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+	/* Every write sets window first, so window is area which will be changed */
+	if (ILI9341_DamageCallback) {
+		ILI9341_DamageCallback(x1, y1, x2, y2);
+	}
+	ILI9341_Counters.windows++;
+	TM_ILI9341_INT_SetAddress(x1, y1, x2, y2);
+}
+
+void TM_ILI9341_SetDamageCallback(void (*callback)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)) {
+	ILI9341_DamageCallback = callback;
+}
+
+void TM_ILI9341_INT_SetAddress(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
 	TM_ILI9341_SendCommand(ILI9341_COLUMN_ADDR);
 	TM_ILI9341_SendData(x1 >> 8);
 	TM_ILI9341_SendData(x1 & 0xFF);
@@ -210,18 +247,240 @@ void TM_ILI9341_SetCursorPosition(uint16_t x1, uint16_t y1, uint16_t x2, uint16_
 	TM_ILI9341_SendData(y2 & 0xFF);
 }
 
+void TM_ILI9341_SetWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+	TM_ILI9341_SetCursorPosition(x1, y1, x2, y2);
+	TM_ILI9341_SendCommand(ILI9341_GRAM);
+}
+
+void TM_ILI9341_WriteData(uint8_t* data, uint32_t count) {
+	TM_ILI9341_WaitDMA();
+	ILI9341_Counters.data += count;
+	ILI9341_WRX_SET;
+	ILI9341_CS_RESET;
+	while (count--) {
+		TM_SPI_Send(ILI9341_SPI, *data++);
+	}
+	ILI9341_CS_SET;
+}
+
+#if ILI9341_USE_DMA == 1
+void TM_ILI9341_WriteDataDMA(uint8_t* data, uint16_t count) {
+	DMA_InitTypeDef DMA_InitStruct;
+	
+	/* Previous transfer has to finish first */
+	TM_ILI9341_WaitDMA();
+	if (count == 0) {
+		return;
+	}
+	
+	DMA_StructInit(&DMA_InitStruct);
+	DMA_InitStruct.DMA_Channel = ILI9341_DMA_CHANNEL;
+	DMA_InitStruct.DMA_PeripheralBaseAddr = (uint32_t)&ILI9341_SPI->DR;
+	DMA_InitStruct.DMA_Memory0BaseAddr = (uint32_t)data;
+	DMA_InitStruct.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+	DMA_InitStruct.DMA_BufferSize = count;
+	DMA_InitStruct.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStruct.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStruct.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStruct.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStruct.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStruct.DMA_Priority = DMA_Priority_High;
+	DMA_InitStruct.DMA_FIFOMode = DMA_FIFOMode_Disable;
+	DMA_Init(ILI9341_DMA_STREAM, &DMA_InitStruct);
+	DMA_ClearFlag(ILI9341_DMA_STREAM, ILI9341_DMA_FLAGS);
+	
+	ILI9341_WRX_SET;
+	ILI9341_CS_RESET;
+	ILI9341_DMA_Busy = 1;
+	ILI9341_Counters.dma++;
+	ILI9341_Counters.dma_data += count;
+	
+	/* Start transfer */
+	DMA_Cmd(ILI9341_DMA_STREAM, ENABLE);
+	SPI_I2S_DMACmd(ILI9341_SPI, SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+void TM_ILI9341_WaitDMA(void) {
+	if (ILI9341_DMA_Busy == 0) {
+		return;
+	}
+	
+	/* Wait till last byte is on the bus */
+	while (DMA_GetFlagStatus(ILI9341_DMA_STREAM, ILI9341_DMA_FLAG_TC) == RESET);
+	while ((ILI9341_SPI->SR & SPI_SR_TXE) == 0);
+	while (ILI9341_SPI->SR & SPI_SR_BSY);
+	
+	SPI_I2S_DMACmd(ILI9341_SPI, SPI_I2S_DMAReq_Tx, DISABLE);
+	DMA_Cmd(ILI9341_DMA_STREAM, DISABLE);
+	
+	/* Received bytes were not read, clear overrun */
+	(void)ILI9341_SPI->DR;
+	(void)ILI9341_SPI->SR;
+	
+	ILI9341_CS_SET;
+	ILI9341_DMA_Busy = 0;
+}
+#else
+void TM_ILI9341_WriteDataDMA(uint8_t* data, uint16_t count) {
+	TM_ILI9341_WriteData(data, count);
+}
+
+void TM_ILI9341_WaitDMA(void) {
+	
+}
+#endif
+
+void TM_ILI9341_ReadArea(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t* data) {
+	uint32_t n = (uint32_t)(x2 - x1 + 1) * (y2 - y1 + 1);
+	uint16_t cr1, color;
+	uint8_t r, g, b;
+	
+	ILI9341_Counters.read += n;
+	
+	/* Reading does not change anything, so damage callback is not called */
+	TM_ILI9341_INT_SetAddress(x1, y1, x2, y2);
+	
+	/* Slow down SPI for reading, prescaler can be changed only when SPI is disabled */
+	cr1 = ILI9341_SPI->CR1;
+	ILI9341_SPI->CR1 = cr1 & ~SPI_CR1_SPE;
+	ILI9341_SPI->CR1 = (cr1 & ~(SPI_CR1_BR | SPI_CR1_SPE)) | ILI9341_READ_PRESCALER;
+	ILI9341_SPI->CR1 |= SPI_CR1_SPE;
+	
+	/* CS must stay low from command to last pixel, otherwise reading stops */
+	ILI9341_WRX_RESET;
+	ILI9341_CS_RESET;
+	TM_SPI_Send(ILI9341_SPI, ILI9341_GRAM_READ);
+	ILI9341_WRX_SET;
+	
+	/* First byte is dummy */
+	TM_SPI_Send(ILI9341_SPI, 0x00);
+	
+	/* Pixels are always read as 18-bit, 3 bytes with 6 bits per color */
+	while (n--) {
+		r = TM_SPI_Send(ILI9341_SPI, 0x00);
+		g = TM_SPI_Send(ILI9341_SPI, 0x00);
+		b = TM_SPI_Send(ILI9341_SPI, 0x00);
+		color = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+		*data++ = color >> 8;
+		*data++ = color & 0xFF;
+	}
+	ILI9341_CS_SET;
+	
+	/* Restore speed */
+	ILI9341_SPI->CR1 = cr1 & ~SPI_CR1_SPE;
+	ILI9341_SPI->CR1 = cr1;
+}
+
+void TM_ILI9341_SetScrollArea(uint16_t top, uint16_t height, uint16_t bottom) {
+	TM_ILI9341_SendCommand(ILI9341_VSCRDEF);
+	TM_ILI9341_SendData(top >> 8);
+	TM_ILI9341_SendData(top & 0xFF);
+	TM_ILI9341_SendData(height >> 8);
+	TM_ILI9341_SendData(height & 0xFF);
+	TM_ILI9341_SendData(bottom >> 8);
+	TM_ILI9341_SendData(bottom & 0xFF);
+}
+
+void TM_ILI9341_Scroll(uint16_t line) {
+	TM_ILI9341_SendCommand(ILI9341_VSCRSADD);
+	TM_ILI9341_SendData(line >> 8);
+	TM_ILI9341_SendData(line & 0xFF);
+}
+
 void TM_ILI9341_Fill(uint32_t color) {
-	unsigned int n, i, j;
-	i = color >> 8;
-	j = color & 0xFF;
-	TM_ILI9341_SetCursorPosition(0, 0, ILI9341_Opts.width - 1, ILI9341_Opts.height - 1);
+	/* Fill only clip area, which is whole screen by default */
+	TM_ILI9341_INT_FillWindow(ILI9341_Clip.x1, ILI9341_Clip.y1, ILI9341_Clip.x2, ILI9341_Clip.y2, color);
+}
 
-	TM_ILI9341_SendCommand(ILI9341_GRAM);
+void TM_ILI9341_SetClip(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+	/* Clip is never bigger than screen */
+	if (x2 >= ILI9341_Opts.width) {
+		x2 = ILI9341_Opts.width - 1;
+	}
+	if (y2 >= ILI9341_Opts.height) {
+		y2 = ILI9341_Opts.height - 1;
+	}
+	ILI9341_Clip.x1 = x1;
+	ILI9341_Clip.y1 = y1;
+	ILI9341_Clip.x2 = x2;
+	ILI9341_Clip.y2 = y2;
+}
+
+void TM_ILI9341_ResetClip(void) {
+	TM_ILI9341_SetClip(0, 0, ILI9341_Opts.width - 1, ILI9341_Opts.height - 1);
+}
+
+void TM_ILI9341_GetClip(TM_ILI9341_Clip_t* clip) {
+	*clip = ILI9341_Clip;
+}
+
+uint8_t TM_ILI9341_ClipVisible(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+	/* Empty clip, x1 > x2 or y1 > y2 */
+	if (ILI9341_Clip.x1 > ILI9341_Clip.x2 || ILI9341_Clip.y1 > ILI9341_Clip.y2) {
+		return 0;
+	}
+	if (x2 < (int16_t)ILI9341_Clip.x1 || x1 > (int16_t)ILI9341_Clip.x2 || y2 < (int16_t)ILI9341_Clip.y1 || y1 > (int16_t)ILI9341_Clip.y2) {
+		return 0;
+	}
+	return 1;
+}
+
+/* Private functions */
+void TM_ILI9341_INT_FillWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint32_t color) {
+	uint32_t n;
+	uint8_t hi = color >> 8, lo = color & 0xFF;
+	if (x1 > x2 || y1 > y2) {
+		return;
+	}
+	n = (uint32_t)(x2 - x1 + 1) * (y2 - y1 + 1);
+	
+	TM_ILI9341_SetWindow(x1, y1, x2, y2);
+	
+	/* Keep CS low for whole area */
+	ILI9341_WRX_SET;
+	ILI9341_CS_RESET;
+	while (n--) {
+		TM_SPI_Send(ILI9341_SPI, hi);
+		TM_SPI_Send(ILI9341_SPI, lo);
+	}
+	ILI9341_CS_SET;
+}
 
-	for (n = 0; n < ILI9341_PIXEL; n++) {
-		TM_ILI9341_SendData(i);
-		TM_ILI9341_SendData(j);
+void TM_ILI9341_INT_FillRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color) {
+	int16_t tmp;
+	/* Corners can be in any order */
+	if (x0 > x1) {
+		tmp = x0; x0 = x1; x1 = tmp;
 	}
+	if (y0 > y1) {
+		tmp = y0; y0 = y1; y1 = tmp;
+	}
+	/* Trivial reject */
+	if (!TM_ILI9341_ClipVisible(x0, y0, x1, y1)) {
+		return;
+	}
+	/* Clip */
+	if (x0 < (int16_t)ILI9341_Clip.x1) {
+		x0 = ILI9341_Clip.x1;
+	}
+	if (y0 < (int16_t)ILI9341_Clip.y1) {
+		y0 = ILI9341_Clip.y1;
+	}
+	if (x1 > (int16_t)ILI9341_Clip.x2) {
+		x1 = ILI9341_Clip.x2;
+	}
+	if (y1 > (int16_t)ILI9341_Clip.y2) {
+		y1 = ILI9341_Clip.y2;
+	}
+	TM_ILI9341_INT_FillWindow(x0, y0, x1, y1, color);
+}
+
+void TM_ILI9341_INT_DrawPixel(int16_t x, int16_t y, uint32_t color) {
+	/* Negative coordinates would wrap around in TM_ILI9341_DrawPixel */
+	if (x < 0 || y < 0) {
+		return;
+	}
+	TM_ILI9341_DrawPixel(x, y, color);
 }
 
 void TM_ILI9341_Delay(volatile unsigned int delay) {
@@ -249,6 +508,9 @@ void TM_ILI9341_Rotate(TM_ILI9341_Orientation_t orientation) {
 		ILI9341_Opts.height = ILI9341_WIDTH;
 		ILI9341_Opts.orientation = TM_ILI9341_Landscape;
 	}
+	
+	/* Reset clip to new screen size */
+	TM_ILI9341_ResetClip();
 }
 
 void TM_ILI9341_Puts(uint16_t x, uint16_t y, char *str, TM_FontDef_t *font, uint32_t foreground, uint32_t background) {
@@ -290,22 +552,51 @@ void TM_ILI9341_GetStringSize(char *str, TM_FontDef_t *font, uint16_t *width, ui
 }
 
 void TM_ILI9341_Putc(uint16_t x, uint16_t y, char c, TM_FontDef_t *font, uint32_t foreground, uint32_t background) {
-	uint32_t i, b, j;
+	uint32_t i, b, j, color;
+	uint16_t x2 = x + font->FontWidth - 1;
+	uint16_t y2 = y + font->FontHeight - 1;
+	
 	/* Set coordinates */
 	ILI9341_x = x;
 	ILI9341_y = y;
-	if ((ILI9341_x + font->FontWidth) > ILI9341_Opts.width) {
-		//If at the end of a line of display, go to new line and set x to 0 position
-		ILI9341_y += font->FontHeight;
-		ILI9341_x = 0;
-	}
-	for (i = 0; i < font->FontHeight; i++) {
-		b = font->data[(c - 32) * font->FontHeight + i];
-		for (j = 0; j < font->FontWidth; j++) {
-			if ((b << j) & 0x8000) {
-				TM_ILI9341_DrawPixel(ILI9341_x + j, (ILI9341_y + i), foreground);
-			} else if ((background & ILI9341_TRANSPARENT) == 0) {
-				TM_ILI9341_DrawPixel(ILI9341_x + j, (ILI9341_y + i), background);
+	
+	/* Only printable characters are in font */
+	if (c < ' ' || c > '~') {
+		c = ' ';
+	}
+	
+	/* Character is not visible, nothing to send */
+	if (!TM_ILI9341_ClipVisible(x, y, x2, y2)) {
+		ILI9341_x += font->FontWidth;
+		return;
+	}
+	
+	if ((background & ILI9341_TRANSPARENT) == 0 &&
+		x >= ILI9341_Clip.x1 && x2 <= ILI9341_Clip.x2 && y >= ILI9341_Clip.y1 && y2 <= ILI9341_Clip.y2
+	) {
+		/* Whole character inside clip, send it in one window */
+		TM_ILI9341_SetWindow(x, y, x2, y2);
+		ILI9341_WRX_SET;
+		ILI9341_CS_RESET;
+		for (i = 0; i < font->FontHeight; i++) {
+			b = font->data[(c - 32) * font->FontHeight + i];
+			for (j = 0; j < font->FontWidth; j++) {
+				color = ((b << j) & 0x8000) ? foreground : background;
+				TM_SPI_Send(ILI9341_SPI, color >> 8);
+				TM_SPI_Send(ILI9341_SPI, color & 0xFF);
+			}
+		}
+		ILI9341_CS_SET;
+	} else {
+		/* Pixel by pixel, TM_ILI9341_DrawPixel checks clip */
+		for (i = 0; i < font->FontHeight; i++) {
+			b = font->data[(c - 32) * font->FontHeight + i];
+			for (j = 0; j < font->FontWidth; j++) {
+				if ((b << j) & 0x8000) {
+					TM_ILI9341_DrawPixel(ILI9341_x + j, (ILI9341_y + i), foreground);
+				} else if ((background & ILI9341_TRANSPARENT) == 0) {
+					TM_ILI9341_DrawPixel(ILI9341_x + j, (ILI9341_y + i), background);
+				}
 			}
 		}
 	}
@@ -318,18 +609,15 @@ void TM_ILI9341_DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uin
 	
 	int16_t dx, dy, sx, sy, err, e2; 
 	
-	/* Check for overflow */
-	if (x0 >= ILI9341_Opts.width) {
-		x0 = ILI9341_Opts.width - 1;
-	}
-	if (x1 >= ILI9341_Opts.width) {
-		x1 = ILI9341_Opts.width - 1;
+	/* Horizontal and vertical lines are clipped and sent in one window */
+	if (x0 == x1 || y0 == y1) {
+		TM_ILI9341_INT_FillRect(x0, y0, x1, y1, color);
+		return;
 	}
-	if (y0 >= ILI9341_Opts.height) {
-		y0 = ILI9341_Opts.height - 1;
-	}
-	if (y1 >= ILI9341_Opts.height) {
-		y1 = ILI9341_Opts.height - 1;
+	
+	/* Trivial reject, pixels are clipped one by one in TM_ILI9341_DrawPixel */
+	if (!TM_ILI9341_ClipVisible(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0)) {
+		return;
 	}
 	
 	dx = (x0 < x1) ? (x1 - x0) : (x0 - x1); 
@@ -363,9 +651,11 @@ void TM_ILI9341_DrawRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1
 }
 
 void TM_ILI9341_DrawFilledRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint32_t color) {
-	for (; y0 < y1; y0++) {
-		TM_ILI9341_DrawLine(x0, y0, x1, y0, color);
+	/* Last row (y1) is not filled */
+	if (y0 >= y1) {
+		return;
 	}
+	TM_ILI9341_INT_FillRect(x0, y0, x1, y1 - 1, color);
 }
 
 void TM_ILI9341_DrawCircle(int16_t x0, int16_t y0, int16_t r, uint32_t color) {
@@ -374,11 +664,16 @@ void TM_ILI9341_DrawCircle(int16_t x0, int16_t y0, int16_t r, uint32_t color) {
 	int16_t ddF_y = -2 * r;
 	int16_t x = 0;
 	int16_t y = r;
+	
+	/* Trivial reject */
+	if (!TM_ILI9341_ClipVisible(x0 - r, y0 - r, x0 + r, y0 + r)) {
+		return;
+	}
 
-    TM_ILI9341_DrawPixel(x0, y0 + r, color);
-    TM_ILI9341_DrawPixel(x0, y0 - r, color);
-    TM_ILI9341_DrawPixel(x0 + r, y0, color);
-    TM_ILI9341_DrawPixel(x0 - r, y0, color);
+    TM_ILI9341_INT_DrawPixel(x0, y0 + r, color);
+    TM_ILI9341_INT_DrawPixel(x0, y0 - r, color);
+    TM_ILI9341_INT_DrawPixel(x0 + r, y0, color);
+    TM_ILI9341_INT_DrawPixel(x0 - r, y0, color);
 
     while (x < y) {
         if (f >= 0) {
@@ -390,15 +685,15 @@ void TM_ILI9341_DrawCircle(int16_t x0, int16_t y0, int16_t r, uint32_t color) {
         ddF_x += 2;
         f += ddF_x;
 
-        TM_ILI9341_DrawPixel(x0 + x, y0 + y, color);
-        TM_ILI9341_DrawPixel(x0 - x, y0 + y, color);
-        TM_ILI9341_DrawPixel(x0 + x, y0 - y, color);
-        TM_ILI9341_DrawPixel(x0 - x, y0 - y, color);
+        TM_ILI9341_INT_DrawPixel(x0 + x, y0 + y, color);
+        TM_ILI9341_INT_DrawPixel(x0 - x, y0 + y, color);
+        TM_ILI9341_INT_DrawPixel(x0 + x, y0 - y, color);
+        TM_ILI9341_INT_DrawPixel(x0 - x, y0 - y, color);
 
-        TM_ILI9341_DrawPixel(x0 + y, y0 + x, color);
-        TM_ILI9341_DrawPixel(x0 - y, y0 + x, color);
-        TM_ILI9341_DrawPixel(x0 + y, y0 - x, color);
-        TM_ILI9341_DrawPixel(x0 - y, y0 - x, color);
+        TM_ILI9341_INT_DrawPixel(x0 + y, y0 + x, color);
+        TM_ILI9341_INT_DrawPixel(x0 - y, y0 + x, color);
+        TM_ILI9341_INT_DrawPixel(x0 + y, y0 - x, color);
+        TM_ILI9341_INT_DrawPixel(x0 - y, y0 - x, color);
     }
 }
 
@@ -408,12 +703,17 @@ void TM_ILI9341_DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint32_t col
 	int16_t ddF_y = -2 * r;
 	int16_t x = 0;
 	int16_t y = r;
+	
+	/* Trivial reject */
+	if (!TM_ILI9341_ClipVisible(x0 - r, y0 - r, x0 + r, y0 + r)) {
+		return;
+	}
 
-    TM_ILI9341_DrawPixel(x0, y0 + r, color);
-    TM_ILI9341_DrawPixel(x0, y0 - r, color);
-    TM_ILI9341_DrawPixel(x0 + r, y0, color);
-    TM_ILI9341_DrawPixel(x0 - r, y0, color);
-    TM_ILI9341_DrawLine(x0 - r, y0, x0 + r, y0, color);
+    TM_ILI9341_INT_DrawPixel(x0, y0 + r, color);
+    TM_ILI9341_INT_DrawPixel(x0, y0 - r, color);
+    TM_ILI9341_INT_DrawPixel(x0 + r, y0, color);
+    TM_ILI9341_INT_DrawPixel(x0 - r, y0, color);
+    TM_ILI9341_INT_FillRect(x0 - r, y0, x0 + r, y0, color);
 
     while (x < y) {
         if (f >= 0) {
@@ -425,11 +725,11 @@ void TM_ILI9341_DrawFilledCircle(int16_t x0, int16_t y0, int16_t r, uint32_t col
         ddF_x += 2;
         f += ddF_x;
 
-        TM_ILI9341_DrawLine(x0 - x, y0 + y, x0 + x, y0 + y, color);
-        TM_ILI9341_DrawLine(x0 + x, y0 - y, x0 - x, y0 - y, color);
+        TM_ILI9341_INT_FillRect(x0 - x, y0 + y, x0 + x, y0 + y, color);
+        TM_ILI9341_INT_FillRect(x0 + x, y0 - y, x0 - x, y0 - y, color);
 
-        TM_ILI9341_DrawLine(x0 + y, y0 + x, x0 - y, y0 + x, color);
-        TM_ILI9341_DrawLine(x0 + y, y0 - x, x0 - y, y0 - x, color);
+        TM_ILI9341_INT_FillRect(x0 + y, y0 + x, x0 - y, y0 + x, color);
+        TM_ILI9341_INT_FillRect(x0 + y, y0 - x, x0 - y, y0 - x, color);
     }
 }
 //Test function
@@ -81,6 +81,7 @@
  * - STM32F4xx RCC
  * - STM32F4xx GPIO
  * - STM32F4xx SPI
+ * - STM32F4xx DMA (only if ILI9341_USE_DMA is enabled)
  * - defines.h
  * - TM SPI
  * - TM FONTS
@@ -93,6 +94,7 @@
 #include "stm32f4xx.h"
 #include "stm32f4xx_rcc.h"
 #include "stm32f4xx_gpio.h"
+#include "stm32f4xx_dma.h"
 #include "defines.h"
 #include "tm_stm32f4_spi.h"
 #include "tm_stm32f4_fonts.h"
@@ -123,6 +125,26 @@
 #define ILI9341_RST_PIN				GPIO_PIN_12
 #endif
 
+/* DMA for pixel streams, disabled by default */
+/* To enable it, set stream and channel for your ILI9341_SPI TX in defines.h file */
+/* For example, SPI1 TX:
+ *	#define ILI9341_USE_DMA				1
+ *	#define ILI9341_DMA_CLK				RCC_AHB1Periph_DMA2
+ *	#define ILI9341_DMA_STREAM			DMA2_Stream3
+ *	#define ILI9341_DMA_CHANNEL			DMA_Channel_3
+ *	#define ILI9341_DMA_FLAG_TC			DMA_FLAG_TCIF3
+ *	#define ILI9341_DMA_FLAGS			(DMA_FLAG_TCIF3 | DMA_FLAG_HTIF3 | DMA_FLAG_TEIF3 | DMA_FLAG_DMEIF3 | DMA_FLAG_FEIF3)
+ */
+#ifndef ILI9341_USE_DMA
+#define ILI9341_USE_DMA				0
+#endif
+
+/* SPI prescaler for reading GRAM, LCD can not be read as fast as written (max ~6MHz) */
+/* SPI MISO pin must be connected to LCD SDO pin for TM_ILI9341_ReadArea */
+#ifndef ILI9341_READ_PRESCALER
+#define ILI9341_READ_PRESCALER		SPI_BaudRatePrescaler_16
+#endif
+
 /* Pin definitions */
 #define ILI9341_RST_SET				GPIO_SetBits(ILI9341_RST_PORT, ILI9341_RST_PIN)
 #define ILI9341_RST_RESET			GPIO_ResetBits(ILI9341_RST_PORT, ILI9341_RST_PIN)
@@ -163,6 +185,9 @@
 #define ILI9341_COLUMN_ADDR			0x2A
 #define ILI9341_PAGE_ADDR			0x2B
 #define ILI9341_GRAM				0x2C
+#define ILI9341_GRAM_READ			0x2E
+#define ILI9341_VSCRDEF				0x33
+#define ILI9341_VSCRSADD			0x37
 #define ILI9341_MAC					0x36
 #define ILI9341_PIXEL_FORMAT		0x3A
 #define ILI9341_WDB					0x51
@@ -217,6 +242,31 @@ typedef struct {
 	TM_ILI9341_Orientation orientation; // 1 = portrait; 0 = landscape
 } TM_ILI931_Options_t;
 
+/**
+ * Clip rectangle
+ * All drawing functions draw only pixels inside, coordinates are inclusive
+ */
+typedef struct {
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;
+	uint16_t y2;
+} TM_ILI9341_Clip_t;
+
+/**
+ * Transfer counters, only incremented by driver
+ */
+typedef struct {
+	uint32_t commands;		/* Command bytes */
+	uint32_t data;				/* Data bytes sent by CPU */
+	uint32_t dma;					/* DMA transfers */
+	uint32_t dma_data;		/* Bytes sent by DMA */
+	uint32_t windows;			/* Windows set for writing */
+	uint32_t read;				/* Pixels read */
+} TM_ILI9341_Counters_t;
+
+extern TM_ILI9341_Counters_t ILI9341_Counters;
+
 
 /**
  * Select font
@@ -242,7 +292,7 @@ extern void TM_ILI9341_Init(void);
 extern void TM_ILI9341_DrawPixel(uint16_t x, uint16_t y, uint32_t color);
 
 /**
- * Fill entire LCD with color
+ * Fill entire LCD (or clip rectangle, if set) with color
  *
  * Parameters:
  * 	- uint32_t color: Color to be used in fill
@@ -370,6 +420,132 @@ extern void TM_ILI9341_DisplayOn(void);
  */
 extern void TM_ILI9341_DisplayOff(void);
 
+/**
+ * Set drawing window and start memory write
+ * After this call, pixels can be sent with TM_ILI9341_WriteData or TM_ILI9341_WriteDataDMA.
+ * Pixels are written left to right, top to bottom inside window.
+ *
+ * Parameters:
+ * - uint16_t x1: X coordinate of top left point
+ * - uint16_t y1: Y coordinate of top left point
+ * - uint16_t x2: X coordinate of bottom right point
+ * - uint16_t y2: Y coordinate of bottom right point
+ */
+extern void TM_ILI9341_SetWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+
+/**
+ * Send pixel data to window set with TM_ILI9341_SetWindow
+ * CS is held low for whole buffer, 2 bytes per pixel, high byte first
+ *
+ * Parameters:
+ * - uint8_t* data: pointer to pixel data
+ * - uint32_t count: number of bytes
+ */
+extern void TM_ILI9341_WriteData(uint8_t* data, uint32_t count);
+
+/**
+ * Start sending pixel data to window with DMA and return immediately
+ * Buffer must not be changed until TM_ILI9341_WaitDMA returns.
+ * If ILI9341_USE_DMA is 0, data are sent with TM_ILI9341_WriteData
+ *
+ * Parameters:
+ * - uint8_t* data: pointer to pixel data
+ * - uint16_t count: number of bytes
+ */
+extern void TM_ILI9341_WriteDataDMA(uint8_t* data, uint16_t count);
+
+/**
+ * Wait for DMA transfer started with TM_ILI9341_WriteDataDMA to finish
+ */
+extern void TM_ILI9341_WaitDMA(void);
+
+/**
+ * Read pixels from LCD memory (GRAM)
+ * Data is saved in the same format as for TM_ILI9341_WriteData,
+ * so area can be restored with TM_ILI9341_SetWindow and TM_ILI9341_WriteData.
+ *
+ * Parameters:
+ * - uint16_t x1: X coordinate of top left point
+ * - uint16_t y1: Y coordinate of top left point
+ * - uint16_t x2: X coordinate of bottom right point
+ * - uint16_t y2: Y coordinate of bottom right point
+ * - uint8_t* data: pointer to buffer, (x2 - x1 + 1) * (y2 - y1 + 1) * 2 bytes
+ */
+extern void TM_ILI9341_ReadArea(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t* data);
+
+/**
+ * Define vertical scrolling area
+ * Works along 320 pixels side (portrait orientation).
+ * Sum of all 3 parameters must be ILI9341_HEIGHT.
+ *
+ * Parameters:
+ * - uint16_t top: number of fixed lines on top
+ * - uint16_t height: number of lines in scrolling area
+ * - uint16_t bottom: number of fixed lines on bottom
+ */
+extern void TM_ILI9341_SetScrollArea(uint16_t top, uint16_t height, uint16_t bottom);
+
+/**
+ * Set line in LCD memory which is shown on top of scrolling area
+ * Drawing functions still use LCD memory coordinates.
+ * Use TM_ILI9341_SetScrollArea(0, ILI9341_HEIGHT, 0) and TM_ILI9341_Scroll(0) to disable scrolling.
+ *
+ * Parameters:
+ * - uint16_t line: memory line, between top and top + height - 1
+ */
+extern void TM_ILI9341_Scroll(uint16_t line);
+
+/**
+ * Set clip rectangle
+ * Pixels outside are not drawn by any drawing function.
+ * Clip is limited to screen size and is reset to whole screen on init and rotate.
+ * Functions for pixel streams (TM_ILI9341_SetWindow, TM_ILI9341_WriteData) ignore clip.
+ *
+ * Parameters:
+ * - uint16_t x1: X coordinate of top left point
+ * - uint16_t y1: Y coordinate of top left point
+ * - uint16_t x2: X coordinate of bottom right point
+ * - uint16_t y2: Y coordinate of bottom right point
+ */
+extern void TM_ILI9341_SetClip(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+
+/**
+ * Reset clip rectangle to whole screen
+ */
+extern void TM_ILI9341_ResetClip(void);
+
+/**
+ * Get current clip rectangle
+ *
+ * Parameters:
+ * - TM_ILI9341_Clip_t* clip: pointer to structure where clip will be saved
+ */
+extern void TM_ILI9341_GetClip(TM_ILI9341_Clip_t* clip);
+
+/**
+ * Check if any part of rectangle is inside clip
+ * Can be used to skip drawing of hidden objects
+ *
+ * Parameters:
+ * - int16_t x1: X coordinate of top left point
+ * - int16_t y1: Y coordinate of top left point
+ * - int16_t x2: X coordinate of bottom right point
+ * - int16_t y2: Y coordinate of bottom right point
+ *
+ * Returns 1 if visible, 0 otherwise
+ */
+extern uint8_t TM_ILI9341_ClipVisible(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+
+/**
+ * Set function which is called with every window that will be written
+ * Can be used to track changed areas of screen (for example for screen streaming).
+ * Window is in LCD memory coordinates, reading does not call it.
+ *
+ * Parameters:
+ * - callback: function, NULL to disable
+ */
+extern void TM_ILI9341_SetDamageCallback(void (*callback)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2));
+
 extern void TM_ILI9341_SendCommand2(uint8_t data);
 
 #endif
@@ -0,0 +1,25 @@
+/*
+ * Host configuration of TM FatFs for fatfs_bench.c, used instead of Project/User/defines.h.
+ * SD card and USB drivers are not built, volumes are RAM disk ("2:") and disk image file ("3:").
+ */
+#ifndef TM_DEFINES_H
+#define TM_DEFINES_H
+
+#define FATFS_USE_SDIO				2
+#define FATFS_USE_USB				0
+#define FATFS_USE_RAM				1
+#define FATFS_USE_IMAGE				1
+#define FATFS_WORKER_ENABLED		0
+
+/* Compare with -DFATFS_CACHE_ENABLED=0, -DFATFS_CACHE_SETS=... */
+#ifndef FATFS_CACHE_ENABLED
+#define FATFS_CACHE_ENABLED			1
+#endif
+#ifndef FATFS_CACHE_SETS
+#define FATFS_CACHE_SETS			8
+#endif
+#ifndef FATFS_CACHE_WAYS
+#define FATFS_CACHE_WAYS			4
+#endif
+
+#endif
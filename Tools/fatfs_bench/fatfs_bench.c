@@ -0,0 +1,275 @@
+/*
+ * FatFs benchmark on host, TM/fatfs with RAM disk or disk image file backend.
+ * Counts driver commands and sectors per operation, so effect of sector cache, multi sector
+ * transfers or fast seek can be seen before it is flashed. Times are host times, only for comparison.
+ *
+ * Build (from repository root):
+ *	gcc -O2 -DFATFS_HOST -ITools/fatfs_bench -ITM/fatfs -ITM/fatfs/drivers -ITM -o fatfs_bench \
+ *		Tools/fatfs_bench/fatfs_bench.c TM/fatfs/ff.c TM/fatfs/diskio.c TM/fatfs/option/ccsbcs.c TM/fatfs/option/syscall.c \
+ *		TM/fatfs/drivers/fatfs_ram.c TM/fatfs/drivers/fatfs_image.c TM/tm_stm32f4_fatfs.c
+ * Add -DFATFS_CACHE_ENABLED=0 to compare without sector cache.
+ *
+ * Usage:
+ *	fatfs_bench [-m MB] [-s file_MB] [-i image [-f]]
+ *	-m	RAM disk size (default 16)
+ *	-s	size of sequential test file (default 4)
+ *	-i	use disk image file instead of RAM disk, it is formatted if it can not be mounted or with -f
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff.h"
+#include "diskio.h"
+#include "fatfs_ram.h"
+#include "fatfs_image.h"
+#include "tm_stm32f4_fatfs.h"
+
+#define BENCH_CHUNK			4096
+#define BENCH_SMALL			100			/* Read size smaller than sector, FIL buffer and cache */
+#define BENCH_RANDOM		2000
+#define BENCH_FILES			200
+#define BENCH_FILES_BIG		3000		/* 8.3 names, near the limit of directory index with _DIRINDEX_MAX 4096 */
+#define BENCH_FILES_LONG	1500		/* Long names */
+#define BENCH_WALKS			200
+#define BENCH_RING_SIZE		(64*1024)
+#define BENCH_TRUNCATE		(256*1024)
+
+static FATFS bench_fs;
+static FIL bench_file;
+static BYTE bench_buffer[BENCH_CHUNK];
+static DWORD bench_table[64];
+static const char* bench_volume;
+static char bench_path[64];
+static struct timespec bench_started;
+
+static const char* bench_name(const char* name) {
+	snprintf(bench_path, sizeof(bench_path), "%s%s", bench_volume, name);
+	return bench_path;
+}
+
+static void bench_start(void) {
+	memset(&disk_cache_stats, 0, sizeof(disk_cache_stats));
+	clock_gettime(CLOCK_MONOTONIC, &bench_started);
+}
+
+/* Counters of test divided by operations */
+static void bench_stop(const char* name, unsigned long ops, unsigned long bytes) {
+	struct timespec now;
+	double us, lookups;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	us = (now.tv_sec - bench_started.tv_sec) * 1e6 + (now.tv_nsec - bench_started.tv_nsec) / 1e3;
+	lookups = (double)disk_cache_stats.hits + disk_cache_stats.misses;
+	printf("%-22s %7lu %9.2f %8.2f %8.2f %8.2f %8.2f %6.1f", name, ops, us / ops,
+		(double)disk_cache_stats.reads / ops, (double)disk_cache_stats.read_sectors / ops,
+		(double)disk_cache_stats.writes / ops, (double)disk_cache_stats.write_sectors / ops,
+		lookups > 0 ? disk_cache_stats.hits * 100.0 / lookups : 0.0);
+	if (bytes && us > 0) {
+		printf(" %8.1f", bytes / us);
+	}
+	printf("\n");
+}
+
+static void bench_check(FRESULT fr, const char* what) {
+	if (fr != FR_OK) {
+		fprintf(stderr, "%s failed: %d\n", what, (int)fr);
+		exit(1);
+	}
+}
+
+static void bench_sequential(DWORD size) {
+	UINT done;
+	DWORD left;
+	unsigned long ops;
+
+	memset(bench_buffer, 0x5A, sizeof(bench_buffer));
+	bench_start();
+	bench_check(f_open(&bench_file, bench_name("SEQ.BIN"), FA_WRITE | FA_CREATE_ALWAYS), "open");
+	for (left = size, ops = 0; left > 0; left -= done, ops++) {
+		bench_check(f_write(&bench_file, bench_buffer, left < BENCH_CHUNK ? left : BENCH_CHUNK, &done), "write");
+	}
+	bench_check(f_close(&bench_file), "close");
+	bench_stop("sequential write 4K", ops, size);
+
+	bench_start();
+	bench_check(f_open(&bench_file, bench_name("SEQ.BIN"), FA_READ | FA_OPEN_EXISTING), "open");
+	for (ops = 0; f_read(&bench_file, bench_buffer, BENCH_CHUNK, &done) == FR_OK && done > 0; ops++);
+	f_close(&bench_file);
+	bench_stop("sequential read 4K", ops, size);
+
+	bench_start();
+	bench_check(f_open(&bench_file, bench_name("SEQ.BIN"), FA_READ | FA_OPEN_EXISTING), "open");
+	for (ops = 0; f_read(&bench_file, bench_buffer, BENCH_SMALL, &done) == FR_OK && done > 0; ops++);
+	f_close(&bench_file);
+	bench_stop("sequential read 100", ops, size);
+}
+
+static void bench_random(DWORD size, BYTE fast, BYTE write) {
+	UINT done;
+	unsigned long i;
+
+	srand(1);
+	bench_check(f_open(&bench_file, bench_name("SEQ.BIN"), FA_READ | FA_WRITE | FA_OPEN_EXISTING), "open");
+	if (fast) {
+		bench_check(TM_FATFS_FastSeek(&bench_file, bench_table, sizeof(bench_table) / sizeof(bench_table[0])), "fast seek");
+	}
+	bench_start();
+	for (i = 0; i < BENCH_RANDOM; i++) {
+		bench_check(f_lseek(&bench_file, (DWORD)rand() % (size - 512)), "seek");
+		if (write) {
+			bench_check(f_write(&bench_file, bench_buffer, 512, &done), "write");
+		} else {
+			bench_check(f_read(&bench_file, bench_buffer, 512, &done), "read");
+		}
+	}
+	bench_check(f_close(&bench_file), "close");
+	bench_stop(write ? (fast ? "random write 512 fast" : "random write 512") : (fast ? "random read 512 fast" : "random read 512"),
+		BENCH_RANDOM, (unsigned long)BENCH_RANDOM * 512);
+}
+
+/* Lookups in a directory of files named by format with file number, index of the directory is built by first one */
+static void bench_directory(const char* format, int files) {
+	FILINFO info;
+	char name[48], title[48];
+	int i;
+
+	snprintf(name, sizeof(name), format, 0);
+	*strchr(name, '/') = 0;
+	f_mkdir(bench_name(name));
+	for (i = 0; i < files; i++) {
+		snprintf(name, sizeof(name), format, i);
+		bench_check(f_open(&bench_file, bench_name(name), FA_WRITE | FA_CREATE_ALWAYS), "create");
+		f_close(&bench_file);
+	}
+	disk_ioctl(bench_fs.drv, CTRL_SYNC, 0);
+
+	bench_start();
+	for (i = 0; i < files; i++) {
+		snprintf(name, sizeof(name), format, (i * 7) % files);
+		info.lfname = 0;
+		bench_check(f_stat(bench_name(name), &info), "stat");
+	}
+	snprintf(title, sizeof(title), "directory lookup %d", files);
+	bench_stop(title, files, 0);
+}
+
+/* Seek from start to end, normal seek follows FAT chain */
+static void bench_fat_walk(DWORD size, BYTE fast) {
+	int i;
+
+	bench_check(f_open(&bench_file, bench_name("SEQ.BIN"), FA_READ | FA_OPEN_EXISTING), "open");
+	if (fast) {
+		bench_check(TM_FATFS_FastSeek(&bench_file, bench_table, sizeof(bench_table) / sizeof(bench_table[0])), "fast seek");
+	}
+	bench_start();
+	for (i = 0; i < BENCH_WALKS; i++) {
+		bench_check(f_lseek(&bench_file, 0), "seek");
+		bench_check(f_lseek(&bench_file, size - 1), "seek");
+	}
+	f_close(&bench_file);
+	bench_stop(fast ? "FAT chain walk fast" : "FAT chain walk", BENCH_WALKS, 0);
+}
+
+/* Dropping oldest 512 bytes: ring moves offset, truncate copies rest of file */
+static void bench_trim(void) {
+	TM_FATFS_Ring_t ring;
+	UINT done;
+	DWORD left;
+	int i;
+
+	bench_check(TM_FATFS_RingOpen(&ring, bench_name("RING.BIN"), BENCH_RING_SIZE), "ring open");
+	bench_start();
+	for (i = 0; i < 4 * BENCH_RING_SIZE / 512; i++) {
+		bench_check(TM_FATFS_RingWrite(&ring, bench_buffer, 512), "ring write");
+	}
+	bench_check(TM_FATFS_RingClose(&ring), "ring close");
+	bench_stop("ring append 512", 4 * BENCH_RING_SIZE / 512, 4 * BENCH_RING_SIZE);
+
+	bench_check(f_open(&bench_file, bench_name("TRUNC.BIN"), FA_READ | FA_WRITE | FA_CREATE_ALWAYS), "open");
+	for (left = BENCH_TRUNCATE; left > 0; left -= done) {
+		bench_check(f_write(&bench_file, bench_buffer, BENCH_CHUNK, &done), "write");
+	}
+	bench_start();
+	for (i = 0; i < 8; i++) {
+		bench_check(TM_FATFS_TruncateBeginning(&bench_file, 512), "truncate");
+	}
+	f_close(&bench_file);
+	bench_stop("truncate beginning 512", 8, 0);
+}
+
+int main(int argc, char** argv) {
+	DWORD disk_mb = 16, file_mb = 4, size;
+	const char* image = 0;
+	BYTE format = 0;
+	BYTE* memory;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			disk_mb = atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			file_mb = atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+			image = argv[++i];
+		} else if (!strcmp(argv[i], "-f")) {
+			format = 1;
+		} else {
+			fprintf(stderr, "usage: %s [-m MB] [-s file_MB] [-i image [-f]]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (image) {
+		bench_volume = "3:";
+		if (TM_FATFS_IMAGE_Attach(image, format ? disk_mb * 2048 : 0) != 0) {
+			fprintf(stderr, "can not open %s\n", image);
+			return 1;
+		}
+	} else {
+		bench_volume = "2:";
+		memory = calloc(disk_mb, 1024 * 1024);
+		if (!memory) {
+			return 1;
+		}
+		TM_FATFS_RAM_Attach(memory, disk_mb * 2048);
+		format = 1;
+	}
+	if (!format && f_mount(&bench_fs, bench_volume, 1) != FR_OK) {
+		format = 1;
+	}
+	if (format) {
+		bench_check(f_mount(&bench_fs, bench_volume, 0), "mount");
+		bench_check(f_mkfs(bench_volume, 1, 0), "mkfs");
+		bench_check(f_mount(&bench_fs, bench_volume, 1), "mount");
+	}
+	size = file_mb * 1024 * 1024;
+
+	printf("cache %s", FATFS_CACHE_ENABLED ? "on" : "off");
+#if FATFS_CACHE_ENABLED == 1
+	printf(" (%d sets x %d ways)", FATFS_CACHE_SETS, FATFS_CACHE_WAYS);
+#endif
+	printf(", cluster %lu bytes\n\n", (unsigned long)bench_fs.csize * 512);
+	printf("%-22s %7s %9s %8s %8s %8s %8s %6s %8s\n", "test", "ops", "us/op", "rd cmd", "rd sect", "wr cmd", "wr sect", "hit %", "MB/s");
+
+	bench_sequential(size);
+	bench_random(size, 0, 0);
+	bench_random(size, 1, 0);
+	bench_random(size, 0, 1);
+	bench_directory("DIR/FILE%04d.TXT", BENCH_FILES);
+	bench_directory("BIG/FILE%04d.TXT", BENCH_FILES_BIG);
+	bench_directory("LONG/Long file name %04d.txt", BENCH_FILES_LONG);
+	bench_fat_walk(size, 0);
+	bench_fat_walk(size, 1);
+	bench_trim();
+
+	f_mount(0, bench_volume, 0);
+	if (image) {
+		TM_FATFS_IMAGE_Detach();
+	}
+	return 0;
+}
+
+/* No RTC on host, fixed time stamp */
+DWORD get_fattime(void) {
+	return ((DWORD)(2015 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
@@ -0,0 +1,142 @@
+"""Compressed code page table for FatFs DBCS code pages (TM/fatfs/option/cctable.c).
+
+Reads ChaN's table source (cc932.c, cc936.c, cc949.c or cc950.c) and writes
+table file for SD card, or C array for flash with --c:
+
+    python fatfs_cptable.py TM/fatfs/option/cc932.c CP932.CPT
+    python fatfs_cptable.py TM/fatfs/option/cc932.c cc932t.c --c
+
+Format (little endian), both directions in 512 byte blocks:
+    header   "FCPT", WORD code page, WORD blocks Unicode->OEM, WORD blocks OEM->Unicode,
+             WORD first non-ASCII code, 4 reserved bytes
+    index    WORD first code of each block, Unicode->OEM blocks first
+    blocks   start at first 512 byte boundary after index
+
+Block is a list of runs of consecutive codes:
+    gap      codes skipped after previous run (from first code of block for first run),
+             1 byte < 0x80, else 2 bytes big endian with bit 15 set
+    count    b6-0 number of codes (gap and count 0 end block), b7 set: linear run, values are first value + i
+    values   1 WORD for linear run, count WORDs otherwise
+"""
+
+import re
+import struct
+import sys
+
+MAGIC = b"FCPT"
+BLOCK = 512
+RUN_MAX = 127
+LINEAR_MIN = 3
+
+
+def parse(name):
+    with open(name, encoding="latin-1") as f:
+        text = f.read()
+    page = int(re.search(r"_CODE_PAGE != (\d+)", text).group(1))
+    ascii_end = 0x81 if re.search(r"if \(chr <= 0x80\)", text) else 0x80
+    tables = []
+    for match in re.finditer(r"const WCHAR (uni2\w+|\w+2uni)\[\] = \{(.*?)\};", text, re.S):
+        body = re.sub(r"/\*.*?\*/", "", match.group(2), flags=re.S)
+        values = [int(v, 0) for v in re.findall(r"0x[0-9A-Fa-f]+|\b\d+\b", body)]
+        pairs = {}
+        for i in range(0, len(values) - 1, 2):
+            if values[i] or values[i + 1]:
+                pairs.setdefault(values[i], values[i + 1])  # Code twice in cc950.c, first one is used
+        tables.append((match.group(1), sorted(pairs.items())))
+    tables.sort(key=lambda table: not table[0].startswith("uni2"))  # Unicode->OEM first
+    return page, ascii_end, [table[1] for table in tables]
+
+
+def runs(pairs):
+    """Runs (first code, linear, values, count) of consecutive codes."""
+    result = []
+    literal = []
+
+    def flush(code):
+        if literal:
+            result.append((code - len(literal), False, list(literal), len(literal)))
+            del literal[:]
+
+    for i, (code, value) in enumerate(pairs):
+        if i and code != pairs[i - 1][0] + 1:
+            flush(pairs[i - 1][0] + 1)
+        if result and not literal and result[-1][1] and code == result[-1][0] + result[-1][3] and \
+                value == result[-1][2][0] + result[-1][3] and result[-1][3] < RUN_MAX:
+            result[-1] = result[-1][:3] + (result[-1][3] + 1,)
+            continue
+        literal.append(value)
+        # Values of last codes are linear, they become linear run
+        n = len(literal)
+        if n >= LINEAR_MIN and all(pairs[i - k][0] == code - k and literal[n - 1 - k] == value - k for k in range(LINEAR_MIN)):
+            del literal[n - LINEAR_MIN:]
+            flush(code - LINEAR_MIN + 1)
+            result.append((code - LINEAR_MIN + 1, True, [value - LINEAR_MIN + 1], LINEAR_MIN))
+        elif n == RUN_MAX:
+            flush(code + 1)
+    flush(pairs[-1][0] + 1)
+    return result
+
+
+def encode_run(gap, run):
+    first, linear, values, count = run
+    data = bytes([gap]) if gap < 0x80 else struct.pack(">H", gap | 0x8000)
+    data += bytes([count | (0x80 if linear else 0)])
+    return data + b"".join(struct.pack("<H", value) for value in values)
+
+
+def blocks(pairs):
+    """List of (first code, block data)."""
+    result = []
+    data = b""
+    first = None
+    for run in runs(pairs):
+        if first is not None:
+            gap = run[0] - expected
+            size = len(data) + len(encode_run(gap, run))
+            if gap >= 0x8000 or (size > BLOCK - 2 and size != BLOCK):  # Full block or 2 bytes for end
+                result.append((first, data))
+                first = None
+            else:
+                data += encode_run(gap, run)
+        if first is None:
+            first = run[0]
+            data = encode_run(0, run)
+        expected = run[0] + run[3]
+    if first is not None:
+        result.append((first, data))
+    return [(code, data + b"\0" * (BLOCK - len(data))) for code, data in result]
+
+
+def build(name):
+    page, ascii_end, tables = parse(name)
+    directions = [blocks(pairs) for pairs in tables]
+    index = b"".join(struct.pack("<H", code) for direction in directions for code, _ in direction)
+    header = MAGIC + struct.pack("<HHHH", page, len(directions[0]), len(directions[1]), ascii_end) + b"\0" * 4
+    head = header + index
+    head += b"\0" * (-len(head) % BLOCK)
+    return page, head + b"".join(data for direction in directions for _, data in direction), tables
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        return 1
+    page, table, pairs = build(sys.argv[1])
+    if "--c" in sys.argv[3:]:
+        with open(sys.argv[2], "w") as f:
+            f.write("/* CP%d table for option/cctable.c, made by Tools/fatfs_cptable.py */\n\n" % page)
+            f.write('#include "ff.h"\n\n')
+            f.write("const BYTE ff_cptable_cp%d[%d] = {\n" % (page, len(table)))
+            for i in range(0, len(table), 16):
+                f.write("\t" + ", ".join("0x%02X" % b for b in table[i:i + 16]) + ",\n")
+            f.write("};\n")
+    else:
+        with open(sys.argv[2], "wb") as f:
+            f.write(table)
+    original = sum(len(direction) * 4 for direction in pairs)
+    print("CP%d: %d bytes, %d in original tables" % (page, len(table), original))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,186 @@
+"""Decoder for deferred binary log (Menu/menu_log.h).
+
+Records carry only format string address and raw arguments, strings are
+read from the .axf (ELF) file which was flashed.
+
+    python log_decode.py LCD_menu.axf remote /dev/ttyUSB0
+    python log_decode.py LCD_menu.axf swo trace.bin     (raw SWO/ITM capture)
+    python log_decode.py LCD_menu.axf file LOG/L0000003.BIN LOG/L0000004.BIN...
+    python log_decode.py LCD_menu.axf file LOG/RING.BIN  (ring file, Menu/menu_logfile.h)
+
+Output: time in ms (from DWT cycle counter), task, formatted text.
+"""
+
+import re
+import struct
+import sys
+
+MARKER = 0xFFFFFF00
+DROPPED = 1
+TASK = 2
+SWO_PORT = 1
+RING_MAGIC = 0x474E4952  # "RING", TM_FATFS_Ring_t (TM/tm_stm32f4_fatfs.h)
+RING_HEADER = 512
+CPU_HZ = 168000000
+
+
+class Elf(object):
+    """Only what is needed to read constant strings: loadable sections by address."""
+
+    def __init__(self, name):
+        with open(name, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("not 32-bit ELF file")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            name, kind, flags, address, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if kind == 1 and address:  # PROGBITS with address
+                self.sections.append((address, offset, size))
+
+    def string(self, address):
+        for start, offset, size in self.sections:
+            if start <= address < start + size:
+                begin = offset + address - start
+                end = self.data.index(b"\x00", begin)
+                return self.data[begin:end].decode("latin-1")
+        return None
+
+
+_CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l)?([diuxXcsp%])")
+
+
+def format_record(elf, text, arguments):
+    arguments = list(arguments)
+
+    def convert(match):
+        flags, kind = match.groups()
+        if kind == "%":
+            return "%"
+        value = arguments.pop(0) if arguments else 0
+        if kind in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            return ("%" + flags + "d") % value
+        if kind == "s":
+            return ("%" + flags + "s") % (elf.string(value) or "<0x%08x>" % value)
+        if kind == "c":
+            return chr(value & 0xFF)
+        if kind == "p":
+            return "0x%08x" % value
+        return ("%" + flags + kind) % value
+
+    return _CONVERSION.sub(convert, text)
+
+
+class Decoder(object):
+    def __init__(self, elf):
+        self.elf = elf
+        self.tasks = {}
+        self.ring = 0
+        self.pending = []
+        self.resync = False
+
+    def restart(self):
+        """Stream continues at unknown position (ring file tail): skip words up to next ring marker."""
+        self.pending = []
+        self.resync = True
+
+    def words(self, words):
+        """Feed 32-bit words, yields printed lines."""
+        self.pending.extend(words)
+        while self.pending:
+            header = self.pending[0]
+            if self.resync:
+                if header & 0xFFFFFF00 != MARKER:
+                    self.pending.pop(0)
+                    continue
+                self.resync = False
+            if header & 0xFFFFFF00 == MARKER:
+                self.ring = header & 0xFF
+                self.pending.pop(0)
+                continue
+            count = header >> 28
+            if len(self.pending) < count + 2:
+                return
+            record = self.pending[:count + 2]
+            del self.pending[:count + 2]
+            yield self.record(record[0] & 0x0FFFFFFF, record[1], record[2:])
+
+    def record(self, address, cycles, arguments):
+        time = "%10.3f" % (cycles * 1000.0 / CPU_HZ)
+        task = self.tasks.get(self.ring, "ring %d" % self.ring)
+        if address == TASK:
+            name = struct.pack("<4I", *arguments).split(b"\x00")[0].decode("latin-1")
+            self.tasks[self.ring] = name
+            return "%s %-16s registered" % (time, name)
+        if address == DROPPED:
+            return "%s %-16s %d records dropped" % (time, task, arguments[0])
+        text = self.elf.string(address)
+        if text is None:
+            return "%s %-16s unknown format 0x%08x %s" % (time, task, address, " ".join("%08x" % a for a in arguments))
+        return "%s %-16s %s" % (time, task, format_record(self.elf, text, arguments).rstrip("\r\n"))
+
+
+def swo_words(data, port=SWO_PORT):
+    """32-bit writes to stimulus port from raw ITM stream, other packets are skipped."""
+    i = 0
+    while i < len(data):
+        header = data[i]
+        i += 1
+        if header == 0x00 or header == 0x80 or header == 0x70:  # Sync, overflow
+            continue
+        size = header & 0x03
+        if size == 0:  # Timestamp and extension packets: continuation bit
+            if header & 0x80:
+                while i < len(data) and data[i] & 0x80:
+                    i += 1
+                i += 1
+            continue
+        length = 4 if size == 3 else size
+        if not header & 0x04 and header >> 3 == port and length == 4 and i + 4 <= len(data):
+            yield struct.unpack_from("<I", data, i)[0]
+        i += length
+
+
+def file_words(data):
+    """Words from log file: ring file is read from tail, rotation file as it is."""
+    if len(data) >= RING_HEADER and struct.unpack_from("<I", data, 0)[0] == RING_MAGIC:
+        magic, size, head, tail, used, sequence = struct.unpack_from("<6I", data, 0)
+        ring = data[RING_HEADER:RING_HEADER + size]
+        data = (ring[tail:] + ring[:tail])[:used]
+    data = data[:len(data) & ~3]
+    return struct.unpack("<%dI" % (len(data) // 4), data)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 4 or sys.argv[2] not in ("remote", "swo", "file"):
+        print("usage: log_decode.py FILE.axf remote PORT | swo FILE | file FILE...")
+        sys.exit(1)
+    decoder = Decoder(Elf(sys.argv[1]))
+    if sys.argv[2] == "file":
+        for name in sys.argv[3:]:
+            with open(name, "rb") as f:
+                data = f.read()
+            if data[:4] == struct.pack("<I", RING_MAGIC):
+                decoder.restart()  # Oldest sector was dropped in the middle of a record
+            for line in decoder.words(file_words(data)):
+                print(line)
+    elif sys.argv[2] == "swo":
+        with open(sys.argv[3], "rb") as f:
+            for line in decoder.words(list(swo_words(f.read()))):
+                print(line)
+    else:
+        import menu_remote
+        remote = menu_remote.MenuRemote(sys.argv[3])
+        try:
+            remote.ping()  # First frame switches link to binary mode, log is sent only then
+            while True:
+                for line in decoder.words(remote.log_words()):
+                    print(line)
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            remote.close()
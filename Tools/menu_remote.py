@@ -0,0 +1,322 @@
+"""PC side of menu remote control protocol (Menu/menu_remote.h).
+
+Frame: 0x00, COBS(payload + CRC32 little endian), 0x00
+Request payload: [command][sequence][arguments...]
+Reply payload:   [command | 0x80][sequence][status][data...]
+
+Requests are pipelined: send() does not wait, so many keys and touches
+can be in flight at once; wait() collects the reply for a sequence number.
+
+    remote = MenuRemote("/dev/ttyUSB0")
+    remote.keys("ssd")
+    print(remote.path())
+    pixels = remote.dump(0, 0, 239, 39)
+
+Needs pyserial.
+"""
+
+import struct
+import sys
+import time
+
+import serial
+
+PING = 0x01
+KEY = 0x02
+TOUCH = 0x03
+PATH = 0x04
+DUMP = 0x05
+MODE = 0x06
+STREAM = 0x07
+SCREEN = 0x08
+LOG = 0x09
+REPLY = 0x80
+
+OK = 0
+MORE = 1
+UNKNOWN = 2
+BAD_ARGUMENT = 3
+BUSY = 4
+
+TOUCH_LEFT, TOUCH_RIGHT, TOUCH_UP, TOUCH_DOWN, TOUCH_CLICK = range(5)
+
+BAUDRATE = 921600
+KEY_CHUNK = 32         # Keys in one KEY request
+KEY_BACKOFF = 0.02     # s, wait before rest of keys is sent again when menu queue is full
+KEY_STALL = 2.0        # s, menu queue took no key for so long
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        crc = i << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+        table.append(crc & 0xFFFFFFFF)
+    return table
+
+
+_TABLE = _crc_table()
+
+
+def crc32_stm32(data):
+    """STM32 CRC unit fed with every byte as one 32-bit word (TM_CRC_Calculate8)."""
+    crc = 0xFFFFFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(4):
+            crc = ((crc << 8) & 0xFFFFFFFF) ^ _TABLE[crc >> 24]
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_index] = code
+                code_index = len(out)
+                out.append(0)
+                code = 1
+    out[code_index] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def rle_decode(data):
+    """Screen stream runs to list of RGB565 pixels."""
+    pixels = []
+    i = 0
+    while i < len(data):
+        header = data[i]
+        n = (header & 0x7F) + 1
+        if header & 0x80:
+            pixels.extend([(data[i + 1] << 8) | data[i + 2]] * n)
+            i += 3
+        else:
+            pixels.extend(struct.unpack(">%dH" % n, data[i + 1:i + 1 + n * 2]))
+            i += 1 + n * 2
+    return pixels
+
+
+class RemoteError(Exception):
+    pass
+
+
+class MenuRemote(object):
+    def __init__(self, port, baudrate=BAUDRATE, timeout=2.0):
+        self.serial = serial.Serial(port, baudrate, timeout=timeout)
+        self.sequence = 0
+        self.buffer = bytearray()
+        self.replies = {}
+        self.screen = []
+        self.log = []
+        self.errors = 0
+        self.serial.write(b"\x00")  # End anything sent before
+
+    def close(self):
+        self.serial.close()
+
+    def send(self, command, arguments=b""):
+        """Send request without waiting, returns its sequence number."""
+        self.sequence = (self.sequence + 1) & 0xFF
+        payload = bytes([command, self.sequence]) + bytes(arguments)
+        payload += struct.pack("<I", crc32_stm32(payload))
+        self.serial.write(b"\x00" + cobs_encode(payload) + b"\x00")
+        return self.sequence
+
+    def _read_frame(self, wait=True):
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end >= 0:
+                frame = bytes(self.buffer[:end])
+                del self.buffer[:end + 1]
+                if not frame:
+                    continue
+                payload = cobs_decode(frame)
+                if payload is None or len(payload) < 7:
+                    self.errors += 1  # Text from other tasks or broken frame
+                    continue
+                body, crc = payload[:-4], struct.unpack("<I", payload[-4:])[0]
+                if crc32_stm32(body) != crc or not body[0] & REPLY:
+                    self.errors += 1
+                    continue
+                return body
+            if not wait:
+                return None
+            data = self.serial.read(max(1, self.serial.in_waiting))
+            if not data:
+                raise RemoteError("timeout")
+            self.buffer += data
+
+    def _receive(self, wait=True):
+        """Read one frame, messages which were not requested are kept apart from replies.
+        Without wait returns False if no whole frame is in buffer."""
+        body = self._read_frame(wait)
+        if body is None:
+            return False
+        if body[0] == SCREEN | REPLY:
+            self.screen.append((body[2], body[3:]))
+        elif body[0] == LOG | REPLY:
+            self.log.append(body[3:])
+        else:
+            self.replies.setdefault(body[1], []).append((body[2], body[3:]))
+        return True
+
+    def poll(self):
+        """Take frames which already arrived, does not wait."""
+        waiting = self.serial.in_waiting
+        if waiting:
+            self.buffer += self.serial.read(waiting)
+        while self._receive(False):
+            pass
+
+    def wait(self, sequence):
+        """Replies for sequence as list of (status, data), ends with first status other than MORE."""
+        while not self.replies.get(sequence) or self.replies[sequence][-1][0] == MORE:
+            self._receive()
+        return self.replies.pop(sequence)
+
+    def call(self, command, arguments=b""):
+        replies = self.wait(self.send(command, arguments))
+        status, data = replies[-1]
+        if status not in (OK, BUSY):
+            raise RemoteError("command 0x%02x failed with status %d" % (command, status))
+        return status, data, replies[:-1]
+
+    def ping(self):
+        status, data, _ = self.call(PING)
+        return struct.unpack("<BHH", data[:5])
+
+    def keys(self, keys, wait=True, stall=KEY_STALL):
+        """Queue keys (string or bytes), keeps sending until all are queued.
+        Chunks are sent one by one, rest of chunk which did not fit in menu queue (BUSY) is sent again.
+        RemoteError is raised when queue takes nothing for stall seconds.
+        With wait=False all chunks are sent at once and their sequence numbers are returned,
+        keys are not known to be queued then: see status of each reply with wait()."""
+        if isinstance(keys, str):
+            keys = keys.encode("latin-1")
+        if not wait:
+            return [self.send(KEY, keys[i:i + KEY_CHUNK]) for i in range(0, len(keys), KEY_CHUNK)]
+        sent = 0
+        last = time.time()
+        while sent < len(keys):
+            status, data, _ = self.call(KEY, keys[sent:sent + KEY_CHUNK])
+            queued = data[0] if data else 0
+            sent += queued
+            if queued:
+                last = time.time()
+            if status == BUSY:
+                if time.time() - last > stall:
+                    raise RemoteError("key queue is full, %d keys were not sent" % (len(keys) - sent))
+                time.sleep(KEY_BACKOFF)
+
+    def touch(self, gesture, x=0, y=0):
+        return self.call(TOUCH, struct.pack("<BHH", gesture, x, y))[0]
+
+    def click(self, x, y):
+        return self.touch(TOUCH_CLICK, x, y)
+
+    def path(self):
+        """(selected token, [titles from main menu])"""
+        status, data, _ = self.call(PATH)
+        depth, token = data[0], data[1]
+        titles = data[2:].decode("latin-1").split("/") if depth else []
+        return token, titles
+
+    def dump(self, x1, y1, x2, y2):
+        """Rows of RGB565 pixels from display memory."""
+        status, data, rows = self.call(DUMP, struct.pack("<HHHH", x1, y1, x2, y2))
+        if status == BUSY:
+            raise RemoteError("dump already running")
+        result = []
+        for _, row in rows:
+            result.append(list(struct.unpack(">%dH" % ((len(row) - 2) // 2), row[2:])))
+        return result
+
+    def stream(self, enable=True, period=0):
+        """Start (first frame is whole screen) or stop screen streaming, period in ms (0 for default)."""
+        self.call(STREAM, struct.pack("<BH", 1 if enable else 0, period))
+
+    def screen_frame(self, wait=True):
+        """Next streamed frame: ([(x1, y1, x2, y2, pixels)], (scroll top, height, line)).
+        Without wait returns None if whole frame has not arrived yet."""
+        if not wait:
+            self.poll()
+            if not any(status == OK for status, _ in self.screen):
+                return None
+        rects = []
+        while True:
+            while not self.screen:
+                self._receive()
+            status, data = self.screen.pop(0)
+            if status == OK:
+                return rects, struct.unpack("<HHH", data[:6])
+            x1, y1, x2, y2 = struct.unpack("<HHHH", data[:8])
+            rects.append((x1, y1, x2, y2, rle_decode(data[8:])))
+
+    def log_words(self):
+        """Next log message as list of 32-bit words (see Tools/log_decode.py)."""
+        while not self.log:
+            self._receive()
+        data = self.log.pop(0)
+        return list(struct.unpack("<%dI" % (len(data) // 4), data))
+
+    def interactive(self, enable=True):
+        """Give USART back to key bytes and echo (enable) or keep it binary."""
+        self.call(MODE, bytes([1 if enable else 0]))
+
+    def shell(self):
+        """Give USART to text shell (Menu/menu_shell.h), next frame makes it binary again."""
+        self.call(MODE, bytes([2]))
+
+
+def save_ppm(rows, name):
+    with open(name, "wb") as f:
+        f.write(b"P6 %d %d 255\n" % (len(rows[0]), len(rows)))
+        for row in rows:
+            for p in row:
+                f.write(bytes([(p >> 8) & 0xF8, (p >> 3) & 0xFC, (p << 3) & 0xF8]))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("usage: menu_remote.py PORT ping|path|keys KEYS|dump FILE.ppm [x1 y1 x2 y2]")
+        sys.exit(1)
+    remote = MenuRemote(sys.argv[1])
+    command = sys.argv[2]
+    if command == "ping":
+        print("version %d, screen %dx%d" % remote.ping())
+    elif command == "path":
+        token, titles = remote.path()
+        print("/".join(titles), "selected", token)
+    elif command == "keys":
+        remote.keys(sys.argv[3])
+    elif command == "dump":
+        width, height = remote.ping()[1:]
+        area = [int(a) for a in sys.argv[4:8]] or [0, 0, width - 1, height - 1]
+        save_ppm(remote.dump(*area), sys.argv[3])
+    remote.close()
@@ -0,0 +1,102 @@
+"""Shows screen stream (Menu/menu_stream.h) from device in a window.
+
+    python menu_viewer.py /dev/ttyUSB0 [period ms] [scale]
+
+Changed rectangles are written in copy of display memory, hardware
+scrolling is applied when picture is shown. Keys pressed in the window
+are sent to the menu (w, a, s, d, Enter, Esc...), mouse click is touch.
+"""
+
+import sys
+
+try:
+    import tkinter
+except ImportError:
+    import Tkinter as tkinter
+
+import menu_remote
+
+POLL = 10  # ms between checks for new frame
+
+class Viewer(object):
+    def __init__(self, remote, period, scale):
+        self.remote = remote
+        self.scale = scale
+        version, self.width, self.height = remote.ping()
+        self.memory = [[0] * self.width for _ in range(self.height)]
+        self.scroll = (0, self.height, 0)
+        self.frames = 0
+
+        self.root = tkinter.Tk()
+        self.root.title("Menu viewer")
+        self.image = tkinter.PhotoImage(width=self.width, height=self.height)
+        self.shown = self.image.zoom(scale) if scale > 1 else self.image
+        self.label = tkinter.Label(self.root, image=self.shown)
+        self.label.pack()
+        self.status = tkinter.Label(self.root, anchor="w")
+        self.status.pack(fill="x")
+        self.root.bind("<Key>", self.key)
+        self.label.bind("<Button-1>", self.click)
+
+        remote.stream(True, period)
+        self.root.after(1, self.update)
+
+    def key(self, event):
+        if event.char:
+            self.remote.send(menu_remote.KEY, event.char.encode("latin-1"))
+
+    def click(self, event):
+        self.remote.send(menu_remote.TOUCH, menu_remote.struct.pack(
+            "<BHH", menu_remote.TOUCH_CLICK, event.x // self.scale, event.y // self.scale))
+
+    def memory_row(self, y):
+        top, height, line = self.scroll
+        if top <= y < top + height:
+            return top + (y - top + line - top) % height
+        return y
+
+    def update(self):
+        # Serial is only polled, window is not blocked while screen does not change
+        try:
+            frame = self.remote.screen_frame(wait=False)
+            self.remote.replies.clear()  # Replies to keys and clicks are not needed
+            if frame is not None:
+                self.show(frame)
+        finally:
+            self.root.after(POLL, self.update)
+
+    def show(self, frame):
+        rects, self.scroll = frame
+        area = 0
+        for x1, y1, x2, y2, pixels in rects:
+            width = x2 - x1 + 1
+            for row in range(y2 - y1 + 1):
+                self.memory[y1 + row][x1:x2 + 1] = pixels[row * width:(row + 1) * width]
+            area += width * (y2 - y1 + 1)
+        self.frames += 1
+
+        rows = []
+        for y in range(self.height):
+            row = self.memory[self.memory_row(y)]
+            rows.append("{" + " ".join("#%02x%02x%02x" % ((p >> 8) & 0xF8, (p >> 3) & 0xFC, (p << 3) & 0xF8) for p in row) + "}")
+        self.image.put(" ".join(rows))
+        if self.scale > 1:
+            self.shown = self.image.zoom(self.scale)
+            self.label.configure(image=self.shown)
+        self.status.configure(text="frame %d, %d pixels changed, %d errors" % (self.frames, area, self.remote.errors))
+
+    def run(self):
+        try:
+            self.root.mainloop()
+        finally:
+            self.remote.stream(False)
+            self.remote.close()
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: menu_viewer.py PORT [period ms] [scale]")
+        sys.exit(1)
+    period = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+    scale = int(sys.argv[3]) if len(sys.argv) > 3 else 2
+    Viewer(menu_remote.MenuRemote(sys.argv[1]), period, scale).run()
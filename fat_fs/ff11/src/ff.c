@@ -3265,6 +3265,41 @@ FRESULT f_readdir (
 
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Move Read Index of Directory                                          */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_seekdir (
+	DIR* dp,			/* Pointer to the open directory object */
+	WORD idx			/* Index of directory table, next f_readdir reads the first item at or after it */
+)
+{
+	FRESULT res;
+	UINT ic;
+
+
+	res = validate(dp);						/* Check validity of the object */
+	if (res == FR_OK) {
+		ic = SS(dp->fs) / SZ_DIRE * dp->fs->csize;	/* Entries per cluster */
+		if (dp->sect && dp->clust >= 2 && idx / ic == dp->index / ic) {	/* In current cluster, chain is not followed */
+			dp->index = idx;
+			dp->sect = clust2sect(dp->fs, dp->clust) + idx % ic / (SS(dp->fs) / SZ_DIRE);
+			dp->dir = dp->fs->win + (idx % (SS(dp->fs) / SZ_DIRE)) * SZ_DIRE;
+		} else {
+			res = dir_sdi(dp, idx);
+		}
+	}
+	if (res == FR_INT_ERR) {				/* Index is out of the table */
+		dp->sect = 0;
+		res = FR_OK;
+	}
+
+	LEAVE_FF(dp->fs, res);
+}
+
+
+
 #if _USE_FIND
 /*-----------------------------------------------------------------------*/
 /* Find next file                                                        */